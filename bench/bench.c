@@ -0,0 +1,485 @@
+/**
+* @file bench.c
+ * @brief 前端 + 编辑距离的基准测试：生成参数化语料，分阶段计时，输出 JSON。
+ *
+ * 语料：文件 A 由若干随机函数组成（嵌套深度、目标大小可调），文件 B 逐函数对应 A：
+ * 按 --clone 比例原样克隆（只改空白与变量名），其余函数做随机变异（改运算符、增删语句）。
+ *
+ * 各阶段分别计时（重复 --reps 次取最短）：
+ *   tokenize   tokenize_to_array_n
+ *   parse      ast_parse_token_array（区域分配）
+ *   serialize  ast_serialize_symbols
+ *   pipeline   pipeline_build_symbols（流式前端，生产路径）
+ *   distance   dp / bitpar / wavefront 三种引擎，以及基线 levenshtein_strvec
+ *   weighted   加权编辑距离（--costs=kind 模型）：逐行标量 DP 与反对角线向量化内核
+ *
+ * 输出一行 JSON（吞吐：MB/s、tokens/s、cells/s；峰值 RSS），便于跨版本比较回归。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "ast.h"
+#include "ast_parser.h"
+#include "ast_serial.h"
+#include "edit_distance.c.h"
+#include "edit_cost.h"
+#include "tokenizer.h"
+#include "pipeline.h"
+#include "symtab.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <sys/resource.h>
+#endif
+
+// ========== 计时与内存 ==========
+
+// 单调时钟（秒）
+static double now_sec(void) {
+#ifdef _WIN32
+    LARGE_INTEGER f, c;
+    QueryPerformanceFrequency(&f);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart / (double)f.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+// 进程峰值常驻内存（KiB）；无法获取时为 0
+static long peak_rss_kb(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return (long)(pmc.PeakWorkingSetSize / 1024);
+    return 0;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1024;     // macOS 以字节为单位
+#else
+    return ru.ru_maxrss;
+#endif
+#endif
+}
+
+// ========== 可复现的伪随机数（与 tests/test_edit_distance.c 相同的 LCG） ==========
+
+typedef struct { unsigned long long s; } Rng;
+
+static unsigned rng_next(Rng* r) {
+    r->s = r->s * 6364136223846793005ull + 1442695040888963407ull;
+    return (unsigned)(r->s >> 33);
+}
+
+static unsigned rng_below(Rng* r, unsigned n) { return n ? rng_next(r) % n : 0; }
+
+// [0,1) 均匀分布
+static double rng_unit(Rng* r) { return (double)rng_next(r) / 2147483648.0; }
+
+// ========== 源码缓冲 ==========
+
+typedef struct {
+    char*  data;
+    size_t size;
+    size_t cap;
+} Buf;
+
+static void buf_printf(Buf* b, const char* fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        const size_t room = b->cap - b->size;
+        const int n = vsnprintf(b->data ? b->data + b->size : NULL, room, fmt, ap);
+        va_end(ap);
+        if (n < 0) return;
+        if ((size_t)n < room) { b->size += (size_t)n; return; }
+        size_t nc = b->cap ? b->cap * 2 : 4096;
+        while (nc - b->size <= (size_t)n) nc *= 2;
+        char* p = (char*)realloc(b->data, nc);
+        if (!p) { fprintf(stderr, "out of memory\n"); exit(1); }
+        b->data = p;
+        b->cap = nc;
+    }
+}
+
+static void buf_indent(Buf* b, int level) {
+    for (int i = 0; i < level; i++) buf_printf(b, "    ");
+}
+
+// ========== 语料生成 ==========
+
+/**
+ * 生成上下文：结构随机数（A、B 共用同一序列，保证逐函数对应）+ 变异随机数（只影响 B）。
+ */
+typedef struct {
+    Rng    shape;       // 决定语句结构
+    Rng    mutate;      // 决定变异
+    bool   is_b;        // 正在生成 B
+    bool   mutating;    // 当前函数需要变异（仅 B）
+    int    max_depth;
+} Gen;
+
+static const char* const OPS[] = { "+", "-", "*", "/", "%", "&", "|", "^" };
+static const char* const CMPS[] = { "<", ">", "<=", ">=", "==", "!=" };
+
+// 变量名：B 中的克隆函数换一套名字（归一化后应与 A 相同）
+static void var_name(Gen* g, char* out, size_t cap, unsigned k) {
+    snprintf(out, cap, g->is_b ? "value_%u" : "v%u", k);
+}
+
+// 以概率 p 触发一次变异（仅 B 中需变异的函数）
+static bool mutation(Gen* g, double p) {
+    return g->is_b && g->mutating && rng_unit(&g->mutate) < p;
+}
+
+static void gen_block(Gen* g, Buf* b, int depth, int level);
+
+static void gen_statement(Gen* g, Buf* b, int depth, int level) {
+    // 结构随机数每次都按相同次数抽取，A、B 的后续结构才能保持对齐
+    const unsigned kind = rng_below(&g->shape, depth < g->max_depth ? 6 : 3);
+    const unsigned x = rng_below(&g->shape, 8), y = rng_below(&g->shape, 8);
+    const unsigned op = rng_below(&g->shape, 8), cmp = rng_below(&g->shape, 6);
+    const unsigned lit = rng_below(&g->shape, 1000);
+    char vx[32], vy[32];
+    var_name(g, vx, sizeof(vx), x);
+    var_name(g, vy, sizeof(vy), y);
+
+    // 删除语句：仍生成到临时缓冲中，使嵌套块消耗的结构随机数与 A 相同
+    Buf sink = { NULL, 0, 0 };
+    const bool dropped = mutation(g, 0.1);
+    if (dropped) b = &sink;
+    const char* o = mutation(g, 0.2) ? OPS[(op + 1) % 8] : OPS[op];  // 改运算符
+
+    buf_indent(b, level);
+    switch (kind) {
+        case 0:
+            buf_printf(b, "%s = %s %s %u;\n", vx, vy, o, lit);
+            break;
+        case 1:
+            buf_printf(b, "%s += helper(%s, %u);\n", vx, vy, lit);
+            break;
+        case 2:
+            buf_printf(b, "if (%s %s %u) return %s;\n", vx, CMPS[cmp], lit, vy);
+            break;
+        case 3:
+            buf_printf(b, "if (%s %s %s) ", vx, CMPS[cmp], vy);
+            gen_block(g, b, depth + 1, level);
+            break;
+        case 4:
+            buf_printf(b, "while (%s %s %u) ", vx, CMPS[cmp], lit);
+            gen_block(g, b, depth + 1, level);
+            break;
+        default:
+            buf_printf(b, "for (%s = 0; %s < %u; %s++) ", vx, vx, lit, vx);
+            gen_block(g, b, depth + 1, level);
+            break;
+    }
+    if (dropped) {
+        free(sink.data);
+        return;
+    }
+    if (mutation(g, 0.1)) {                                          // 插入语句
+        buf_indent(b, level);
+        buf_printf(b, "%s = %s %s 1;\n", vx, vx, OPS[rng_below(&g->mutate, 8)]);
+    }
+}
+
+static void gen_block(Gen* g, Buf* b, int depth, int level) {
+    buf_printf(b, "{\n");
+    const unsigned n = 2 + rng_below(&g->shape, 4);
+    for (unsigned i = 0; i < n; i++) gen_statement(g, b, depth, level + 1);
+    buf_indent(b, level);
+    buf_printf(b, "}\n");
+}
+
+static void gen_function(Gen* g, Buf* b, unsigned id) {
+    char v0[32], v1[32];
+    var_name(g, v0, sizeof(v0), 0);
+    var_name(g, v1, sizeof(v1), 1);
+    buf_printf(b, "int fn_%u(int %s, int %s) ", id, v0, v1);
+    gen_block(g, b, 0, 0);
+    buf_printf(b, g->is_b ? "\n\n" : "\n");
+}
+
+/**
+ * 生成一对语料：A 达到 target 字节为止，B 逐函数对应 A（clone 比例的函数不变异）。
+ */
+static void gen_corpus(size_t target, int depth, double clone, unsigned long long seed, Buf* a, Buf* b) {
+    Gen ga = { { seed }, { seed ^ 0x5bd1e995ull }, false, false, depth };
+    Gen gb = ga;
+    gb.is_b = true;
+    Rng pick = { seed * 31 + 7 };
+
+    for (unsigned id = 0; a->size < target; id++) {
+        gen_function(&ga, a, id);
+        gb.mutating = rng_unit(&pick) >= clone;
+        gen_function(&gb, b, id);
+    }
+}
+
+// ========== JSON 输出 ==========
+
+typedef struct {
+    Buf  out;
+    bool first;
+} Json;
+
+static void json_sep(Json* j) {
+    if (!j->first) buf_printf(&j->out, ",");
+    j->first = false;
+}
+
+static void stage_row(Json* j, const char* stage, const char* file, double sec, size_t bytes, size_t tokens) {
+    json_sep(j);
+    buf_printf(&j->out, "{\"stage\":\"%s\",\"file\":\"%s\",\"seconds\":%.6f,\"mb_per_s\":%.3f,\"tokens_per_s\":%.0f}",
+               stage, file, sec, sec > 0 ? (double)bytes / 1048576.0 / sec : 0.0,
+               sec > 0 ? (double)tokens / sec : 0.0);
+}
+
+static void distance_row(Json* j, const char* engine, size_t n, size_t m, double sec, size_t dist, bool ran) {
+    json_sep(j);
+    const double cells = (double)n * (double)m;
+    if (!ran) {
+        buf_printf(&j->out, "{\"stage\":\"distance\",\"engine\":\"%s\",\"cells\":%.0f,\"skipped\":true}", engine, cells);
+        return;
+    }
+    buf_printf(&j->out, "{\"stage\":\"distance\",\"engine\":\"%s\",\"cells\":%.0f,\"seconds\":%.6f,"
+               "\"cells_per_s\":%.0f,\"dist\":%zu}",
+               engine, cells, sec, sec > 0 ? cells / sec : 0.0, dist);
+}
+
+// ========== 各阶段 ==========
+
+/** 一个文件的前端产物与计时结果。 */
+typedef struct {
+    const char* name;
+    const Buf*  src;
+    size_t      tokens;
+    size_t      symbols;
+    double      t_tokenize, t_parse, t_serialize, t_pipeline;
+    SymVec      seq;        // 驻留在共享符号表中的序列（供距离阶段使用）
+    StrVec      strs;       // 字符串序列（基线 levenshtein_strvec 使用）
+} FileRun;
+
+static bool run_frontend(FileRun* f, SymTab* shared, int reps) {
+    f->t_tokenize = f->t_parse = f->t_serialize = f->t_pipeline = 1e300;
+    symv_init(&f->seq);
+    sv_init(&f->strs);
+
+    for (int r = 0; r < reps; r++) {
+        SymTab syms;
+        symtab_init(&syms);
+        TokenArray arr;
+        Arena arena;
+        arena_init(&arena, 0);
+        SymVec seq;
+        symv_init(&seq);
+
+        double t0 = now_sec();
+        bool ok = tokenize_to_array_n(f->src->data, f->src->size, &syms, &arr);
+        double t1 = now_sec();
+        ASTNode* root = ok ? ast_parse_token_array(&arr, &arena) : NULL;
+        double t2 = now_sec();
+        ok = root && ast_serialize_symbols(root, &syms, &seq);
+        double t3 = now_sec();
+
+        if (ok) {
+            if (t1 - t0 < f->t_tokenize) f->t_tokenize = t1 - t0;
+            if (t2 - t1 < f->t_parse) f->t_parse = t2 - t1;
+            if (t3 - t2 < f->t_serialize) f->t_serialize = t3 - t2;
+            f->tokens = arr.size;
+            f->symbols = seq.size;
+            if (r == reps - 1) {
+                sv_free(&f->strs);
+                ok = ast_serialize_preorder(root, &f->strs);
+            }
+            token_array_free(&arr);
+        }
+        symv_free(&seq);
+        arena_free(&arena);
+        symtab_free(&syms);
+        if (!ok) return false;
+
+        // 生产路径：流式前端，符号驻留到共享表中（两份文件的序列可直接比较）
+        SymVec s;
+        symv_init(&s);
+        t0 = now_sec();
+        ok = pipeline_build_symbols(f->src->data, f->src->size, shared, &s, NULL);
+        t1 = now_sec();
+        if (!ok) { symv_free(&s); return false; }
+        if (t1 - t0 < f->t_pipeline) f->t_pipeline = t1 - t0;
+        symv_free(&f->seq);
+        f->seq = s;
+    }
+    return true;
+}
+
+typedef size_t (*DistFn)(const FileRun* a, const FileRun* b);
+
+static size_t dist_dp(const FileRun* a, const FileRun* b)        { return levenshtein_symvec(&a->seq, &b->seq); }
+static size_t dist_bitpar(const FileRun* a, const FileRun* b)    { return levenshtein_symvec_myers(&a->seq, &b->seq); }
+static size_t dist_wavefront(const FileRun* a, const FileRun* b) { return levenshtein_symvec_wavefront(&a->seq, &b->seq, 0); }
+static size_t dist_strvec(const FileRun* a, const FileRun* b)    { return levenshtein_strvec(&a->strs, &b->strs); }
+
+// 加权距离使用的代价表（绑定到共享符号表）
+static EditCosts bench_costs;
+static size_t dist_weighted_dp(const FileRun* a, const FileRun* b) { return edit_distance_weighted_dp(&bench_costs, &a->seq, &b->seq); }
+static size_t dist_weighted(const FileRun* a, const FileRun* b)    { return edit_distance_weighted(&bench_costs, &a->seq, &b->seq); }
+
+static double time_distance(DistFn fn, const FileRun* a, const FileRun* b, int reps, size_t* dist) {
+    double best = 1e300;
+    for (int r = 0; r < reps; r++) {
+        const double t0 = now_sec();
+        *dist = fn(a, b);
+        const double t = now_sec() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+// ========== 入口 ==========
+
+static void usage(const char* prog) {
+    printf("用法: %s [选项]\n", prog);
+    printf("  --size=BYTES       文件 A 的目标大小 (默认 262144)\n");
+    printf("  --depth=N          控制结构最大嵌套深度 (默认 4)\n");
+    printf("  --clone=F          B 中原样克隆的函数比例 0~1, 其余函数随机变异 (默认 0.5)\n");
+    printf("  --seed=N           随机种子 (默认 1)\n");
+    printf("  --reps=N           每个阶段重复次数, 取最短时间 (默认 3)\n");
+    printf("  --max-dp-cells=N   dp 与 strvec 基线的 DP 单元上限, 超出则跳过 (默认 4e9)\n");
+    printf("  --dump=PREFIX      另存生成的语料为 PREFIX_a.c / PREFIX_b.c\n");
+}
+
+int main(int argc, char* argv[]) {
+    size_t size = 262144;
+    int depth = 4;
+    double clone = 0.5;
+    unsigned long long seed = 1;
+    int reps = 3;
+    double max_dp_cells = 4e9;
+    const char* dump = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--size=", 7) == 0) size = (size_t)strtoull(argv[i] + 7, NULL, 10);
+        else if (strncmp(argv[i], "--depth=", 8) == 0) depth = atoi(argv[i] + 8);
+        else if (strncmp(argv[i], "--clone=", 8) == 0) clone = atof(argv[i] + 8);
+        else if (strncmp(argv[i], "--seed=", 7) == 0) seed = strtoull(argv[i] + 7, NULL, 10);
+        else if (strncmp(argv[i], "--reps=", 7) == 0) reps = atoi(argv[i] + 7);
+        else if (strncmp(argv[i], "--max-dp-cells=", 15) == 0) max_dp_cells = atof(argv[i] + 15);
+        else if (strncmp(argv[i], "--dump=", 7) == 0) dump = argv[i] + 7;
+        else { usage(argv[0]); return 1; }
+    }
+    if (reps < 1) reps = 1;
+    if (depth < 0) depth = 0;
+
+    // 1) 生成语料
+    Buf a = { NULL, 0, 0 }, b = { NULL, 0, 0 };
+    const double tg = now_sec();
+    gen_corpus(size, depth, clone, seed, &a, &b);
+    const double t_gen = now_sec() - tg;
+
+    if (dump) {
+        char path[1024];
+        snprintf(path, sizeof(path), "%s_a.c", dump);
+        FILE* fa = fopen(path, "wb");
+        if (fa) { fwrite(a.data, 1, a.size, fa); fclose(fa); }
+        snprintf(path, sizeof(path), "%s_b.c", dump);
+        FILE* fb = fopen(path, "wb");
+        if (fb) { fwrite(b.data, 1, b.size, fb); fclose(fb); }
+    }
+
+    // 2) 前端各阶段
+    SymTab shared;
+    symtab_init(&shared);
+    FileRun fa = { "A", &a, 0, 0, 0, 0, 0, 0, { NULL, 0, 0 }, { NULL, 0, 0 } };
+    FileRun fb = { "B", &b, 0, 0, 0, 0, 0, 0, { NULL, 0, 0 }, { NULL, 0, 0 } };
+    if (!run_frontend(&fa, &shared, reps) || !run_frontend(&fb, &shared, reps)) {
+        fprintf(stderr, "front end failed\n");
+        return 1;
+    }
+
+    Json j = { { NULL, 0, 0 }, true };
+    buf_printf(&j.out, "{\"bench\":\"pipeline\",\"params\":{\"size\":%zu,\"depth\":%d,\"clone\":%.3f,"
+               "\"seed\":%llu,\"reps\":%d},\"generate_seconds\":%.6f,\"files\":[",
+               size, depth, clone, seed, reps, t_gen);
+    const FileRun* runs[2] = { &fa, &fb };
+    for (int k = 0; k < 2; k++) {
+        buf_printf(&j.out, "%s{\"file\":\"%s\",\"bytes\":%zu,\"tokens\":%zu,\"symbols\":%zu}",
+                   k ? "," : "", runs[k]->name, runs[k]->src->size, runs[k]->tokens, runs[k]->symbols);
+    }
+    buf_printf(&j.out, "],\"stages\":[");
+    for (int k = 0; k < 2; k++) {
+        const FileRun* f = runs[k];
+        stage_row(&j, "tokenize", f->name, f->t_tokenize, f->src->size, f->tokens);
+        stage_row(&j, "parse", f->name, f->t_parse, f->src->size, f->tokens);
+        stage_row(&j, "serialize", f->name, f->t_serialize, f->src->size, f->tokens);
+        stage_row(&j, "pipeline", f->name, f->t_pipeline, f->src->size, f->tokens);
+    }
+
+    // 3) 距离阶段：各引擎结果必须一致
+    const size_t n = fa.seq.size, m = fb.seq.size;
+    const bool small = (double)n * (double)m <= max_dp_cells;
+    struct { const char* name; DistFn fn; bool run; } engines[] = {
+        { "strvec",    dist_strvec,    small },     // 基线：逐单元 strcmp
+        { "dp",        dist_dp,        small },
+        { "bitpar",    dist_bitpar,    true  },
+        { "wavefront", dist_wavefront, true  },
+    };
+    bool consistent = true;
+    size_t ref = (size_t)-1;
+    for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]); e++) {
+        size_t d = 0;
+        double t = 0;
+        if (engines[e].run) {
+            t = time_distance(engines[e].fn, &fa, &fb, reps, &d);
+            if (ref == (size_t)-1) ref = d;
+            else if (d != ref) consistent = false;
+        }
+        distance_row(&j, engines[e].name, n, m, t, d, engines[e].run);
+    }
+
+    // 加权距离：两种实现结果必须一致
+    EditCostModel model;
+    edit_cost_kind_preset(&model);
+    if (!edit_costs_bind(&bench_costs, &model, &shared)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    struct { const char* name; DistFn fn; bool run; } weighted[] = {
+        { "weighted_dp", dist_weighted_dp, small },
+        { "weighted",    dist_weighted,    small },
+    };
+    size_t wref = (size_t)-1;
+    for (size_t e = 0; e < sizeof(weighted) / sizeof(weighted[0]); e++) {
+        size_t d = 0;
+        double t = 0;
+        if (weighted[e].run) {
+            t = time_distance(weighted[e].fn, &fa, &fb, reps, &d);
+            if (wref == (size_t)-1) wref = d;
+            else if (d != wref) consistent = false;
+        }
+        distance_row(&j, weighted[e].name, n, m, t, d, weighted[e].run);
+    }
+    edit_costs_free(&bench_costs);
+
+    buf_printf(&j.out, "],\"similarity\":%.6f,\"consistent\":%s,\"peak_rss_kb\":%ld}\n",
+               similarity_from_dist(ref, n, m), consistent ? "true" : "false", peak_rss_kb());
+    fwrite(j.out.data, 1, j.out.size, stdout);
+
+    free(j.out.data);
+    symv_free(&fa.seq); symv_free(&fb.seq);
+    sv_free(&fa.strs); sv_free(&fb.strs);
+    symtab_free(&shared);
+    free(a.data);
+    free(b.data);
+    return consistent ? 0 : 2;
+}
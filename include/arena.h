@@ -0,0 +1,43 @@
+/**
+* @file arena.h
+ * @brief 区域（bump）分配器：一次解析的全部小对象集中分配、一次性释放。
+ *
+ * 适用于生命周期相同的大量小对象（AST 节点、节点文本、子节点数组、符号名称等），
+ * 分配只是指针前移，释放时按块整体归还，不再逐对象 free。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_ARENA_H
+#define COURSEDESIGNTASKS_ARENA_H
+
+#include <stddef.h>
+
+/** @brief 区域内存块（内部使用）。 */
+typedef struct ArenaBlock ArenaBlock;
+
+/**
+ * @brief 区域分配器。
+ *
+ * 非线程安全：每个线程/每次解析应使用各自的 Arena。
+ */
+typedef struct Arena {
+    ArenaBlock* head;       // 当前块（链表头）
+    size_t block_size;      // 新块的默认大小
+    size_t reserved;        // 已向系统申请的总字节数
+} Arena;
+
+/** @brief 初始化区域；block_size 为 0 时使用默认大小（64 KiB）。 */
+void   arena_init(Arena* a, size_t block_size);
+/** @brief 分配 size 字节（按 16 字节对齐）；内存不足返回 NULL。 */
+void*  arena_alloc(Arena* a, size_t size);
+/** @brief 在区域中复制长度为 len 的字符串片段并补 '\0'。 */
+char*  arena_strndup(Arena* a, const char* s, size_t len);
+/** @brief 在区域中复制以 '\0' 结尾的字符串；s 为 NULL 返回 NULL。 */
+char*  arena_strdup(Arena* a, const char* s);
+/** @brief 作废区域中的全部对象，但保留一个标准块供后续分配复用（流式解析逐段回收）。 */
+void   arena_reset(Arena* a);
+/** @brief 一次性释放区域中的全部内存（之后可重新使用）。 */
+void   arena_free(Arena* a);
+
+#endif //COURSEDESIGNTASKS_ARENA_H
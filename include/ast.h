@@ -15,6 +15,8 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
 
 /**
  * @brief AST 节点类别（用于描述语法结构类型）。
@@ -42,14 +44,19 @@ typedef enum {
 
     AST_STMT,   // 普通语句
     AST_EXPR,   // 括号表达式 or case 表达式
-    AST_TOKEN   // 叶子：保存一个 token 的“标签”
+    AST_TOKEN,  // 叶子：保存一个 token 的“标签”
+
+    AST_KIND_COUNT  // 类别数量（非节点类别，用于按类别建表）
 } ASTKind;
 
 /**
  * @brief AST 节点结构。
  *
  * children 为动态数组，child_count 为当前子节点数，child_cap 为容量。
- * 所有权：节点及其 children/text 均由 AST 模块管理，使用 ast_free 递归释放。
+ * 所有权：
+ * - arena 为 NULL：节点及其 children/text 均在堆上，使用 ast_free 递归释放；
+ * - arena 非 NULL：节点、text 与 children 数组都在该区域中，由 arena_free 一次性释放，
+ *   ast_free 对其为空操作。同一棵树的节点必须来自同一种分配方式。
  */
 typedef struct ASTNode {
     ASTKind kind;
@@ -57,10 +64,16 @@ typedef struct ASTNode {
     struct ASTNode** children;
     size_t child_count;
     size_t child_cap;
+    Arena* arena;
+    uint64_t hash;      // 子树结构哈希（ast_merkle 计算，之前为 0）
+    int line, col;      // 起始 token 在源码中的位置（1 起；0 表示未知）
+    size_t serial_len;  // 子树序列化长度的上界（解析器填写于根/顶层节点，供序列化预留容量；0 表示未知）
 } ASTNode;
 
 /** @brief 创建 AST 节点（见 ast.c 具体说明）。 */
 ASTNode* ast_new(ASTKind kind, const char* text);
+/** @brief 在区域 arena 中创建节点；arena 为 NULL 时等同 ast_new。 */
+ASTNode* ast_new_in(Arena* arena, ASTKind kind, const char* text);
 /** @brief 追加子节点（见 ast.c 具体说明）。 */
 bool     ast_add_child(ASTNode* parent, ASTNode* child);
 /** @brief 释放整棵树（见 ast.c 具体说明）。 */
@@ -21,4 +21,49 @@
  */
 ASTNode* ast_parse_tokens(Token* const* toks, size_t ntoks);
 
+/**
+ * @brief 同 ast_parse_tokens，但整棵 AST 分配在区域 arena 中。
+ *
+ * @param arena 区域分配器；为 NULL 时等同 ast_parse_tokens。
+ * @return AST 根节点（随 arena_free 一并释放）。
+ */
+ASTNode* ast_parse_tokens_arena(Token* const* toks, size_t ntoks, Arena* arena);
+
+/**
+ * @brief 解析 tokenize_to_array 产生的紧凑 token 数组（零拷贝路径）。
+ *
+ * @param arr   token 数组；TokenRef.lex 在 arr->lexes 中反查。
+ * @param arena 区域分配器；可为 NULL。
+ * @return AST 根节点；失败返回 NULL。
+ */
+ASTNode* ast_parse_token_array(const TokenArray* arr, Arena* arena);
+
+/**
+ * @brief 流式解析的 token 来源：每次产出一个 token，到达末尾时产出 TOKEN_EOF。
+ *
+ * @return 成功返回 true；出错（如内存不足）返回 false。
+ */
+typedef bool (*TokenPullFn)(void* ctx, TokenRef* out);
+
+/**
+ * @brief 流式解析的顶层节点回调：node 仅在回调期间有效。
+ *
+ * @return 继续解析返回 true；返回 false 时终止解析。
+ */
+typedef bool (*AstTopLevelFn)(void* ctx, ASTNode* node);
+
+/**
+ * @brief 流式解析：不物化完整 token 数组与整棵 AST。
+ *
+ * 依次回调的顶层节点与 ast_parse_token_array 结果中 AST_PROGRAM 的子节点完全相同。
+ *
+ * @param pull   token 来源（pull_ctx 为其上下文）。
+ * @param lexes  token lex ID 所属的符号表。
+ * @param arena  顶层子树的分配区域（每个节点回调后重置）；可为 NULL。
+ * @param emit   顶层节点回调（emit_ctx 为其上下文）。
+ * @return 成功返回 true。
+ */
+bool ast_parse_stream(TokenPullFn pull, void* pull_ctx, const SymTab* lexes, Arena* arena,
+                      AstTopLevelFn emit, void* emit_ctx);
+
 #endif //COURSEDESIGNTASKS_AST_PARSER_H
\ No newline at end of file
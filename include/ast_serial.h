@@ -9,8 +9,10 @@
 #define COURSEDESIGNTASKS_AST_SERIAL_H
 
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include "ast.h"
+#include "symtab.h"
 
 /**
  * @brief 简单的字符串向量（动态数组）。
@@ -29,4 +31,50 @@ void  sv_free(StrVec* v);
 
 bool  ast_serialize_preorder(const ASTNode* root, StrVec* out);
 
+/**
+ * @brief 与 ast_serialize_preorder 输出相同的序列，但元素驻留为符号 ID。
+ *
+ * @param root 根节点。
+ * @param syms 符号表（需比较的多条序列必须共用同一张表）。
+ * @param out  输出序列（需已初始化；结果追加在末尾）。
+ */
+bool  ast_serialize_symbols(const ASTNode* root, SymTab* syms, SymVec* out);
+
+/**
+ * @brief 与符号序列逐项对应的源码行号（data[i] 为第 i 个符号所属的行）。
+ *
+ * 进入标签取节点起始 token 的行，叶子取其 token 的行，退出标签沿用前一项的行，
+ * 因此整条序列的行号单调不减，任意一段符号区间都可映射为一段源码行区间。
+ */
+typedef struct {
+    uint32_t* data;
+    size_t    size;
+    size_t    cap;
+} LineVec;
+
+void  linev_init(LineVec* v);
+bool  linev_reserve(LineVec* v, size_t cap);
+bool  linev_push(LineVec* v, uint32_t line);
+void  linev_free(LineVec* v);
+
+/**
+ * @brief 符号序列化上下文：每种 ASTKind 的进/出标签只驻留一次。
+ *
+ * 供流式解析逐个序列化顶层子树：先 sym_emit_open(AST_PROGRAM)，
+ * 对每个顶层节点 sym_emit_node，最后 sym_emit_close(AST_PROGRAM)，
+ * 结果与对整棵树调用 ast_serialize_symbols 完全相同。
+ */
+typedef struct {
+    SymTab* syms;
+    SymVec* out;
+    LineVec* lines;     // 可选：非 NULL 时同步记录每个符号的行号（sym_emitter_init 置 NULL）
+    SymId open_tag[AST_KIND_COUNT];
+    SymId close_tag[AST_KIND_COUNT];
+} SymEmitter;
+
+bool  sym_emitter_init(SymEmitter* em, SymTab* syms, SymVec* out);
+bool  sym_emit_node(SymEmitter* em, const ASTNode* n);
+bool  sym_emit_open(SymEmitter* em, ASTKind kind);
+bool  sym_emit_close(SymEmitter* em, ASTKind kind);
+
 #endif //COURSEDESIGNTASKS_AST_SERIAL_H
\ No newline at end of file
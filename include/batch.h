@@ -0,0 +1,103 @@
+/**
+* @file batch.h
+ * @brief 多对多批量比较：一次前端处理，缓存序列后两两比较。
+ *
+ * 对 N 份提交，每个文件只执行一次 tokenize -> parse -> serialize，
+ * 之后所有 N·(N-1)/2 对比较都复用缓存的符号序列。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_BATCH_H
+#define COURSEDESIGNTASKS_BATCH_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "symtab.h"
+#include "edit_distance.c.h"
+#include "edit_cost.h"
+#include "seqcache.h"
+
+/**
+ * @brief 批量模式中的单个文件及其缓存序列。
+ */
+typedef struct {
+    char*  path;
+    SymVec seq;
+    bool   ok;      // 前端处理是否成功（失败的文件不参与比较）
+} BatchFile;
+
+/**
+ * @brief 批量语料：文件列表 + 共用的符号表。
+ */
+typedef struct {
+    BatchFile* files;
+    size_t     count;
+    size_t     cap;
+    SymTab     syms;
+} BatchCorpus;
+
+/**
+ * @brief 批量比较参数。
+ */
+typedef struct {
+    EditEngine engine;
+    double     min_sim;     // 相似度下限；> 0 时低于下限的文件对只做带上界的计算
+    int        jobs;        // 并行线程数；<= 0 表示使用 CPU 核数，1 表示串行
+    double     prefilter;   // 指纹重合度下限；> 0 时只有 Winnowing 预筛选出的候选对做精确比较
+    const EditCostModel* costs; // 非 NULL 时使用加权编辑距离（dist 以代价计，不做长度界与带上界的剪枝）
+} BatchOptions;
+
+/**
+ * @brief 一对文件的比较结果。
+ */
+typedef struct {
+    size_t a, b;    // 文件下标（a < b）
+    size_t dist;    // 编辑距离；below 为 true 时为下界
+    double sim;     // 相似度；below 为 true 时为上界（必小于 min_sim）
+    bool   below;   // 相似度低于 min_sim，未精确计算
+} BatchPair;
+
+void   batch_init(BatchCorpus* c);
+void   batch_free(BatchCorpus* c);
+bool   batch_add_path(BatchCorpus* c, const char* path);
+bool   batch_collect(BatchCorpus* c, const char* dir_or_list);
+/**
+ * @brief 前端处理全部文件；cache 非 NULL 时先查磁盘缓存。返回成功文件数。
+ *
+ * jobs 为线程数（<= 0 为 CPU 核数，1 为串行）；多线程时各线程使用私有符号表，
+ * 结束后按文件顺序确定地合并到 c->syms。
+ */
+size_t batch_load(BatchCorpus* c, SeqCache* cache, int jobs);
+
+void   batch_compare_pair(const BatchCorpus* c, const BatchOptions* opt,
+                          size_t a, size_t b, BatchPair* out);
+/** @brief 并行计算全部（或预筛后的候选）文件对；输出顺序固定为 (a, b) 字典序，与线程数无关。 */
+BatchPair* batch_compare_all(const BatchCorpus* c, const BatchOptions* opt, size_t* npairs);
+void   batch_sort_pairs(BatchPair* pairs, size_t n);
+/**
+ * @brief 只求最可疑的 k 对：按序列长度上界从高到低枚举文件对，上界不可能进入前 k 名时停止，
+ *        计算时的距离上界随第 k 名的相似度收紧（不做指纹预筛）。
+ *
+ * 结果与 batch_compare_all + batch_sort_pairs 的前 k 个（below 为 false 的）相同，与线程数无关；
+ * opt->costs 非 NULL 时长度界不成立，直接取全量比较的前 k 个。
+ *
+ * @param npairs   输出结果数（<= k）。
+ * @param computed 可选：输出实际计算了编辑距离的文件对数。
+ * @return 按“最可疑优先”排好序的结果（调用方 free）；失败返回 NULL。
+ */
+BatchPair* batch_top_pairs(const BatchCorpus* c, const BatchOptions* opt, size_t k,
+                           size_t* npairs, size_t* computed);
+
+/**
+ * @brief 查询序列与语料各文件中最相似的 k 个（长度界剪枝同 batch_top_pairs）。
+ *
+ * query 的符号须属于 c->syms。结果的 a 为语料文件下标（b 恒为 0），按“最可疑优先”排序。
+ * 只支持单位代价（opt->costs 须为 NULL）。
+ *
+ * @param skip 可选：skip[i] 为 true 的文件不参与比较（如查询文件自身的旧版本）。
+ */
+BatchPair* batch_top_matches(const BatchCorpus* c, const BatchOptions* opt, const SymVec* query,
+                             const bool* skip, size_t k, size_t* npairs, size_t* computed);
+
+#endif //COURSEDESIGNTASKS_BATCH_H
@@ -0,0 +1,70 @@
+/**
+* @file edit_align.h
+ * @brief 线性空间的序列对齐：Hirschberg 分治求编辑脚本，并映射回源码行区间。
+ *
+ * edit_distance 只给出距离；这里在同样的代价模型（插入/删除/替换各记 1）下
+ * 还原一条最优编辑路径，表示为相同/替换/插入/删除的连续段。
+ * 每层只保留两条 DP 列（较短序列的长度 + 1），内存为 O(min(n, m))。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_EDIT_ALIGN_H
+#define COURSEDESIGNTASKS_EDIT_ALIGN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "symtab.h"
+#include "ast_serial.h"
+
+/** @brief 编辑操作类别。 */
+typedef enum {
+    EDIT_EQUAL = 0,     // A、B 对应符号相同
+    EDIT_SUBST,         // A 的符号替换为 B 的符号
+    EDIT_INSERT,        // 插入 B 的符号（A 侧长度为 0）
+    EDIT_DELETE         // 删除 A 的符号（B 侧长度为 0）
+} EditOp;
+
+/**
+ * @brief 编辑脚本中的一段：同一操作作用于 A[a_begin, a_begin + a_len) 与 B[b_begin, b_begin + b_len)。
+ *
+ * EQUAL/SUBST 段两侧长度相等；INSERT 段 a_len 为 0，DELETE 段 b_len 为 0（begin 为插入/删除位置）。
+ */
+typedef struct {
+    EditOp op;
+    size_t a_begin, a_len;
+    size_t b_begin, b_len;
+} EditRun;
+
+/**
+ * @brief 编辑脚本：按序列顺序排列、相邻同类操作已合并的段；dist 为脚本总代价（即编辑距离）。
+ */
+typedef struct {
+    EditRun* data;
+    size_t   size;
+    size_t   cap;
+    size_t   dist;
+} EditScript;
+
+void edit_script_init(EditScript* s);
+void edit_script_free(EditScript* s);
+
+/**
+ * @brief 求 A -> B 的一条最优编辑脚本（Hirschberg 分治，位并行求中间列）。
+ *
+ * @param a   序列 A。
+ * @param b   序列 B。
+ * @param out 输出脚本（需已初始化；原有内容被清空）。
+ * @return 成功返回 true；内存不足返回 false。
+ */
+bool edit_align(const SymVec* a, const SymVec* b, EditScript* out);
+
+/**
+ * @brief 把符号区间 [begin, begin + len) 映射为源码行区间 [*first, *last]。
+ *
+ * len 为 0 时（插入/删除的对侧）取插入位置前一个符号所在的行；lines 为空时两者记 0。
+ */
+void edit_span_lines(const LineVec* lines, size_t begin, size_t len, uint32_t* first, uint32_t* last);
+
+#endif //COURSEDESIGNTASKS_EDIT_ALIGN_H
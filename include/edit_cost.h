@@ -0,0 +1,115 @@
+/**
+* @file edit_cost.h
+ * @brief 加权编辑距离：按 ASTKind 与叶子类别配置的替换 / 插入删除代价（--costs）。
+ *
+ * 每个符号归入一个类别：<KIND> 进标签、</KIND> 出标签，或叶子类别 @ID（标识符）、@NUM、@STR、@CHR、
+ * @KW（关键字标签）、@OP（运算符与分隔符）。代价只依赖类别：
+ * - 相同符号的替换代价恒为 0；不同符号替换的代价为 sub[类别 a][类别 b]（对称）；
+ * - 插入或删除一个符号的代价为 indel[类别]。
+ * 代价为 0~EDIT_COST_MAX 的整数；单位代价的默认模型取 2，便于表达“半价”的替换。
+ *
+ * 代价文件每行一条规则（'#' 之后为注释），名称为 ASTKind 名（FOR 表示 <FOR>）、'/' 加 ASTKind 名
+ * （/FOR 表示 </FOR>）或叶子类别（@NUM 等）；ASTKind 名与叶子类别名都可写作通配 *（如 '/' 后接 * 表示全部出标签）：
+ *   default SUB INDEL   全部类别的替换与插入删除代价（通常写在最前面）
+ *   sub A B COST        A、B 两组类别之间的替换代价（两个方向）
+ *   indel A COST        插入或删除 A 的代价
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_EDIT_COST_H
+#define COURSEDESIGNTASKS_EDIT_COST_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ast.h"
+#include "symtab.h"
+
+/** @brief 叶子符号的类别。 */
+typedef enum {
+    EC_LEAF_ID = 0,     // 标识符（var_N / id_K 等）
+    EC_LEAF_NUM,
+    EC_LEAF_STR,
+    EC_LEAF_CHR,
+    EC_LEAF_KW,         // 关键字标签（IF / FOR / KW 等）
+    EC_LEAF_OP,         // 运算符与分隔符
+    EC_LEAF_COUNT
+} EditLeafClass;
+
+/** @brief 类别总数：进标签、出标签、叶子类别依次编号。 */
+#define EC_CLASS_COUNT (2 * AST_KIND_COUNT + EC_LEAF_COUNT)
+#define EC_OPEN(kind)  ((int)(kind))
+#define EC_CLOSE(kind) (AST_KIND_COUNT + (int)(kind))
+#define EC_LEAF(leaf)  (2 * AST_KIND_COUNT + (int)(leaf))
+
+/** @brief 单项代价上限（保证 32 位 DP 单元在常见规模下不会溢出）。 */
+#define EDIT_COST_MAX 63
+
+/**
+ * @brief 代价模型（与符号表无关）。
+ */
+typedef struct {
+    uint8_t sub[EC_CLASS_COUNT][EC_CLASS_COUNT];
+    uint8_t indel[EC_CLASS_COUNT];
+} EditCostModel;
+
+/**
+ * @brief 绑定到某张符号表的代价表：符号 ID 直接查类别，替换代价展开为 32 位供向量化查表。
+ */
+typedef struct {
+    uint8_t* sym_class;                                 // SymId -> 类别
+    size_t   nsyms;
+    uint32_t sub[EC_CLASS_COUNT * EC_CLASS_COUNT];      // sub[类别a * EC_CLASS_COUNT + 类别b]
+    uint32_t indel[EC_CLASS_COUNT];
+    bool     simd;                                      // 使用向量内核：绑定时检测一次 CPU，置 false 强制标量
+} EditCosts;
+
+/** @brief 全部替换代价为 sub、插入删除代价为 indel 的模型。 */
+void   edit_cost_uniform(EditCostModel* m, unsigned sub, unsigned indel);
+
+/**
+ * @brief 内置的“按类别”模型（--costs=kind）：单位代价 2；
+ *        循环（FOR / WHILE / DO_WHILE）之间、分支（IF / SWITCH）之间的进出标签互换代价 1；
+ *        出标签不计代价（只由进标签承担结构）。
+ */
+void   edit_cost_kind_preset(EditCostModel* m);
+
+/**
+ * @brief 在 m 的基础上读入代价文件（语法见文件头）。
+ *
+ * @return 成功返回 true；文件无法打开或某行无法解析时返回 false（m 可能已部分修改）。
+ */
+bool   edit_cost_load(EditCostModel* m, const char* path);
+
+/**
+ * @brief 按符号表中的名称为每个符号确定类别。
+ *
+ * 之后新驻留的符号不在表中，须重新绑定。
+ * 向量内核的 CPU 检测也在此完成，之后 t 可被多个线程同时只读使用。
+ * @return 成功返回 true；内存不足返回 false。
+ */
+bool   edit_costs_bind(EditCosts* t, const EditCostModel* m, const SymTab* syms);
+void   edit_costs_free(EditCosts* t);
+
+/** @brief 序列全部删除的代价（加权相似度的归一化分母）。 */
+size_t edit_cost_total(const EditCosts* t, const SymVec* s);
+
+/**
+ * @brief 加权编辑距离：反对角线 DP，内层循环按 AVX2 / NEON 一次处理 8 / 4 个单元（不支持时为标量）。
+ *
+ * 结果与 edit_distance_weighted_dp 一致。
+ */
+size_t edit_distance_weighted(const EditCosts* t, const SymVec* a, const SymVec* b);
+
+/** @brief 加权编辑距离的逐行标量实现（参考实现）。 */
+size_t edit_distance_weighted_dp(const EditCosts* t, const SymVec* a, const SymVec* b);
+
+/**
+ * @brief 加权相似度：1 - dist / max(全部删除 a 的代价, 全部删除 b 的代价)，截断到 [0, 1]。
+ *
+ * 全部代价为同一常数时与 similarity_from_dist 相同。
+ */
+double similarity_weighted(const EditCosts* t, size_t dist, const SymVec* a, const SymVec* b);
+
+#endif //COURSEDESIGNTASKS_EDIT_COST_H
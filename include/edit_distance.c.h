@@ -12,12 +12,80 @@
 #pragma once
 #include <stddef.h>
 #include "ast_serial.h"
+#include "symtab.h"
 
 /**
  * @brief 计算两条字符串序列的 Levenshtein 编辑距离。
  */
 size_t levenshtein_strvec(const StrVec *a, const StrVec *b);
 
+/**
+ * @brief 计算两条符号序列的 Levenshtein 编辑距离（与 levenshtein_strvec 结果一致）。
+ *
+ * 两条序列须来自同一 SymTab；每个 DP 单元只做一次整数比较。
+ */
+size_t levenshtein_symvec(const SymVec *a, const SymVec *b);
+
+/**
+ * @brief 位并行（Myers/Hyyrö 多块）编辑距离，结果与 levenshtein_symvec 一致。
+ *
+ * 每个 64 位字一次处理 64 个 DP 单元，适合长序列。
+ */
+size_t levenshtein_symvec_myers(const SymVec *a, const SymVec *b);
+
+/**
+ * @brief 分块波前并行的位并行编辑距离（单对超长序列用满多核），结果与 levenshtein_symvec 一致。
+ *
+ * @param jobs 线程数；<= 0 为 CPU 核数，1 为串行。规模较小时直接串行计算。
+ */
+size_t levenshtein_symvec_wavefront(const SymVec *a, const SymVec *b, int jobs);
+
+/**
+ * @brief 位并行求 DP 整列：col[i] = D(text, pat 的前 i 个符号)，i = 0..m（Hirschberg 分治用）。
+ * @param reverse 为 true 时两条序列都倒序读取（col[i] 对应 pat 的后 i 个符号）。
+ * @return 成功返回 true；内存不足返回 false。
+ */
+bool levenshtein_column_myers(const SymId *text, size_t n, const SymId *pat, size_t m,
+                              bool reverse, size_t *col);
+
+/**
+ * @brief 带上界 max_dist 的编辑距离：只计算 Ukkonen 对角带，超出上界即提前终止。
+ *
+ * @return 距离 <= max_dist 时为精确值，否则返回 max_dist + 1。
+ */
+size_t levenshtein_symvec_bounded(const SymVec *a, const SymVec *b, size_t max_dist);
+
+/**
+ * @brief 由相似度下限（如 0.6 / 0.9）换算出 levenshtein_symvec_bounded 的上界。
+ */
+size_t max_dist_for_similarity(double min_sim, size_t lenA, size_t lenB);
+
+/**
+ * @brief 编辑距离引擎选择。
+ */
+typedef enum {
+    ED_ENGINE_DP = 0,   // 经典两行 DP
+    ED_ENGINE_BITPAR,   // Myers/Hyyrö 位并行
+    ED_ENGINE_WAVEFRONT // 位并行 + 分块反对角线多线程（单对大文件）
+} EditEngine;
+
+/**
+ * @brief 按引擎计算符号序列编辑距离。
+ */
+size_t edit_distance_symvec(const SymVec *a, const SymVec *b, EditEngine engine);
+
+/**
+ * @brief 外层已经并行时应使用的引擎（ED_ENGINE_WAVEFRONT 换成 ED_ENGINE_BITPAR，其余不变）。
+ */
+EditEngine edit_engine_serial(EditEngine engine);
+
+/**
+ * @brief 带上界的 edit_distance_symvec：上界较紧时走对角带，否则走指定引擎。
+ *
+ * @return 距离 <= max_dist 时为精确值，否则返回 max_dist + 1。
+ */
+size_t edit_distance_symvec_bounded(const SymVec *a, const SymVec *b, size_t max_dist, EditEngine engine);
+
 /**
  * @brief 由编辑距离计算相似度（归一化）。
  */
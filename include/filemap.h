@@ -0,0 +1,45 @@
+/**
+* @file filemap.h
+ * @brief 只读文件映射：POSIX 下为 mmap，Windows 下为 MapViewOfFile。
+ *
+ * 大文件（如 codes/huge_code.c）不再整体复制到堆上，
+ * tokenizer 直接扫描映射视图（不要求结尾 '\0'），降低启动延迟与峰值内存。
+ * 映射不可用时（管道、特殊文件等）自动退回一次性读入。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_FILEMAP_H
+#define COURSEDESIGNTASKS_FILEMAP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief 一个已打开的只读文件视图。
+ */
+typedef struct {
+    const char* data;   // 文件内容（不保证以 '\0' 结尾）；空文件时为 ""
+    size_t      size;   // 字节数
+    bool        mapped; // true: 映射视图；false: 堆缓冲区（退回路径）
+#ifdef _WIN32
+    void*       file;   // HANDLE：文件
+    void*       mapping;// HANDLE：文件映射对象
+#endif
+} FileMap;
+
+/**
+ * @brief 以只读方式打开并映射整个文件。
+ *
+ * @param m    输出视图。
+ * @param path 文件路径。
+ * @return 成功返回 true；文件不存在或读取失败返回 false。
+ */
+bool filemap_open(FileMap* m, const char* path);
+
+/**
+ * @brief 解除映射（或释放退回路径的缓冲区）；m 可为 NULL，可重复调用。
+ */
+void filemap_close(FileMap* m);
+
+#endif //COURSEDESIGNTASKS_FILEMAP_H
@@ -0,0 +1,93 @@
+/**
+* @file fingerprint.h
+ * @brief k-gram 指纹（Winnowing，MOSS 风格）与倒排索引预筛。
+ *
+ * 对序列化后的 AST 符号流取连续 k 个符号的滚动哈希，在每个长度为 w 的窗口中
+ * 选取最小哈希作为指纹。两份代码若有长度不小于 w + k - 1 的公共片段，
+ * 必然共享至少一个指纹。批量模式先按共享指纹数挑出候选对，
+ * 只有候选对进入代价高的精确编辑距离阶段。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_FINGERPRINT_H
+#define COURSEDESIGNTASKS_FINGERPRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "symtab.h"
+
+#define FP_DEFAULT_K 12     // k-gram 长度（符号个数）
+#define FP_DEFAULT_W 8      // 窗口大小（k-gram 个数）
+
+/**
+ * @brief 指纹集合：升序、去重的 64 位哈希。
+ */
+typedef struct {
+    uint64_t* data;
+    size_t    size;
+    size_t    cap;
+} FpVec;
+
+void     fp_init(FpVec* v);
+void     fp_free(FpVec* v);
+
+/**
+ * @brief 符号名称的稳定哈希：只依赖字符串内容，与 SymTab 中的 ID 无关，
+ *        因此不同进程、不同符号表算出的指纹可以直接比较。
+ */
+uint64_t fp_symbol_hash(const char* name);
+
+/** @brief 与 fp_symbol_hash 相同，但全部 var_<N> 共用一个哈希（与标识符出现位置无关）。 */
+uint64_t fp_label_hash(const char* name);
+
+/**
+ * @brief 为符号表中每个 ID 预先计算 fp_label_hash。
+ *
+ * @return 长度为 symtab_size(syms) 的数组（调用方 free）；失败返回 NULL。
+ */
+uint64_t* fp_symbol_table(const SymTab* syms);
+
+/**
+ * @brief 对符号序列做 Winnowing，结果写入 out（升序去重）。
+ *
+ * 序列短于 k 时整条序列视为一个 k-gram；空序列得到空集合。
+ *
+ * @param sym_hash fp_symbol_table 的结果。
+ * @param k        k-gram 长度（>= 1）。
+ * @param w        窗口大小（>= 1）。
+ * @return 成功返回 true；内存不足返回 false。
+ */
+bool     fp_winnow(const SymVec* seq, const uint64_t* sym_hash, size_t k, size_t w, FpVec* out);
+
+/** @brief 两个指纹集合的交集大小（归并计数）。 */
+size_t   fp_shared(const FpVec* a, const FpVec* b);
+
+/**
+ * @brief 重合度：共享指纹数 / 较小集合的指纹数（包含度，对“部分抄袭”更敏感）。
+ */
+double   fp_overlap(size_t shared, size_t size_a, size_t size_b);
+
+/**
+ * @brief 候选文件对（a < b）。
+ */
+typedef struct {
+    size_t a, b;
+    size_t shared;      // 共享指纹数（不含被 max_df 过滤的高频指纹）
+    double overlap;     // fp_overlap 的结果
+} FpCandidate;
+
+/**
+ * @brief 倒排索引求候选对：只枚举至少共享一个指纹的文件对。
+ *
+ * @param sets        n 个指纹集合（空集合不参与）。
+ * @param min_overlap 重合度下限，达到下限的文件对才输出。
+ * @param max_df      出现在多于 max_df 个文件中的指纹视为模板代码而忽略；0 表示不限制。
+ * @param ncand       输出候选对数量。
+ * @return 候选对数组，按 (a, b) 字典序（调用方 free）；失败返回 NULL。
+ */
+FpCandidate* fp_candidates(const FpVec* sets, size_t n, double min_overlap, size_t max_df,
+                           size_t* ncand);
+
+#endif //COURSEDESIGNTASKS_FINGERPRINT_H
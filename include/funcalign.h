@@ -0,0 +1,85 @@
+/**
+* @file funcalign.h
+ * @brief 函数级对齐：两份代码的函数×函数相似度矩阵 + 最优一对一匹配。
+ *
+ * 整文件一次 O(n·m) 的 DP 拆成许多函数对的小 DP，每个都能放进 L1/L2 缓存；
+ * 局部序列完全相同的函数对直接记为距离 0，不做 DP。
+ * 匹配使用匈牙利算法，使“相似度 × 两函数长度之和”的总和最大。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_FUNCALIGN_H
+#define COURSEDESIGNTASKS_FUNCALIGN_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "symtab.h"
+#include "merkle.h"
+#include "edit_distance.c.h"
+
+/** @brief 一对匹配的函数（a、b 为各自 FuncTable 中的下标）。 */
+typedef struct {
+    size_t a, b;
+    size_t dist;
+    double sim;
+} FuncMatch;
+
+/**
+ * @brief 对齐结果。
+ *
+ * sim 为 na × nb 的行优先矩阵；overall 为按函数长度加权的整体相似度：
+ * Σ(匹配对相似度 × 两函数长度之和) / 全部函数长度之和（未匹配的函数记 0）。
+ */
+typedef struct {
+    size_t     na, nb;
+    double*    sim;
+    FuncMatch* matches;     // 按 a 升序，共 nmatch 对（= min(na, nb)）
+    size_t     nmatch;
+    double     overall;
+} FuncAlignment;
+
+/** @brief 函数对得分缓存的一项：两函数局部序列内容键（较小者在前）-> 编辑距离。 */
+typedef struct {
+    uint64_t ka, kb;
+    uint64_t dist;
+    bool     used;
+} FuncScoreEntry;
+
+/**
+ * @brief 函数对得分缓存（开放寻址）。键只依赖函数内容，与文件及函数位置无关，
+ *        重新提交时未修改的函数之间的得分可直接复用。
+ */
+typedef struct {
+    FuncScoreEntry* slots;
+    size_t          cap;     // 槽数量（2 的幂）
+    size_t          count;
+    size_t          hits;    // 本次复用的得分数
+    size_t          added;   // 本次新写入的得分数
+} FuncScoreCache;
+
+void fscore_init(FuncScoreCache* c);
+void fscore_free(FuncScoreCache* c);
+/** @brief 从文件追加加载（文件不存在或损坏返回 false，已加载的项保留）。 */
+bool fscore_load(FuncScoreCache* c, const char* path);
+bool fscore_save(const FuncScoreCache* c, const char* path);
+
+/**
+ * @brief 计算函数级对齐。
+ *
+ * 函数内的标识符按出现次序重新编号后再比较（见 funcalign.c），因此得分与函数在文件中的位置无关。
+ *
+ * @param syms     两条序列共用的符号表。
+ * @param seq_a/fa 文件 A 的完整符号序列及其函数摘要表（区间指向 seq_a）。
+ * @param seq_b/fb 文件 B 同上。
+ * @param jobs     并行线程数；<= 0 为 CPU 核数，1 为串行。
+ * @param scores   可选：函数对得分缓存，命中则跳过 DP，新算出的得分写回。
+ * @return 成功返回 true；内存不足返回 false。任一方没有函数时结果为空矩阵、overall 为 0。
+ */
+bool func_align(const SymTab* syms, const SymVec* seq_a, const FuncTable* fa,
+                const SymVec* seq_b, const FuncTable* fb, EditEngine engine, int jobs,
+                FuncScoreCache* scores, FuncAlignment* out);
+
+void func_alignment_free(FuncAlignment* al);
+
+#endif //COURSEDESIGNTASKS_FUNCALIGN_H
@@ -0,0 +1,81 @@
+/**
+* @file merkle.h
+ * @brief 子树结构哈希（Merkle 风格）与函数级摘要表。
+ *
+ * 每个节点的哈希由“节点类别 + 叶子标签 + 有序子节点哈希”自底向上组合而成，
+ * 结构相同的子树必得到相同哈希。抄袭往往只涉及个别函数，整文件的编辑距离会被
+ * 其余代码稀释；按函数摘要做哈希连接，可在 O(n + m) 内找出两份代码中结构完全相同的函数。
+ *
+ * 标签哈希使用 fp_label_hash（全部 var_<N> 视为同一标识符），
+ * 因此同一函数出现在文件中的不同位置时摘要不变。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_MERKLE_H
+#define COURSEDESIGNTASKS_MERKLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "ast.h"
+#include "symtab.h"
+
+/**
+ * @brief 计算整棵子树的结构哈希，并写入每个节点的 hash 字段。
+ * @return 根节点哈希；node 为 NULL 返回 0。
+ */
+uint64_t ast_merkle(ASTNode* node);
+
+/**
+ * @brief 单个 AST_FUNCTION 的摘要。
+ *
+ * [seq_begin, seq_end) 为该函数在整棵树序列化结果（ast_serialize_symbols /
+ * pipeline_build_symbols）中的下标区间，可直接截取出函数的符号序列。
+ */
+typedef struct {
+    uint64_t digest;
+    size_t   seq_begin;
+    size_t   seq_end;
+} FuncDigest;
+
+/** @brief 函数摘要表，按函数在源码中的出现顺序排列。 */
+typedef struct {
+    FuncDigest* data;
+    size_t      size;
+    size_t      cap;
+} FuncTable;
+
+void functable_init(FuncTable* t);
+void functable_free(FuncTable* t);
+
+/**
+ * @brief 由 AST 建立函数摘要表（会先调用 ast_merkle）。
+ * @return 成功返回 true；内存不足返回 false。
+ */
+bool functable_from_ast(ASTNode* root, FuncTable* out);
+
+/**
+ * @brief 由序列化后的符号序列重建函数摘要表，结果与 functable_from_ast 完全一致。
+ *
+ * 序列可能来自磁盘缓存（此时没有 AST），标签结构足以逐层复原子树哈希。
+ *
+ * @return 成功返回 true；序列标签不配对或内存不足返回 false。
+ */
+bool functable_from_symbols(const SymTab* syms, const SymVec* seq, FuncTable* out);
+
+/** @brief 一对结构完全相同的函数（a、b 为各自摘要表中的下标）。 */
+typedef struct {
+    size_t a, b;
+} FuncPair;
+
+/**
+ * @brief 哈希连接：按摘要一对一匹配两张表中的函数（重复摘要按出现顺序配对）。
+ *
+ * @param out    输出数组，容量至少为 min(a->size, b->size)。
+ * @param npairs 输出匹配对数；结果按 b 的下标升序排列。
+ * @return 成功返回 true；内存不足返回 false。
+ */
+bool functable_join(const FuncTable* a, const FuncTable* b, FuncPair* out, size_t* npairs);
+
+#endif //COURSEDESIGNTASKS_MERKLE_H
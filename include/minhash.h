@@ -0,0 +1,85 @@
+/**
+* @file minhash.h
+ * @brief MinHash 签名与分带 LSH 索引：在历史提交库中亚线性地查找近邻。
+ *
+ * 每个文件以其 Winnowing 指纹集合（fingerprint.h）为 shingle 集合，
+ * 计算 MH_NUM_HASHES 个最小哈希组成签名；两签名相同位置相等的比例
+ * 是两集合 Jaccard 相似度的无偏估计。签名切成 MH_BANDS 段、每段 MH_ROWS 行，
+ * 任意一段完全相同的文件才成为候选，查询时只需检查与本文件“撞段”的少数文件。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_MINHASH_H
+#define COURSEDESIGNTASKS_MINHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "symtab.h"
+#include "fingerprint.h"
+
+#define MH_NUM_HASHES 128
+#define MH_BANDS      32
+#define MH_ROWS       (MH_NUM_HASHES / MH_BANDS)   // 4 行/段：Jaccard 约 0.42 时命中概率为 1/2
+
+/** @brief MinHash 签名。 */
+typedef struct {
+    uint64_t v[MH_NUM_HASHES];
+} MinHashSig;
+
+/**
+ * @brief 由 shingle 集合（指纹集合）计算签名；空集合得到全 UINT64_MAX 的签名。
+ */
+void   minhash_sig(const FpVec* set, MinHashSig* out);
+
+/** @brief 估计 Jaccard 相似度：两签名相等分量的比例。 */
+double minhash_similarity(const MinHashSig* a, const MinHashSig* b);
+
+/** @brief 段表条目（内部使用）。 */
+typedef struct {
+    uint64_t key;   // 该段 MH_ROWS 个分量的组合哈希
+    uint32_t doc;
+} LshEntry;
+
+/**
+ * @brief 分带 LSH 索引。
+ *
+ * 文档以名称（通常为文件路径）标识，重复添加同名文档会覆盖旧签名。
+ * 修改后需调用 lsh_build 重建段表才能查询。
+ */
+typedef struct {
+    SymTab      names;  // 文档名称 -> 文档编号
+    MinHashSig* sigs;
+    size_t      count;
+    size_t      cap;
+    LshEntry*   bands;  // MH_BANDS 张按 key 排序的段表，首尾相接（每张 count 项）
+    bool        built;
+} LshIndex;
+
+/** @brief 一个查询结果。 */
+typedef struct {
+    size_t doc;         // 文档编号（lsh_doc_name 反查名称）
+    double estimate;    // MinHash 估计的 Jaccard 相似度
+} LshHit;
+
+void        lsh_init(LshIndex* idx);
+void        lsh_free(LshIndex* idx);
+bool        lsh_add(LshIndex* idx, const char* name, const MinHashSig* sig);
+bool        lsh_build(LshIndex* idx);
+const char* lsh_doc_name(const LshIndex* idx, size_t doc);
+
+/**
+ * @brief 查询与 sig 至少有一段相同的文档，按估计相似度降序返回前 top_k 个。
+ *
+ * @param out 输出数组（容量 top_k）。
+ * @return 实际返回的结果数；索引未构建返回 0。
+ */
+size_t      lsh_query(const LshIndex* idx, const MinHashSig* sig, size_t top_k, LshHit* out);
+
+/** @brief 保存索引（名称 + 签名；段表在加载时由签名重建）。 */
+bool        lsh_save(const LshIndex* idx, const char* path);
+/** @brief 加载索引并重建段表；idx 需已 lsh_init（原有内容被清空）。 */
+bool        lsh_load(LshIndex* idx, const char* path);
+
+#endif //COURSEDESIGNTASKS_MINHASH_H
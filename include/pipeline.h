@@ -0,0 +1,124 @@
+/**
+* @file pipeline.h
+ * @brief 前端流水线接口：源码 -> Token 数组 -> AST -> 符号序列。
+ *
+ * 与 main.c 中带进度显示的 process_code 相同的处理步骤，但不做任何终端输出，
+ * 供批量模式等需要“每个文件只处理一次”的场景复用。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_PIPELINE_H
+#define COURSEDESIGNTASKS_PIPELINE_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include "std_token.h"
+#include "tokenizer.h"
+#include "symtab.h"
+#include "ast_serial.h"
+#include "seqcache.h"
+
+/**
+ * @brief 前端输出版本号：tokenizer / parser / 序列化的输出发生任何变化时必须递增，
+ *        以使旧的磁盘缓存（seqcache.h）全部失效。
+ */
+#define PIPELINE_VERSION 3u
+
+/**
+ * @brief 设置前端的标识符归一化方式（默认 TK_IDENT_SEQUENTIAL），须在任何分析开始前调用一次。
+ *
+ * 对 pipeline_build_* / pipeline_load_symbols 生效；两种方式的磁盘缓存按键区分，互不命中。
+ */
+void      pipeline_set_ident_mode(IdentMode mode);
+IdentMode pipeline_ident_mode(void);
+
+/**
+ * @brief 将源代码转换为 Token 指针数组（不含 EOF）。
+ *
+ * @param source      源代码（以 '\0' 结尾）。
+ * @param token_count 输出 token 数量。
+ * @return token 数组（用 tokens_free 释放）；内存不足返回 NULL。
+ */
+Token** tokenize_code(const char* source, size_t* token_count);
+
+/** @brief 释放 tokenize_code 返回的数组及其中的全部 Token。 */
+void    tokens_free(Token** tokens, size_t count);
+
+/**
+ * @brief 以二进制方式读入整个文件（末尾补 '\0'）。
+ *
+ * @param path    文件路径。
+ * @param out_len 可选：输出字节数。
+ * @return malloc 得到的缓冲区；失败返回 NULL。
+ */
+char*   pipeline_read_file(const char* path, size_t* out_len);
+
+/**
+ * @brief 对一段源码执行完整前端，结果追加到 out。
+ *
+ * @param source 源代码（不要求以 '\0' 结尾，可直接传入 FileMap 视图）。
+ * @param len    源代码字节数。
+ * @param syms   符号表（需比较的序列必须共用同一张表）。
+ * @param out    输出序列（需已初始化）。
+ * @param ntokens 可选：输出识别到的 token 数（用于区分空文件与处理失败）。
+ * @return 成功返回 true；源码为空或处理失败返回 false（out 保持调用前的长度）。
+ */
+bool    pipeline_build_symbols(const char* source, size_t len, SymTab* syms, SymVec* out,
+                               size_t* ntokens);
+
+/**
+ * @brief 同 pipeline_build_symbols，并把每个符号的源码行号追加到 lines（可为 NULL）。
+ *
+ * 行号来自 token 的位置，经 AST 节点保留到序列化结果，供差异报告映射回源码。
+ * 不经过缓存：缓存的序列不含行号。
+ */
+bool    pipeline_build_located(const char* source, size_t len, SymTab* syms, SymVec* out,
+                               LineVec* lines, size_t* ntokens);
+
+/**
+ * @brief 顶层区域切分（增量分析用）：在括号深度为 0、且所在行随即结束的 '}' 之后切开。
+ *
+ * @param nregions 输出区域数；区域 i 为 [ends[i-1], ends[i])（ends[-1] 视为 0）。
+ * @return malloc 得到的区域结束偏移数组（调用方 free）；空源码或内存不足返回 NULL。
+ */
+size_t* pipeline_split_regions(const char* source, size_t len, size_t* nregions);
+
+/**
+ * @brief 增量前端：源码未变的顶层区域直接复用 cache 中的序列片段，其余区域重新分析并写回。
+ *
+ * 输出与 pipeline_build_symbols 完全相同。cache 为 NULL 时逐区域分析、不做复用。
+ * 作用域模式下不做区域复用，等同 pipeline_build_symbols。
+ *
+ * @param ntokens 可选：输出重新做词法分析的 token 数。
+ */
+bool    pipeline_build_incremental(SeqCache* cache, const char* source, size_t len,
+                                   SymTab* syms, SymVec* out, size_t* ntokens);
+
+/** @brief 源码不小于该字节数时 pipeline_build_parallel 才切块并行。 */
+#define PIPELINE_SPLIT_MIN   (1u << 20)
+/** @brief 并行前端每块的最小字节数（块过小时建表、拼接的开销超过解析本身）。 */
+#define PIPELINE_SPLIT_CHUNK (64u << 10)
+
+/**
+ * @brief 单文件并行前端：在顶层区域边界切块，多线程分别分析后按顺序拼接。
+ *
+ * 输出与 pipeline_build_symbols 完全相同（标识符编号在拼接时确定地平移），与线程数无关。
+ *
+ * @param jobs 线程数；<= 0 为 CPU 核数，1、源码小于 PIPELINE_SPLIT_MIN 或作用域模式下串行。
+ */
+bool    pipeline_build_parallel(const char* source, size_t len, SymTab* syms, SymVec* out,
+                                size_t* ntokens, int jobs);
+
+/**
+ * @brief 带磁盘缓存的前端：命中时直接读取缓存序列，否则经 pipeline_build_incremental 执行前端并写回缓存。
+ *
+ * @param cache     缓存句柄；为 NULL 时等同 pipeline_build_symbols。
+ * @param ntokens   可选：输出 token 数（命中缓存时为 0，表示未做词法分析）。
+ * @param from_cache 可选：输出是否命中缓存。
+ * @return 成功返回 true。
+ */
+bool    pipeline_load_symbols(SeqCache* cache, const char* source, size_t len,
+                              SymTab* syms, SymVec* out, size_t* ntokens, bool* from_cache);
+
+#endif //COURSEDESIGNTASKS_PIPELINE_H
@@ -0,0 +1,78 @@
+/**
+* @file report.h
+ * @brief 机器可读的结果输出（--format=json|csv|tsv）：不清屏、无颜色与边框，经单一缓冲写出。
+ *
+ * 每条结果是一行记录，列名在 report_init 时给出：
+ * - json：JSON Lines，每行一个对象 {"列名":值,...}；
+ * - csv ：首行为表头，字段含逗号/引号/换行时按 RFC 4180 加引号；
+ * - tsv ：首行为表头，字段中的制表符与换行替换为空格。
+ * 所有输出先写入内部缓冲区，满了或 report_flush 时一次 fwrite，避免逐字段的 stdio 调用。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_REPORT_H
+#define COURSEDESIGNTASKS_REPORT_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @brief 输出格式；REPORT_TEXT 为交互式终端界面（不经本模块）。 */
+typedef enum {
+    REPORT_TEXT = 0,
+    REPORT_JSON,
+    REPORT_CSV,
+    REPORT_TSV
+} ReportFormat;
+
+/** @brief 内部缓冲区大小（字节）。 */
+#define REPORT_BUF_SIZE 65536
+
+/**
+ * @brief 记录写出器。
+ */
+typedef struct {
+    FILE*              out;
+    ReportFormat       fmt;
+    const char* const* cols;    // 列名（调用方持有，生命周期覆盖整个写出过程）
+    size_t             ncols;
+    size_t             col;     // 当前行已写的列数
+    size_t             rows;    // 已完成的行数
+    size_t             len;     // buf 中待写出的字节数
+    bool               failed;  // 曾经写出失败
+    char               buf[REPORT_BUF_SIZE];
+} ReportWriter;
+
+/**
+ * @brief 解析格式名（json / csv / tsv / text）。
+ *
+ * @return 名称有效返回 true。
+ */
+bool report_parse_format(const char* name, ReportFormat* out);
+
+/**
+ * @brief 初始化写出器；csv / tsv 立即写入表头（缓冲中）。
+ */
+void report_init(ReportWriter* w, FILE* out, ReportFormat fmt, const char* const* cols, size_t ncols);
+
+/** @brief 写一个字符串字段（NULL 视为空值：json 中为 null）。 */
+void report_str(ReportWriter* w, const char* v);
+/** @brief 写一个无符号整数字段。 */
+void report_uint(ReportWriter* w, uint64_t v);
+/** @brief 写一个实数字段（保留 6 位小数）。 */
+void report_real(ReportWriter* w, double v);
+/** @brief 写一个空值字段（json 为 null，csv / tsv 为空串）。 */
+void report_null(ReportWriter* w);
+/** @brief 结束当前行；缺少的列补空值。 */
+void report_end_row(ReportWriter* w);
+
+/**
+ * @brief 把缓冲区内容写到输出流。
+ *
+ * @return 从初始化以来全部写出成功返回 true。
+ */
+bool report_flush(ReportWriter* w);
+
+#endif //COURSEDESIGNTASKS_REPORT_H
@@ -0,0 +1,69 @@
+/**
+* @file seqcache.h
+ * @brief 结构序列的磁盘缓存：按“源码内容哈希 + 前端版本”保存序列化结果。
+ *
+ * 同一份提交被反复复查时，命中缓存即可跳过词法分析与语法分析，
+ * 直接进入比较步骤。缓存文件只依赖源码内容，与路径、文件名无关。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_SEQCACHE_H
+#define COURSEDESIGNTASKS_SEQCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "symtab.h"
+
+/**
+ * @brief 缓存目录句柄及命中统计。
+ */
+typedef struct {
+    char*  dir;         // 缓存目录（不存在时由 seqcache_open 创建）
+    size_t hits;        // 命中次数
+    size_t misses;      // 未命中次数（含文件损坏、版本不符）
+    size_t stores;      // 成功写入次数
+    size_t frag_hits;   // 区域片段命中次数（增量分析复用的顶层区域数）
+    size_t frag_stores; // 区域片段写入次数
+} SeqCache;
+
+/**
+ * @brief 源码内容键：128 位非加密哈希 + 源码长度。
+ */
+typedef struct {
+    uint64_t h[2];
+    uint64_t len;
+} SeqKey;
+
+bool seqcache_open(SeqCache* c, const char* dir);
+void seqcache_close(SeqCache* c);
+
+/** @brief 计算源码内容键（对相同内容恒定，与文件路径无关）。 */
+void seqcache_key(const char* source, size_t len, SeqKey* out);
+
+/**
+ * @brief 查询缓存：命中时把缓存的序列驻留到 syms 并追加到 out。
+ *
+ * @return 命中返回 true；未命中、文件损坏或版本不符返回 false（out 不变）。
+ */
+bool seqcache_load(SeqCache* c, const SeqKey* key, SymTab* syms, SymVec* out);
+
+/**
+ * @brief 写入缓存（先写临时文件再改名，并发写入同一键也不会留下半个文件）。
+ *
+ * @param seq 以 syms 中 ID 表示的序列。
+ * @return 成功返回 true。
+ */
+bool seqcache_store(SeqCache* c, const SeqKey* key, const SymTab* syms, const SymVec* seq);
+
+/**
+ * @brief 区域片段缓存（增量分析用）：key 为区域源码的内容键，aux 为调用方附加值。
+ *
+ * 与整文件缓存分开存放；未命中不计入 misses。
+ */
+bool seqcache_load_fragment(SeqCache* c, const SeqKey* key, SymTab* syms, SymVec* out, uint64_t* aux);
+bool seqcache_store_fragment(SeqCache* c, const SeqKey* key, const SymTab* syms, const SymVec* seq,
+                             uint64_t aux);
+
+#endif //COURSEDESIGNTASKS_SEQCACHE_H
@@ -0,0 +1,103 @@
+/**
+* @file seqfile.h
+ * @brief 结构序列的二进制文件格式（带版本，可直接内存映射）。
+ *
+ * 布局（所有整数为写入方的本机字节序，由 byte_order 字段校验）：
+ *
+ *   SeqFileHeader（96 字节）
+ *   u32 name_off[ndict + 1]       名称在名称区内的起止偏移（升序）
+ *   char names[]                  全部名称首尾相接（不含 '\0'）
+ *   （补齐到 8 字节边界）
+ *   u16/u32 stream[nseq]          序列：局部字典下标；ndict <= 65536 时为 u16
+ *
+ * 打开文件只做一次 mmap 与头部校验，名称与序列都直接引用映射内存，
+ * 不逐元素解析、不逐元素分配。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_SEQFILE_H
+#define COURSEDESIGNTASKS_SEQFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "symtab.h"
+#include "filemap.h"
+
+#define SEQFILE_MAGIC       "CDSQ"
+#define SEQFILE_FORMAT      2u
+#define SEQFILE_BYTE_ORDER  0x01020304u
+
+/**
+ * @brief 文件头：定长 96 字节，各段偏移均相对文件起始。
+ */
+typedef struct {
+    char     magic[4];      // "CDSQ"
+    uint32_t format;        // SEQFILE_FORMAT
+    uint32_t byte_order;    // SEQFILE_BYTE_ORDER（按本机字节序读出不相等即拒绝）
+    uint32_t pipeline;      // 生成该文件的 PIPELINE_VERSION
+    uint64_t key[2];        // 源码内容哈希
+    uint64_t src_len;       // 源码字节数
+    uint64_t nseq;          // 序列长度
+    uint32_t ndict;         // 字典项数
+    uint32_t width;         // 序列元素字节数：2 或 4
+    uint64_t off_table;     // name_off 表偏移
+    uint64_t off_names;     // 名称区偏移
+    uint64_t off_stream;    // 序列偏移（8 字节对齐）
+    uint64_t file_size;     // 文件总字节数
+    uint64_t aux;           // 调用方附加值（如区域片段的标识符计数），普通缓存为 0
+} SeqFileHeader;
+
+/**
+ * @brief 已映射的序列文件（只读视图）。
+ */
+typedef struct {
+    FileMap              map;
+    const SeqFileHeader* hdr;
+    const uint32_t*      name_off;
+    const char*          names;
+    const void*          stream;
+} SeqView;
+
+/**
+ * @brief 把以 syms 中 ID 表示的序列写成序列文件（只收录出现过的符号）。
+ *
+ * @param key     源码内容哈希（写入头部，供加载方核对）。
+ * @param src_len 源码字节数。
+ * @param aux     写入头部 aux 字段的附加值。
+ * @return 成功返回 true。
+ */
+bool seqfile_write(const char* path, const uint64_t key[2], uint64_t src_len, uint64_t aux,
+                   const SymTab* syms, const SymVec* seq);
+
+/**
+ * @brief 映射并校验序列文件。
+ *
+ * 校验魔数、格式版本、字节序、各段偏移与文件大小；不校验 pipeline 与 key，
+ * 由调用方按需比较 v->hdr 中的字段。
+ *
+ * @return 成功返回 true（用 seqfile_close 释放）；损坏或版本不符返回 false。
+ */
+bool seqfile_open(SeqView* v, const char* path);
+void seqfile_close(SeqView* v);
+
+/** @brief 第 i 个字典项的名称（不以 '\0' 结尾），长度写入 *len。 */
+static inline const char* seqview_name(const SeqView* v, uint32_t i, size_t* len) {
+    *len = v->name_off[i + 1] - v->name_off[i];
+    return v->names + v->name_off[i];
+}
+
+/** @brief 序列第 i 个元素的局部字典下标。 */
+static inline uint32_t seqview_at(const SeqView* v, size_t i) {
+    return v->hdr->width == 2 ? ((const uint16_t*)v->stream)[i] : ((const uint32_t*)v->stream)[i];
+}
+
+/**
+ * @brief 把视图中的序列驻留到 syms 并追加到 out：字典逐项驻留一次，序列一遍查表映射。
+ *
+ * @return 成功返回 true；内存不足或出现越界下标返回 false（out 长度不变）。
+ */
+bool seqview_to_symbols(const SeqView* v, SymTab* syms, SymVec* out);
+
+#endif //COURSEDESIGNTASKS_SEQFILE_H
@@ -0,0 +1,49 @@
+/**
+* @file serve.h
+ * @brief 常驻服务模式（--serve）：语料只加载一次并常驻内存，逐行读取请求，返回排好序的匹配。
+ *
+ * 每行一个请求（空行与 '#' 开头的行忽略），路径为命令后的整行剩余部分：
+ * - query PATH ：与语料比较，返回最相似的 top_k 个文件，不修改语料；
+ * - add PATH   ：把文件加入语料（相同路径则替换旧版本）；
+ * - check PATH ：先 query 再 add，即“收到一份新提交”；query / check 不与同路径的旧版本比较；
+ * - quit       ：结束服务（输入流结束同样结束）。
+ * 每个请求的应答为若干条 status=match 的记录，随后恰好一条 status=ok 或 status=error 的记录，
+ * 写完立即 flush；客户端读到非 match 的记录即表示应答结束。
+ * 常驻的内容：语料符号表与各文件的结构序列、（prefilter > 0 时）各文件的 Winnowing 指纹。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_SERVE_H
+#define COURSEDESIGNTASKS_SERVE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "batch.h"
+#include "seqcache.h"
+#include "report.h"
+
+/** @brief 应答记录的列名。 */
+extern const char* const SERVE_COLS[];
+extern const size_t      SERVE_NCOLS;
+
+/**
+ * @brief 服务参数。
+ */
+typedef struct {
+    BatchOptions opt;       // 比较参数；opt.prefilter > 0 时先用常驻指纹筛选候选
+    size_t       top_k;     // 每个查询返回的匹配数
+    SeqCache*    cache;     // 新提交的前端缓存，可为 NULL
+} ServeOptions;
+
+/**
+ * @brief 在已加载（batch_load）的语料上运行请求循环，直到 quit 或输入结束。
+ *
+ * 语料在服务期间随 add / check 增长；返回后仍由调用方 batch_free。
+ *
+ * @param rep 应答写出器（须以 SERVE_COLS 初始化）。
+ * @return 0 表示正常结束；内存不足或写出失败返回 1。
+ */
+int serve_run(BatchCorpus* c, const ServeOptions* so, FILE* in, ReportWriter* rep);
+
+#endif //COURSEDESIGNTASKS_SERVE_H
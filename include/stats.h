@@ -0,0 +1,85 @@
+/**
+* @file stats.h
+ * @brief 运行统计：单调时钟计时的阶段耗时 + 全局计数器（--stats / --stats-json）。
+ *
+ * 计数点按“每次调用”而非“每个元素”累加（如一次解析结束后加上节点总数），
+ * 计数器为宽松原子加，可在线程池任务中使用。
+ * 未定义 CDT_STATS 时（CMake 选项 ENABLE_STATS=OFF）STATS_* 宏展开为空语句，
+ * 参数只出现在 sizeof 中、不会被求值，库代码中不留任何统计开销；查询与打印函数仍可调用，结果全为 0。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_STATS_H
+#define COURSEDESIGNTASKS_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @brief 计数器。 */
+typedef enum {
+    ST_SOURCE_BYTES = 0,    // 经过词法分析的源码字节数
+    ST_TOKENS,              // 产出的 token 数
+    ST_AST_NODES,           // 创建的 AST 节点数
+    ST_SYMBOLS,             // 序列化产出的符号数（缓存命中的序列不计）
+    ST_DISTANCES,           // 编辑距离计算次数（各引擎入口）
+    ST_DP_CELLS,            // 计算的 DP 单元数（位并行引擎按等价单元计）
+    ST_ALLOC_BYTES,         // 主要缓冲的分配量（区域块、符号序列、行号序列的扩容增量）
+    ST_COUNTER_COUNT
+} StatCounter;
+
+/** @brief 计时阶段（墙钟时间，由调用方包在阶段外层）。 */
+typedef enum {
+    ST_STAGE_READ = 0,      // 打开 / 映射源文件
+    ST_STAGE_FRONTEND,      // 词法 + 语法 + 序列化（含缓存读写）
+    ST_STAGE_DISTANCE,      // 整文件 / 文件对编辑距离
+    ST_STAGE_ALIGN,         // 函数级对齐
+    ST_STAGE_DIFF,          // 差异定位（Hirschberg）
+    ST_STAGE_TOTAL,         // 整个命令
+    ST_STAGE_COUNT
+} StatStage;
+
+/** @brief 是否编译了统计（CDT_STATS）。 */
+bool        stats_enabled(void);
+void        stats_reset(void);
+uint64_t    stats_counter(StatCounter c);
+uint64_t    stats_stage_ns(StatStage s);
+const char* stats_counter_name(StatCounter c);
+const char* stats_stage_name(StatStage s);
+/** @brief 可读表格。 */
+void        stats_print(FILE* out);
+/** @brief 单行 JSON：{"enabled":..,"stages_ms":{..},"counters":{..}}。 */
+void        stats_print_json(FILE* out);
+
+#ifdef CDT_STATS
+
+extern uint64_t stats_counters_[ST_COUNTER_COUNT];
+
+/** @brief 单调时钟（纳秒）。 */
+uint64_t stats_now_ns(void);
+void     stats_stage_add(StatStage s, uint64_t ns);
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define STATS_ATOMIC_ADD(p, v) _InterlockedExchangeAdd64((volatile long long*)(p), (long long)(v))
+#else
+#define STATS_ATOMIC_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#endif
+
+/** @brief 计数器 c 加 v。 */
+#define STATS_ADD(c, v)           ((void)STATS_ATOMIC_ADD(&stats_counters_[(c)], (uint64_t)(v)))
+/** @brief 在当前作用域记下起始时刻 var。 */
+#define STATS_TIMER(var)          const uint64_t var = stats_now_ns()
+/** @brief 把自 var 起的耗时计入阶段 stage。 */
+#define STATS_STAGE_END(var, stage) stats_stage_add((stage), stats_now_ns() - (var))
+
+#else
+
+#define STATS_ADD(c, v)           ((void)sizeof(v))
+#define STATS_TIMER(var)          ((void)0)
+#define STATS_STAGE_END(var, stage) ((void)0)
+
+#endif
+
+#endif //COURSEDESIGNTASKS_STATS_H
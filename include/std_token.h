@@ -9,6 +9,9 @@
 #define COURSEDESIGNTASKS_STD_TOKEN_H
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "symtab.h"
 
 typedef enum {
     TOKEN_EOF,      // 终止
@@ -25,6 +28,9 @@ typedef enum { // 关键字集合
     KW_IF, KW_ELSE, KW_FOR, KW_WHILE, KW_DO, KW_SWITCH, KW_CASE, KW_DEFAULT,
     KW_RETURN, KW_BREAK, KW_CONTINUE,
     KW_INT, KW_CHAR, KW_FLOAT, KW_DOUBLE, KW_VOID, KW_STRUCT, KW_TYPEDEF,
+    KW_UNSIGNED, KW_SIGNED, KW_SHORT, KW_LONG, KW_CONST, KW_VOLATILE, KW_STATIC,
+    KW_EXTERN, KW_REGISTER, KW_AUTO, KW_SIZEOF, KW_ENUM, KW_UNION, KW_GOTO,
+    KW_INLINE, KW_RESTRICT,
 
     KW_UNKNOWN
 } KeywordKind;
@@ -39,4 +45,35 @@ typedef struct Token {
 
 void token_free(Token *tok);
 
+/**
+ * @brief 紧凑 Token：原始文本以 (offset, length) 引用源码缓冲区，lex 为驻留 ID。
+ *
+ * 与 Token 相比不做任何堆分配，可连续存放在 TokenArray 中。
+ */
+typedef struct TokenRef {
+    TokenType type;
+    KeywordKind kw;     // type == TK_KEYWORD 时有效，其它为 KW_UNKNOWN
+    SymId lex;          // 归一化字符串在 TokenArray.lexes 中的 ID（SYM_NONE 表示无）
+    uint32_t offset;    // 原始文本在源码中的字节偏移
+    uint32_t length;    // 原始文本字节数
+    int line, col;
+} TokenRef;
+
+/**
+ * @brief 连续存放的 TokenRef 数组（不含 EOF）。
+ *
+ * source 与 lexes 均为借用：数组使用期间二者必须保持有效。
+ */
+typedef struct {
+    TokenRef* data;
+    size_t size;
+    size_t cap;
+    const char* source;     // 被引用的源码缓冲区
+    const SymTab* lexes;    // lex ID 所属的符号表
+} TokenArray;
+
+void token_array_init(TokenArray *arr, const char *source, const SymTab *lexes);
+bool token_array_push(TokenArray *arr, const TokenRef *tok);
+void token_array_free(TokenArray *arr);
+
 #endif //COURSEDESIGNTASKS_STD_TOKEN_H
\ No newline at end of file
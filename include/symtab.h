@@ -0,0 +1,63 @@
+/**
+* @file symtab.h
+ * @brief 符号表（字符串驻留）与整数符号序列接口。
+ *
+ * 序列化后的 AST 标签（<IF>、</BLOCK>、NUM、var_3 ...）种类有限但重复极多，
+ * 将其驻留为 uint32_t 符号 ID 后：
+ * - 序列每个元素只占 4 字节，不再逐元素 malloc；
+ * - 编辑距离的每个 DP 单元只需一次整数比较。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_SYMTAB_H
+#define COURSEDESIGNTASKS_SYMTAB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "arena.h"
+
+/** @brief 符号 ID：同一 SymTab 内，相同字符串必得到相同 ID（从 0 连续编号）。 */
+typedef uint32_t SymId;
+
+/** @brief 表示“无符号”的保留 ID（symtab_name 对其返回 NULL）。 */
+#define SYM_NONE ((SymId)UINT32_MAX)
+
+/**
+ * @brief 字符串驻留表：开放寻址哈希 + ID -> 名称的反查数组。
+ *
+ * 所有名称统一存放在区域分配器中，symtab_name 返回的指针在 symtab_free 前一直有效。
+ */
+typedef struct {
+    uint32_t* slots;        // 哈希槽，保存 id + 1（0 表示空槽）
+    size_t    slot_cap;     // 槽数量（2 的幂）
+    const char** names;     // id -> 名称
+    uint64_t* hashes;       // id -> 名称哈希（扩容重排时复用）
+    size_t    count;        // 已驻留符号数
+    size_t    cap;          // names/hashes 容量
+    Arena     pool;         // 名称字符串池
+} SymTab;
+
+void        symtab_init(SymTab* t);
+void        symtab_free(SymTab* t);
+bool        symtab_intern(SymTab* t, const char* s, SymId* out);
+bool        symtab_intern_n(SymTab* t, const char* s, size_t len, SymId* out);
+const char* symtab_name(const SymTab* t, SymId id);
+size_t      symtab_size(const SymTab* t);
+
+/**
+ * @brief 整数符号序列（动态数组），StrVec 的紧凑替代。
+ */
+typedef struct {
+    SymId* data;
+    size_t size;
+    size_t cap;
+} SymVec;
+
+void  symv_init(SymVec* v);
+bool  symv_reserve(SymVec* v, size_t cap);
+bool  symv_push(SymVec* v, SymId id);
+void  symv_free(SymVec* v);
+
+#endif //COURSEDESIGNTASKS_SYMTAB_H
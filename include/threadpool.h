@@ -0,0 +1,52 @@
+/**
+* @file threadpool.h
+ * @brief 带工作窃取的线程池：用于并行执行 N 个相互独立的任务。
+ *
+ * 任务以下标区间的形式分给各工作线程；某线程的区间耗尽后，
+ * 从其它线程区间的尾部窃取一半。适合代价差异很大的任务（如不同长度的文件对）。
+ */
+
+#pragma once
+
+#ifndef COURSEDESIGNTASKS_THREADPOOL_H
+#define COURSEDESIGNTASKS_THREADPOOL_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/**
+ * @brief 任务回调。
+ *
+ * @param ctx    调用方上下文。
+ * @param index  任务下标（0..n-1，每个下标恰好执行一次）。
+ * @param worker 执行该任务的工作线程编号（0..tp_size-1，可用于线程私有缓冲）。
+ */
+typedef void (*TpTaskFn)(void* ctx, size_t index, int worker);
+
+typedef struct ThreadPool ThreadPool;
+
+/**
+ * @brief 创建线程池。
+ *
+ * @param nthreads 工作线程数（含调用线程）；<= 0 表示使用 CPU 核数。
+ * @return 线程池；失败返回 NULL。
+ */
+ThreadPool* tp_create(int nthreads);
+
+/** @brief 销毁线程池（等待全部工作线程退出）。 */
+void        tp_destroy(ThreadPool* pool);
+
+/** @brief 工作线程数（含调用线程）。 */
+int         tp_size(const ThreadPool* pool);
+
+/**
+ * @brief 并行执行 fn(ctx, i, worker)，i = 0..n-1；返回时全部任务已完成。
+ *
+ * 调用线程作为 0 号工作线程参与执行。pool 为 NULL 时串行执行。
+ */
+void        tp_parallel_for(ThreadPool* pool, size_t n, TpTaskFn fn, void* ctx);
+
+/** @brief 当前机器的逻辑 CPU 数（至少为 1）。 */
+int         tp_cpu_count(void);
+
+#endif //COURSEDESIGNTASKS_THREADPOOL_H
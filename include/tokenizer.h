@@ -5,21 +5,68 @@
 
 #include "std_token.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+// 标识符归一化方式
+typedef enum {
+    TK_IDENT_SEQUENTIAL = 0,    // 每次出现都分配递增编号 var_N（默认）
+    TK_IDENT_SCOPED             // 按作用域与首次出现顺序编号：局部 id_K、被调用/定义的函数 fn_K、文件作用域 gv_K
+} IdentMode;
+
+// 作用域模式下每个命名空间的编号上限：更多的名称共用溢出标签 id_* / fn_* / gv_*
+#define TK_SCOPE_MAX_IDS 64
+#define TK_SCOPE_SLOTS   128    // 开放寻址槽数（2 的幂，装载率不超过 1/2）
+
+// 作用域名称表的一个槽：名称以源码偏移记录，gen 与表的 gen 不同即视为空槽（清空只需 gen++）
+typedef struct {
+    uint32_t gen;
+    uint32_t off;
+    uint32_t len;
+    uint32_t id;
+} TkScopeSlot;
+
+typedef struct {
+    TkScopeSlot slots[TK_SCOPE_SLOTS];
+    uint32_t gen;
+    uint32_t count;
+} TkScopeTable;
 
 typedef struct {
     const char *source;     // 源代码
     const char *current;    // 当前位置
+    const char *end;        // 源码末尾（不含），扫描不依赖结尾的 '\0'
     int line;               // 当前行号
     int col;                // 当前列号
     int ident_counter;      // 标识符计数器，用于归一化
+
+    // 作用域模式（TK_IDENT_SCOPED）的状态
+    IdentMode ident_mode;
+    int brace_depth;        // '{' 嵌套深度
+    int paren_depth;        // 顶层 '(' 嵌套深度（形参表）
+    TkScopeTable scopes[3]; // 局部 / 函数名 / 文件作用域
 } Tokenizer;
 
-// 初始化tokenizer
+// 初始化tokenizer（source 以 '\0' 结尾）
 void tokenizer_init(Tokenizer *tk, const char *source);
 
+// 以 (指针, 长度) 初始化tokenizer，可直接扫描只读内存映射
+void tokenizer_init_n(Tokenizer *tk, const char *source, size_t len);
+
+// 设置标识符归一化方式（须在取第一个 token 之前调用）
+// 作用域模式下局部表在每个顶层声明结束时清空，函数名与文件作用域名在整个文件内编号不变，
+// 因此分析结果依赖全文件的先后顺序，不能按区域切开后分别分析
+void tokenizer_set_ident_mode(Tokenizer *tk, IdentMode mode);
+
 // 获取下一个token
 Token* tokenizer_next_token(Tokenizer *tk);
 
+// 获取下一个紧凑token（零拷贝：raw 为源码偏移，lex 驻留到 lexes）
+bool tokenizer_next_ref(Tokenizer *tk, SymTab *lexes, TokenRef *out);
+
+// 一次性切分整段源码为连续的 TokenRef 数组（不含 EOF，用 token_array_free 释放）
+bool tokenize_to_array(const char *source, SymTab *lexes, TokenArray *out);
+bool tokenize_to_array_n(const char *source, size_t len, SymTab *lexes, TokenArray *out);
+
 // 检查是否到达文件末尾
 bool tokenizer_is_eof(Tokenizer *tk);
 
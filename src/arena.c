@@ -0,0 +1,113 @@
+/**
+* @file arena.c
+ * @brief 区域（bump）分配器的实现。
+ *
+ * 块以链表串联；当前块空间不足时申请新块（超大请求单独成块），
+ * 释放时沿链表逐块 free。
+ */
+
+#include "../include/arena.h"
+#include "../include/stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_DEFAULT_BLOCK (64u * 1024u)
+#define ARENA_ALIGN         16u
+
+struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t cap;
+    size_t pad_;            // 使 data 起始地址按 16 字节对齐
+    unsigned char data[];
+};
+
+/**
+ * @brief 初始化区域分配器（不预先申请内存）。
+ */
+void arena_init(Arena* a, size_t block_size) {
+    a->head = NULL;
+    a->block_size = block_size ? block_size : ARENA_DEFAULT_BLOCK;
+    a->reserved = 0;
+}
+
+/**
+ * @brief 从当前块尾部切出 size 字节；不够则新开一块。
+ */
+void* arena_alloc(Arena* a, size_t size) {
+    if (!a) return NULL;
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (size == 0) size = ARENA_ALIGN;
+
+    ArenaBlock* b = a->head;
+    if (!b || b->cap - b->used < size) {
+        const size_t cap = size > a->block_size ? size : a->block_size;
+        ArenaBlock* nb = (ArenaBlock*)malloc(sizeof(ArenaBlock) + cap);
+        if (!nb) return NULL;
+        nb->next = b;
+        nb->used = 0;
+        nb->cap = cap;
+        a->head = nb;
+        a->reserved += sizeof(ArenaBlock) + cap;
+        STATS_ADD(ST_ALLOC_BYTES, sizeof(ArenaBlock) + cap);
+        b = nb;
+    }
+    void* p = b->data + b->used;
+    b->used += size;
+    return p;
+}
+
+char* arena_strndup(Arena* a, const char* s, size_t len) {
+    if (!s) return NULL;
+    char* p = (char*)arena_alloc(a, len + 1);
+    if (!p) return NULL;
+    memcpy(p, s, len);
+    p[len] = '\0';
+    return p;
+}
+
+char* arena_strdup(Arena* a, const char* s) {
+    if (!s) return NULL;
+    return arena_strndup(a, s, strlen(s));
+}
+
+/**
+ * @brief 清空区域：保留一个标准大小的块（清零已用量），其余块归还系统。
+ *
+ * 用于“分配一批 -> 处理 -> 全部作废”的循环，避免每轮重新 malloc 首块。
+ */
+void arena_reset(Arena* a) {
+    if (!a) return;
+    ArenaBlock* keep = NULL;
+    ArenaBlock* b = a->head;
+    while (b) {
+        ArenaBlock* next = b->next;
+        if (!keep && b->cap == a->block_size) keep = b;
+        else free(b);
+        b = next;
+    }
+    a->head = keep;
+    a->reserved = 0;
+    if (keep) {
+        keep->next = NULL;
+        keep->used = 0;
+        a->reserved = sizeof(ArenaBlock) + keep->cap;
+    }
+}
+
+/**
+ * @brief 释放全部块；区域回到初始化后的状态。
+ *
+ * @param a 目标区域；可为 NULL。
+ */
+void arena_free(Arena* a) {
+    if (!a) return;
+    ArenaBlock* b = a->head;
+    while (b) {
+        ArenaBlock* next = b->next;
+        free(b);
+        b = next;
+    }
+    a->head = NULL;
+    a->reserved = 0;
+}
@@ -48,6 +48,11 @@ ASTNode *ast_new(ASTKind kind, const char* text) {
     n->children = NULL;
     n->child_count = 0;
     n->child_cap = 0;
+    n->arena = NULL;
+    n->hash = 0;
+    n->line = 0;
+    n->col = 0;
+    n->serial_len = 0;
 
     if (text && !n->text) {
         free(n);
@@ -56,10 +61,42 @@ ASTNode *ast_new(ASTKind kind, const char* text) {
     return n;
 }
 
+/**
+ * @brief 在区域分配器中创建 AST 节点（节点、text 均由 arena 持有）。
+ *
+ * 大规模输入上逐节点 malloc/xstrdup 是解析的主要开销；区域模式下分配只是指针前移，
+ * 整棵树随 arena_free 一次性释放。
+ *
+ * @param arena 区域分配器；为 NULL 时退回堆分配（ast_new）。
+ * @param kind  节点类别。
+ * @param text  可选文本（会复制到 arena 中）。
+ * @return 成功返回新节点；失败返回 NULL。
+ */
+ASTNode *ast_new_in(Arena* arena, ASTKind kind, const char* text) {
+    if (!arena) return ast_new(kind, text);
+
+    ASTNode* n = (ASTNode*)arena_alloc(arena, sizeof(ASTNode));
+    if (!n) return NULL;
+    n->kind = kind;
+    n->text = text ? arena_strdup(arena, text) : NULL;
+    n->children = NULL;
+    n->child_count = 0;
+    n->child_cap = 0;
+    n->arena = arena;
+    n->hash = 0;
+    n->line = 0;
+    n->col = 0;
+    n->serial_len = 0;
+
+    if (text && !n->text) return NULL;
+    return n;
+}
+
 /**
  * @brief 将 child 追加到 parent 的 children 动态数组中。
  *
  * 采用“容量不足则倍增”的策略摊还 O(1) 追加，便于构建任意分叉度的树结构。
+ * 区域模式下新数组从 arena 中分配并拷贝旧内容（旧数组随 arena 一并释放）。
  *
  * @param parent 父节点（非 NULL）。
  * @param child  子节点（非 NULL）。
@@ -69,8 +106,15 @@ bool ast_add_child(ASTNode* parent, ASTNode* child) {
     if (!parent || !child) return false;
     if (parent->child_count == parent->child_cap) {
         size_t new_cap = (parent->child_cap == 0) ? 4 : (parent->child_cap * 2);
-        ASTNode **new_child = (ASTNode**)realloc(parent->children, new_cap * sizeof(ASTNode*));
-        if (!new_child) return false;
+        ASTNode **new_child;
+        if (parent->arena) {
+            new_child = (ASTNode**)arena_alloc(parent->arena, new_cap * sizeof(ASTNode*));
+            if (!new_child) return false;
+            if (parent->child_count) memcpy(new_child, parent->children, parent->child_count * sizeof(ASTNode*));
+        } else {
+            new_child = (ASTNode**)realloc(parent->children, new_cap * sizeof(ASTNode*));
+            if (!new_child) return false;
+        }
         parent->children = new_child;
         parent->child_cap = new_cap;
     }
@@ -79,22 +123,60 @@ bool ast_add_child(ASTNode* parent, ASTNode* child) {
 }
 
 /**
- * @brief 递归释放一棵 AST（后序释放）。
- *
- * @param node 根节点；可为 NULL。
- *
- * @note 释放顺序：先递归 children，再释放 children 数组、text、节点本体。
+ * @brief 递归释放一棵 AST（ast_free 显式栈扩容失败时的退路）。
  */
-void ast_free(ASTNode* node) {
+static void ast_free_recursive(ASTNode* node) {
     if (!node) return;
     for (size_t i = 0; i < node->child_count; i++) {
-        ast_free(node->children[i]);
+        ast_free_recursive(node->children[i]);
     }
     free(node->children);
     free(node->text);
     free(node);
 }
 
+/** @brief ast_free 显式栈的内置容量。 */
+#define FREE_INLINE_NODES 64
+
+/**
+ * @brief 释放一棵 AST（显式栈，不受嵌套深度限制）。
+ *
+ * @param node 根节点；可为 NULL。
+ *
+ * @note 弹出一个节点时先把其子节点压栈，再释放 children 数组、text 与节点本体；
+ *       栈先用内置数组，不够时才倍增到堆上（扩容失败则对剩余子树改用递归释放）。
+ *       区域模式的节点由 arena_free 统一释放，这里直接返回。
+ */
+void ast_free(ASTNode* node) {
+    if (!node || node->arena) return;
+
+    ASTNode* local[FREE_INLINE_NODES];
+    ASTNode** stack = local;
+    size_t size = 0, cap = FREE_INLINE_NODES;
+    stack[size++] = node;
+
+    while (size > 0) {
+        ASTNode* n = stack[--size];
+        for (size_t i = 0; i < n->child_count; i++) {
+            ASTNode* c = n->children[i];
+            if (!c) continue;
+            if (size == cap) {
+                ASTNode** grown = (ASTNode**)malloc(cap * 2 * sizeof(ASTNode*));
+                if (!grown) { ast_free_recursive(c); continue; }
+                memcpy(grown, stack, size * sizeof(ASTNode*));
+                if (stack != local) free(stack);
+                stack = grown;
+                cap *= 2;
+            }
+            stack[size++] = c;
+        }
+        free(n->children);
+        free(n->text);
+        free(n);
+    }
+    if (stack != local) free(stack);
+}
+
 /**
  * @brief 将 ASTKind 枚举转换为可读字符串（用于调试/序列化标签）。
  *
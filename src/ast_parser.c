@@ -6,37 +6,111 @@
  * 该解析器并不追求完整覆盖 C 语法，而是面向课程设计的相似度检测场景做取舍。
  */
 #include "../include/ast_parser.h"
+#include "../include/stats.h"
 #include <string.h>
 #include <stdlib.h>
 
 typedef struct {
-    Token* const* toks;
+    const TokenRef* toks;   // 连续存放的紧凑 token（数组模式）
     size_t ntoks;
-    size_t pos;
+    size_t pos;             // 当前 token 的绝对下标
+    const SymTab* lexes;    // token lex ID 所属的符号表
+    Arena* arena;           // 非 NULL 时所有节点分配在此区域中
+
+    // 流式模式（pull 非 NULL）：token 按需拉取，只在环形缓冲中保留前瞻窗口
+    TokenPullFn pull;
+    void* pull_ctx;
+    TokenRef* ring;         // 环形缓冲（容量为 2 的幂，前瞻超出时倍增）
+    size_t ring_cap;
+    size_t ring_base;       // ring 中最早一个 token 的绝对下标
+    size_t ring_count;      // ring 中已缓存的 token 数
+    int at_end;             // 已拉到 EOF（或拉取失败），不再调用 pull
+    int failed;             // 拉取或扩容失败
+
+    size_t serial_count;    // 已创建节点的序列化长度之和（每节点进/出两项，带文本的叶子再加一项）
+    size_t node_count;      // 已创建的节点数（解析结束时计入运行统计）
 } Parser;
 
+/**
+ * @brief 流式模式：向环形缓冲尾部再拉取一个 token。
+ *
+ * 缓冲满时先丢弃 pos 之前已消费的 token（保留紧邻的上一个，
+ * 供 consume 的返回值继续使用），仍不够则容量倍增。
+ *
+ * @return 成功拉到新 token 返回 1；已到 EOF 或出错返回 0。
+ */
+static int ring_fill(Parser* p) {
+    if (p->at_end) return 0;
+
+    const size_t keep_from = p->pos > 0 ? p->pos - 1 : 0;
+    if (keep_from > p->ring_base) {
+        const size_t drop = keep_from - p->ring_base;
+        p->ring_base += drop;
+        p->ring_count -= drop;
+    }
+
+    if (p->ring_count == p->ring_cap) {
+        const size_t nc = p->ring_cap ? p->ring_cap * 2 : 64;
+        TokenRef* nr = (TokenRef*)malloc(nc * sizeof(TokenRef));
+        if (!nr) { p->failed = 1; p->at_end = 1; return 0; }
+        for (size_t i = 0; i < p->ring_count; i++) {
+            const size_t abs = p->ring_base + i;
+            nr[abs & (nc - 1)] = p->ring[abs & (p->ring_cap - 1)];
+        }
+        free(p->ring);
+        p->ring = nr;
+        p->ring_cap = nc;
+    }
+
+    TokenRef* slot = &p->ring[(p->ring_base + p->ring_count) & (p->ring_cap - 1)];
+    if (!p->pull(p->pull_ctx, slot)) { p->failed = 1; p->at_end = 1; return 0; }
+    p->ring_count++;
+    if (slot->type == TOKEN_EOF) p->at_end = 1;
+    return 1;
+}
+
+/**
+ * @brief 按解析器的分配方式创建节点，并记录 token t 的行列号（t 为 NULL 时记 0）。
+ */
+static ASTNode* node_at(Parser* p, ASTKind kind, const char* text, const TokenRef* t) {
+    ASTNode* n = ast_new_in(p->arena, kind, text);
+    if (!n) return NULL;
+    if (t) { n->line = t->line; n->col = t->col; }
+    p->serial_count += (kind == AST_TOKEN && text) ? 3 : 2;
+    p->node_count++;
+    return n;
+}
+
 /**
  * @brief 向前查看 offset 个 token（不移动指针）。
  *
+ * 流式模式下返回的指针指向环形缓冲，在下一次需要拉取新 token 的 peek 之前有效。
+ *
  * @param p      解析器状态。
  * @param offset 偏移量（0 表示当前 token）。
  * @return token 指针；越界返回 NULL。
  */
-static Token* peek(Parser* p, size_t offset) {
+static const TokenRef* peek(Parser* p, size_t offset) {
     size_t i = p->pos + offset;
-    if (i >= p->ntoks) return NULL;
-    return p->toks[i];
+    if (!p->pull) {
+        if (i >= p->ntoks) return NULL;
+        return &p->toks[i];
+    }
+    while (i >= p->ring_base + p->ring_count) {
+        if (!ring_fill(p)) return NULL;
+    }
+    return &p->ring[i & (p->ring_cap - 1)];
 }
 
 /**
  * @brief 获取当前 token（peek(p,0) 的便捷封装）。
  */
-static Token* cur(Parser* p) { return peek(p, 0); }
+static const TokenRef* cur(Parser* p) { return peek(p, 0); }
 
 /**
  * @brief 判断 token 是否为 EOF（或 NULL）。
  */
-static int is_eof(Token* t) { return t == NULL || t->type == TOKEN_EOF; }
+static int is_eof(const TokenRef* t) { return t == NULL || t->type == TOKEN_EOF; }
 
 /**
  * @brief 读取并消费一个 token（将 pos 前移）。
@@ -44,24 +118,42 @@ static int is_eof(Token* t) { return t == NULL || t->type == TOKEN_EOF; }
  * @param p 解析器状态。
  * @return 被消费的 token；若已到 EOF 则返回当前/NULL。
  */
-static Token* consume(Parser* p) {
-    Token* t = cur(p);
+static const TokenRef* consume(Parser* p) {
+    const TokenRef* t = cur(p);
     if (!is_eof(t)) p->pos ++;
     return t;
 }
 
+/**
+ * @brief 创建节点，位置取当前 token（结构从当前 token 开始时使用）。
+ */
+static ASTNode* node_new(Parser* p, ASTKind kind, const char* text) { return node_at(p, kind, text, cur(p)); }
+
+/**
+ * @brief 取 token 的归一化文本（lex ID 反查）；无 lex 时返回 NULL。
+ */
+static const char* tok_lex(Parser* p, const TokenRef* t) { return symtab_name(p->lexes, t->lex); }
+
 /**
  * @brief 判断当前 token 是否为指定关键字。
  */
-static int is_kw(Token* t, KeywordKind kw) { return t && t->type == TK_KEYWORD && t->kw == kw; }
+static int is_kw(const TokenRef* t, KeywordKind kw) { return t && t->type == TK_KEYWORD && t->kw == kw; }
 /**
  * @brief 判断当前 token 是否为指定标点（分隔符），如 "(", "{", ";" 等。
  */
-static int is_punc(Token* t, const char* s) { return t && t->type == TK_PUNCTUATION && t->lex && strcmp(t->lex, s) == 0; }
+static int is_punc(Parser* p, const TokenRef* t, const char* s) {
+    if (!t || t->type != TK_PUNCTUATION) return 0;
+    const char* lex = tok_lex(p, t);
+    return lex && strcmp(lex, s) == 0;
+}
 /**
  * @brief 判断当前 token 是否为指定运算符，如 "+", "==" 等。
  */
-static int is_op(Token *t, const char* s) { return t && t->type == TK_OPERATOR && strcmp(t->lex, s) == 0; }
+static int is_op(Parser* p, const TokenRef* t, const char* s) {
+    if (!t || t->type != TK_OPERATOR) return 0;
+    const char* lex = tok_lex(p, t);
+    return lex && strcmp(lex, s) == 0;
+}
 
 /**
  * @brief 将关键字枚举映射为稳定的标签字符串（用于 AST_TOKEN 叶子）。
@@ -94,21 +186,22 @@ static const char* kw_label(KeywordKind kw) {
  * - 常量：统一为 NUM/STR/CHR；
  * - 运算符与分隔符：直接用其字面量。
  */
-static const char* token_label(Token* t) {
+static const char* token_label(Parser* p, const TokenRef* t) {
     if (!t)                                                                 return "NULL";
+    const char* lex = tok_lex(p, t);
     if (t->type == TK_KEYWORD)                                              return kw_label(t->kw);
-    if (t->type == TK_IDENT)                                                return t->lex ? t->lex : "ID";
+    if (t->type == TK_IDENT)                                                return lex ? lex : "ID";
     if (t->type == TK_NUMBER)                                               return "NUM";
     if (t->type == TK_STRING)                                               return "STR";
     if (t->type == TK_CHAR)                                                 return "CHR";
-    if ((t->type == TK_OPERATOR || t->type == TK_PUNCTUATION) && t->lex)    return t->lex;
+    if ((t->type == TK_OPERATOR || t->type == TK_PUNCTUATION) && lex)       return lex;
     return "TOK";
 }
 
 /**
  * @brief 将一个 Token 包装成 AST_TOKEN 叶子节点。
  */
-static ASTNode* leaf_from_token(Token* t) { return ast_new(AST_TOKEN, token_label(t)); }
+static ASTNode* leaf_from_token(Parser* p, const TokenRef* t) { return node_at(p, AST_TOKEN, token_label(p, t), t); }
 static ASTNode* parse_statement(Parser* p);
 static ASTNode* parse_block(Parser* p);
 
@@ -123,24 +216,22 @@ static ASTNode* parse_block(Parser* p);
  */
 static ASTNode* parse_paren_expr(Parser* p) {
     // (...) -> child of expr
-    if (!is_punc(cur(p), "(")) return NULL;
-    consume(p); // '('
+    if (!is_punc(p, cur(p), "(")) return NULL;
+    const TokenRef* open = consume(p); // '('
 
-    ASTNode* expr = ast_new(AST_EXPR, NULL);
+    ASTNode* expr = node_at(p, AST_EXPR, NULL, open);
     if (!expr) return NULL;
 
     int depth = 1;
     while (!is_eof(cur(p)) && depth > 0) {
-        Token* t = consume(p);
+        const TokenRef* t = consume(p);
         if (!t) break;
 
-        if (t->type == TK_PUNCTUATION && t->lex) {
-            if (strcmp(t->lex, ")") == 0) {
-                depth --;
-                if (depth == 0) break;
-            }
+        if (is_punc(p, t, ")")) {
+            depth --;
+            if (depth == 0) break;
         }
-        ASTNode* lf = leaf_from_token(t);
+        ASTNode* lf = leaf_from_token(p, t);
         if (!lf || !ast_add_child(expr, lf)) {
             ast_free(lf);
             ast_free(expr);
@@ -162,32 +253,32 @@ static ASTNode* parse_paren_expr(Parser* p) {
  * - 在 block 边界 '{' 或 '}' 处停止，避免跨语句吞噬。
  */
 static ASTNode* parse_until_semicolon(Parser* p, ASTKind kind) {
-    ASTNode* st = ast_new(kind, NULL);
+    ASTNode* st = node_new(p, kind, NULL);
     if (!st) return NULL;
 
     int par = 0, brk = 0; // () []
     while (!is_eof(cur(p))) {
-        Token* t = cur(p);
+        const TokenRef* t = cur(p);
 
-        if (is_punc(t, "(")) par ++;
-        else if (is_punc(t, ")")) { if (par > 0) par --; }
+        if (is_punc(p, t, "(")) par ++;
+        else if (is_punc(p, t, ")")) { if (par > 0) par --; }
 
-        if (is_punc(t, "[")) brk ++;
-        else if (is_punc(t, "]")) { if (brk > 0) brk --; }
+        if (is_punc(p, t, "[")) brk ++;
+        else if (is_punc(p, t, "]")) { if (brk > 0) brk --; }
 
-        if (par == 0 && brk == 0 && is_punc(t, ";")) {
+        if (par == 0 && brk == 0 && is_punc(p, t, ";")) {
             consume(p);
             break;
         }
-        if (par == 0 && brk == 0 && is_punc(t, "{")) {
+        if (par == 0 && brk == 0 && is_punc(p, t, "{")) {
             break;
         }
-        if (par == 0 && brk == 0 && is_punc(t, "}")) {
+        if (par == 0 && brk == 0 && is_punc(p, t, "}")) {
             break;
         }
 
         consume(p);
-        ASTNode* lf = leaf_from_token(t);
+        ASTNode* lf = leaf_from_token(p, t);
         if (!lf || !ast_add_child(st, lf)) {
             ast_free(lf);
             ast_free(st);
@@ -201,8 +292,8 @@ static ASTNode* parse_until_semicolon(Parser* p, ASTKind kind) {
  * @brief 解析 if 语句：IF + 条件括号 + then 语句 + 可选 else 分支。
  */
 static ASTNode* parse_if(Parser *p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_IF, NULL);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_IF, NULL, kw);
     if (!n) return NULL;
 
     ASTNode* cond = parse_paren_expr(p);
@@ -212,8 +303,8 @@ static ASTNode* parse_if(Parser *p) {
     if (then_st) ast_add_child(n, then_st);
 
     if (is_kw(cur(p), KW_ELSE)) {
-        consume(p);
-        ASTNode* else_node = ast_new(AST_BLOCK, "ELSE");
+        const TokenRef* else_kw = consume(p);
+        ASTNode* else_node = node_at(p, AST_BLOCK, "ELSE", else_kw);
         if (!else_node) { ast_free(n); return NULL; }
         ASTNode* else_st = parse_statement(p);
         if (else_st) ast_add_child(else_node, else_st);
@@ -226,8 +317,8 @@ static ASTNode* parse_if(Parser *p) {
  * @brief 解析 for 语句：FOR + 头部括号 + 循环体语句。
  */
 static ASTNode* parse_for(Parser *p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_FOR, NULL);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_FOR, NULL, kw);
     if (!n) return NULL;
 
     ASTNode* head = parse_paren_expr(p);
@@ -242,8 +333,8 @@ static ASTNode* parse_for(Parser *p) {
  * @brief 解析 while 语句：WHILE + 条件括号 + 循环体语句。
  */
 static ASTNode* parse_while(Parser *p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_WHILE, NULL);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_WHILE, NULL, kw);
     if (!n) return NULL;
 
     ASTNode* cond = parse_paren_expr(p);
@@ -258,8 +349,8 @@ static ASTNode* parse_while(Parser *p) {
  * @brief 解析 do-while 语句：DO + 循环体语句 + WHILE(条件) + ';'。
  */
 static ASTNode* parse_do_while(Parser* p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_DO_WHILE, NULL);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_DO_WHILE, NULL, kw);
     if (!n) return NULL;
 
     ASTNode* body = parse_statement(p);
@@ -269,7 +360,7 @@ static ASTNode* parse_do_while(Parser* p) {
         consume(p);
         ASTNode* cond = parse_paren_expr(p);
         if (cond) ast_add_child(n, cond);
-        if (is_punc(cur(p), ";")) consume(p);
+        if (is_punc(p, cur(p), ";")) consume(p);
     }
     return n;
 }
@@ -278,8 +369,8 @@ static ASTNode* parse_do_while(Parser* p) {
  * @brief 解析 switch 语句：SWITCH + 条件括号 + 语句体（通常是 block）。
  */
 static ASTNode* parse_switch(Parser *p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_SWITCH, NULL);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_SWITCH, NULL, kw);
     if (!n) return NULL;
 
     ASTNode* cond = parse_paren_expr(p);
@@ -298,29 +389,29 @@ static ASTNode* parse_switch(Parser *p) {
  * - ':' 之后直到遇到下一个 case/default 或 '}' 为止，作为 CASE BODY。
  */
 static ASTNode* parse_case(Parser *p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_CASE, NULL);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_CASE, NULL, kw);
     if (!n) return NULL;
 
-    ASTNode* expr = ast_new(AST_EXPR, NULL);
+    ASTNode* expr = node_new(p, AST_EXPR, NULL);
     if (!expr) return NULL;
 
-    while (!is_eof(cur(p)) && !is_punc(cur(p), ":") && !is_punc(cur(p), "{") && !is_punc(cur(p), "}")) {
-        Token* t = consume(p);
-        ASTNode* lf = leaf_from_token(t);
+    while (!is_eof(cur(p)) && !is_punc(p, cur(p), ":") && !is_punc(p, cur(p), "{") && !is_punc(p, cur(p), "}")) {
+        const TokenRef* t = consume(p);
+        ASTNode* lf = leaf_from_token(p, t);
         if (!lf || !ast_add_child(expr, lf)) {
             ast_free(lf);
             ast_free(expr);
             return NULL;
         }
     }
-    if (is_punc(cur(p), ":")) consume(p);
+    if (is_punc(p, cur(p), ":")) consume(p);
     ast_add_child(n, expr);
 
-    ASTNode* body = ast_new(AST_BLOCK, "CASE BODY");
+    ASTNode* body = node_new(p, AST_BLOCK, "CASE BODY");
     if (!body) return NULL;
 
-    while (!is_eof(cur(p)) && !is_kw(cur(p), KW_CASE) && !is_kw(cur(p), KW_DEFAULT) && !is_punc(cur(p), "}")) {
+    while (!is_eof(cur(p)) && !is_kw(cur(p), KW_CASE) && !is_kw(cur(p), KW_DEFAULT) && !is_punc(p, cur(p), "}")) {
         ASTNode* st = parse_statement(p);
         if (st) ast_add_child(body, st);
         else consume(p);
@@ -333,15 +424,15 @@ static ASTNode* parse_case(Parser *p) {
  * @brief 解析 default 分支：DEFAULT + ':' + 分支体语句序列。
  */
 static ASTNode* parse_default(Parser *p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_DEFAULT, NULL);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_DEFAULT, NULL, kw);
     if (!n) return NULL;
-    if (is_punc(cur(p), ":")) consume(p);
+    if (is_punc(p, cur(p), ":")) consume(p);
 
-    ASTNode* body = ast_new(AST_BLOCK, "DEFAULT BODY");
+    ASTNode* body = node_new(p, AST_BLOCK, "DEFAULT BODY");
     if (!body) { ast_free(n); return NULL; }
 
-    while (!is_eof(cur(p)) && !is_kw(cur(p), KW_CASE) && !is_kw(cur(p), KW_DEFAULT) && !is_punc(cur(p), "}")) {
+    while (!is_eof(cur(p)) && !is_kw(cur(p), KW_CASE) && !is_kw(cur(p), KW_DEFAULT) && !is_punc(p, cur(p), "}")) {
         ASTNode* st = parse_statement(p);
         if (st) ast_add_child(body, st);
         else consume(p);
@@ -354,8 +445,8 @@ static ASTNode* parse_default(Parser *p) {
  * @brief 解析 return：RETURN + 可选表达式片段（直到 ';'）。
  */
 static ASTNode* parse_return(Parser *p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_RETURN, NULL);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_RETURN, NULL, kw);
     if (!n) return NULL;
 
     ASTNode* expr = parse_until_semicolon(p, AST_EXPR);
@@ -367,9 +458,9 @@ static ASTNode* parse_return(Parser *p) {
  * @brief 解析 break 语句（可选消费 ';'）。
  */
 static ASTNode* parse_break(Parser* p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_BREAK, NULL);
-    if (is_punc(cur(p), ";")) consume(p);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_BREAK, NULL, kw);
+    if (is_punc(p, cur(p), ";")) consume(p);
     return n;
 }
 
@@ -377,9 +468,9 @@ static ASTNode* parse_break(Parser* p) {
  * @brief 解析 continue 语句（可选消费 ';'）。
  */
 static ASTNode* parse_continue(Parser* p) {
-    consume(p);
-    ASTNode* n = ast_new(AST_CONTINUE, NULL);
-    if (is_punc(cur(p), ";")) consume(p);
+    const TokenRef* kw = consume(p);
+    ASTNode* n = node_at(p, AST_CONTINUE, NULL, kw);
+    if (is_punc(p, cur(p), ";")) consume(p);
     return n;
 }
 
@@ -387,19 +478,19 @@ static ASTNode* parse_continue(Parser* p) {
  * @brief 解析代码块 "{ ... }" 为 AST_BLOCK，内部递归解析若干 statement。
  */
 static ASTNode* parse_block(Parser *p) {
-    if (!is_punc(cur(p), "{")) return NULL;
-    consume(p); // '{'
+    if (!is_punc(p, cur(p), "{")) return NULL;
+    const TokenRef* open = consume(p); // '{'
 
-    ASTNode* b = ast_new(AST_BLOCK, NULL);
+    ASTNode* b = node_at(p, AST_BLOCK, NULL, open);
     if (!b) return NULL;
 
-    while (!is_eof(cur(p)) && !is_punc(cur(p), "}")) {
+    while (!is_eof(cur(p)) && !is_punc(p, cur(p), "}")) {
         ASTNode* st = parse_statement(p);
         if (st) ast_add_child(b, st);
         else consume(p);
     }
 
-    if (is_punc(cur(p), "}")) consume(p); // '}'
+    if (is_punc(p, cur(p), "}")) consume(p); // '}'
     return b;
 }
 
@@ -412,10 +503,10 @@ static ASTNode* parse_block(Parser *p) {
  * - 其他情况 -> 普通语句（直到 ';'）。
  */
 static ASTNode* parse_statement(Parser* p) {
-    Token* t = cur(p);
+    const TokenRef* t = cur(p);
     if (is_eof(t)) return NULL;
 
-    if (is_punc(t, "{")) return parse_block(p);
+    if (is_punc(p, t, "{")) return parse_block(p);
 
     if (is_kw(t, KW_IF)) return parse_if(p);
     if (is_kw(t, KW_FOR)) return parse_for(p);
@@ -442,25 +533,24 @@ static ASTNode* parse_statement(Parser* p) {
  * @return 像函数返回 1，否则 0。
  */
 static int looks_like_function(Parser* p) {
-    size_t i = p->pos;
+    size_t i = 0;
     int par = 0;
     int saw_l = 0, saw_r = 0;
 
-    while (i < p->ntoks) {
-        Token* t = p->toks[i];
+    for (;;) {
+        const TokenRef* t = peek(p, i);
         if (!t || t->type == TOKEN_EOF) return 0;
 
-        if (par == 0 && is_punc(t, ";")) return 0; // expr or indent
-        if (is_punc(t, "(")) { par ++; saw_l = 1; }
-        else if (is_punc(t, ")")) {
+        if (par == 0 && is_punc(p, t, ";")) return 0; // expr or indent
+        if (is_punc(p, t, "(")) { par ++; saw_l = 1; }
+        else if (is_punc(p, t, ")")) {
             if (par > 0) par --;
             if (par == 0 && saw_l) saw_r = 1;
-        } else if (par == 0 && is_punc(t, "{")) {
+        } else if (par == 0 && is_punc(p, t, "{")) {
             return saw_l && saw_r;
         }
         i ++;
     }
-    return 0;
 }
 
 /**
@@ -470,15 +560,15 @@ static int looks_like_function(Parser* p) {
  * 头部 token 统一收集到一个 AST_STMT("FUNC_HEADER") 子节点中。
  */
 static ASTNode* parse_function(Parser *p) {
-    ASTNode* fn = ast_new(AST_FUNCTION, NULL);
+    ASTNode* fn = node_new(p, AST_FUNCTION, NULL);
     if (!fn) return NULL;
 
-    ASTNode* header = ast_new(AST_STMT, "FUNC_HEADER");
+    ASTNode* header = node_new(p, AST_STMT, "FUNC_HEADER");
     if (!header) { ast_free(fn); return NULL; }
 
-    while (!is_eof(cur(p)) && !is_punc(cur(p), "{")) {
-        Token* t = consume(p);
-        ASTNode* lf = leaf_from_token(t);
+    while (!is_eof(cur(p)) && !is_punc(p, cur(p), "{")) {
+        const TokenRef* t = consume(p);
+        ASTNode* lf = leaf_from_token(p, t);
         if (!lf || !ast_add_child(header, lf)) {
             ast_free(lf);
             ast_free(header);
@@ -494,30 +584,135 @@ static ASTNode* parse_function(Parser *p) {
 }
 
 /**
- * @brief 解析 token 序列为 AST 根节点（AST_PROGRAM）。
+ * @brief 在已初始化的解析器上解析全部 token，生成 AST_PROGRAM 根节点。
+ */
+static ASTNode* parse_program(Parser* p) {
+    ASTNode* root = node_new(p, AST_PROGRAM, NULL);
+    if (!root) return NULL;
+
+    while (!is_eof(cur(p))) {
+        // 顶层多余的 '}'：单独跳过，不并入后面的函数头（否则 parse_statement 不前进）
+        if (is_punc(p, cur(p), "}")) { consume(p); continue; }
+        ASTNode* node = NULL;
+        if (looks_like_function(p)) node = parse_function(p);
+        else node = parse_statement(p);
+
+        if (node) ast_add_child(root, node);
+        else consume(p);
+    }
+    root->serial_len = p->serial_count;
+    STATS_ADD(ST_AST_NODES, p->node_count);
+    return root;
+}
+
+/**
+ * @brief 解析紧凑 token 数组为 AST 根节点（AST_PROGRAM）。
  *
  * 设计目标：为“代码相似度检测”提供结构化表示，而不是完整 C 语法。
  * 因此：
  * - 只对控制结构、函数、块做显式树节点；
  * - 其余部分以 token 叶子序列保留（对变量名归一化等更鲁棒）。
  *
+ * @param arr   tokenize_to_array 的输出（lex ID 属于 arr->lexes）。
+ * @param arena 区域分配器；为 NULL 时节点分配在堆上。
+ * @return AST 根节点；失败返回 NULL。
+ */
+ASTNode* ast_parse_token_array(const TokenArray* arr, Arena* arena) {
+    if (!arr) return NULL;
+    Parser p = { 0 };
+    p.toks = arr->data;
+    p.ntoks = arr->size;
+    p.lexes = arr->lexes;
+    p.arena = arena;
+    return parse_program(&p);
+}
+
+/**
+ * @brief 解析 token 序列为 AST 根节点（AST_PROGRAM）。
+ *
  * @param toks  token 指针数组（每个元素为 Token*）。
  * @param ntoks token 数量（包含 EOF）。
  * @return AST 根节点；失败返回 NULL。
  */
 ASTNode* ast_parse_tokens(Token* const* toks, size_t ntoks) {
-    Parser p = { toks, ntoks, 0 };
+    return ast_parse_tokens_arena(toks, ntoks, NULL);
+}
 
-    ASTNode* root = ast_new(AST_PROGRAM, NULL);
-    if (!root) return NULL;
+/**
+ * @brief 解析 token 序列为 AST，节点全部分配在 arena 中（arena 为 NULL 时用堆）。
+ *
+ * 兼容旧接口：先把 Token* 数组转换为临时的紧凑 TokenRef 数组（lex 驻留到临时符号表）再解析。
+ */
+ASTNode* ast_parse_tokens_arena(Token* const* toks, size_t ntoks, Arena* arena) {
+    SymTab lexes;
+    symtab_init(&lexes);
+    TokenRef* refs = (TokenRef*)malloc((ntoks ? ntoks : 1) * sizeof(TokenRef));
+
+    ASTNode* root = NULL;
+    if (!refs) goto done;
+    for (size_t i = 0; i < ntoks; i++) {
+        const Token* t = toks[i];
+        TokenRef r = { t->type, t->kw, SYM_NONE, 0, 0, t->line, t->col };
+        if (t->lex && !symtab_intern(&lexes, t->lex, &r.lex)) goto done;
+        refs[i] = r;
+    }
+
+    Parser p = { 0 };
+    p.toks = refs;
+    p.ntoks = ntoks;
+    p.lexes = &lexes;
+    p.arena = arena;
+    root = parse_program(&p);
 
-    while (!is_eof(cur(&p))) {
+done:
+    free(refs);
+    symtab_free(&lexes);
+    return root;
+}
+
+/**
+ * @brief 流式解析：按需拉取 token，每个顶层节点（函数或语句）完成后立即交给 emit。
+ *
+ * 顶层节点的划分与 parse_program 完全一致（等价于依次遍历 AST_PROGRAM 的子节点），
+ * 但 token 只在环形缓冲中保留前瞻窗口，AST 也只保留当前一个顶层子树：
+ * emit 返回后，arena 被 arena_reset（arena 为 NULL 时对节点 ast_free）。
+ * 峰值内存因此取决于最大的函数，而不是整份源码。
+ *
+ * @param pull     token 来源；在 EOF 处产出 TOKEN_EOF。
+ * @param lexes    拉取到的 token lex ID 所属的符号表（可在拉取过程中增长）。
+ * @param arena    顶层子树的分配区域；可为 NULL。
+ * @param emit     顶层节点回调；返回 false 时终止解析。
+ * @return 全部成功返回 true；拉取失败、内存不足或 emit 失败返回 false。
+ */
+bool ast_parse_stream(TokenPullFn pull, void* pull_ctx, const SymTab* lexes, Arena* arena,
+                      AstTopLevelFn emit, void* emit_ctx) {
+    if (!pull || !lexes || !emit) return false;
+
+    Parser p = { 0 };
+    p.lexes = lexes;
+    p.arena = arena;
+    p.pull = pull;
+    p.pull_ctx = pull_ctx;
+
+    bool ok = true;
+    while (ok && !is_eof(cur(&p))) {
+        if (is_punc(&p, cur(&p), "}")) { consume(&p); continue; }    // 同 parse_program
+        const size_t mark = p.serial_count;
         ASTNode* node = NULL;
         if (looks_like_function(&p)) node = parse_function(&p);
         else node = parse_statement(&p);
 
-        if (node) ast_add_child(root, node);
-        else consume(&p);
+        if (node) {
+            node->serial_len = p.serial_count - mark;
+            ok = emit(emit_ctx, node);
+            if (arena) arena_reset(arena);
+            else ast_free(node);
+        } else {
+            consume(&p);
+        }
     }
-    return root;
-}
\ No newline at end of file
+
+    free(p.ring);
+    STATS_ADD(ST_AST_NODES, p.node_count);
+    return ok && !p.failed;
+}
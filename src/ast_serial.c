@@ -7,6 +7,7 @@
  */
 
 #include "../include/ast_serial.h"
+#include "../include/stats.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -81,35 +82,121 @@ void sv_free(StrVec* v) {
     v->cap = 0;
 }
 
+/**
+ * @brief 显式栈的一帧：节点及下一个待访问子节点的下标。
+ */
+typedef struct {
+    const ASTNode* node;
+    size_t         next;
+} WalkFrame;
+
+/** @brief 栈内置容量：常见嵌套深度内不做堆分配。 */
+#define WALK_INLINE_DEPTH 64
+
+/**
+ * @brief 前序遍历用的显式栈（先用内置数组，更深时才扩到堆上），避免深层嵌套输入耗尽调用栈。
+ */
+typedef struct {
+    WalkFrame  local[WALK_INLINE_DEPTH];
+    WalkFrame* data;
+    size_t     size;
+    size_t     cap;
+} WalkStack;
+
+static void walk_init(WalkStack* st) {
+    st->data = st->local;
+    st->size = 0;
+    st->cap = WALK_INLINE_DEPTH;
+}
+
+static void walk_free(WalkStack* st) {
+    if (st->data != st->local) free(st->data);
+    walk_init(st);
+}
+
+static bool walk_push(WalkStack* st, const ASTNode* n) {
+    if (st->size == st->cap) {
+        const size_t nc = st->cap * 2;
+        WalkFrame* p = (WalkFrame*)malloc(nc * sizeof(WalkFrame));
+        if (!p) return false;
+        memcpy(p, st->data, st->size * sizeof(WalkFrame));
+        if (st->data != st->local) free(st->data);
+        st->data = p;
+        st->cap = nc;
+    }
+    st->data[st->size].node = n;
+    st->data[st->size].next = 0;
+    st->size++;
+    return true;
+}
+
+/**
+ * @brief 预留容量的目标值：至少 need，且不小于当前容量的两倍（逐个顶层子树预留时仍保持倍增摊还）。
+ */
+static size_t grow_cap(size_t cap, size_t need) {
+    if (need <= cap) return cap;
+    return need > cap * 2 ? need : cap * 2;
+}
+
+/**
+ * @brief 预先分配 StrVec 指针数组容量（字符串本身仍由 sv_push 复制）。
+ */
+static bool sv_reserve(StrVec* v, size_t cap) {
+    if (cap <= v->cap) return true;
+    char** p = (char**)realloc(v->data, cap * sizeof(char*));
+    if (!p) return false;
+    v->data = p;
+    v->cap = cap;
+    return true;
+}
+
 /**
  * @brief 将 AST 以“前序遍历 + 进/出栈标签”的方式序列化为字符串序列。
  *
  * 输出格式示例（伪 XML）：
  *   <IF> <EXPR> ... </EXPR> <BLOCK> ... </BLOCK> </IF>
  *
- * @param n   当前节点；可为 NULL（视为成功，不输出）。
- * @param out 输出向量（StrVec），保存序列化后的 token 序列。
+ * 进/出标签每种 ASTKind 只格式化一次；遍历使用显式栈。
+ *
+ * @param root 根节点；可为 NULL（视为成功，不输出）。
+ * @param out  输出向量（StrVec），保存序列化后的 token 序列。
  * @return 成功返回 true；失败返回 false。
  */
-static bool emit_node(const ASTNode* n, StrVec* out) {
-    if (!n) return true;
+static bool emit_tree(const ASTNode* root, StrVec* out) {
+    if (!root) return true;
 
-    char buf[64];
-    snprintf(buf, sizeof(buf), "<%s>", ast_kind_name(n->kind));
-    if (!sv_push(out, buf)) return false;
-
-    if (n->kind == AST_TOKEN && n->text) {
-        if (!sv_push(out, n->text)) return false;
+    char open_tag[AST_KIND_COUNT][32], close_tag[AST_KIND_COUNT][32];
+    for (int k = 0; k < AST_KIND_COUNT; ++ k) {
+        snprintf(open_tag[k], sizeof(open_tag[k]), "<%s>", ast_kind_name((ASTKind)k));
+        snprintf(close_tag[k], sizeof(close_tag[k]), "</%s>", ast_kind_name((ASTKind)k));
     }
+    if (root->serial_len && !sv_reserve(out, grow_cap(out->cap, out->size + root->serial_len))) return false;
 
-    for (size_t i = 0; i < n->child_count; i ++) {
-        if (!emit_node(n->children[i], out)) return false;
+    WalkStack st;
+    walk_init(&st);
+    bool ok = true;
+    const ASTNode* n = root;
+    while (ok) {
+        if (n) {
+            // 进入节点：输出进入标签（及叶子文本）后压栈
+            if ((int)n->kind < 0 || n->kind >= AST_KIND_COUNT) { ok = false; break; }
+            ok = sv_push(out, open_tag[n->kind])
+                 && (n->kind != AST_TOKEN || !n->text || sv_push(out, n->text))
+                 && walk_push(&st, n);
+            n = NULL;
+            continue;
+        }
+        if (st.size == 0) break;
+        WalkFrame* top = &st.data[st.size - 1];
+        if (top->next < top->node->child_count) {
+            n = top->node->children[top->next++];
+        } else {
+            ok = sv_push(out, close_tag[top->node->kind]);
+            st.size--;
+        }
     }
-
-    snprintf(buf, sizeof(buf), "</%s>", ast_kind_name(n->kind));
-    if (!sv_push(out, buf)) return false;
-
-    return true;
+    walk_free(&st);
+    return ok;
 }
 
 /**
@@ -121,5 +208,161 @@ static bool emit_node(const ASTNode* n, StrVec* out) {
  */
 bool ast_serialize_preorder(const ASTNode* root, StrVec* out) {
     if (!root || !out) return false;
-    return emit_node(root, out);
-}
\ No newline at end of file
+    return emit_tree(root, out);
+}
+
+/**
+ * @brief 初始化行号序列。
+ */
+void linev_init(LineVec* v) {
+    v->data = NULL;
+    v->size = 0;
+    v->cap = 0;
+}
+
+/**
+ * @brief 预留至少 cap 个行号的容量。
+ */
+bool linev_reserve(LineVec* v, size_t cap) {
+    if (!v) return false;
+    if (cap <= v->cap) return true;
+    uint32_t* p = (uint32_t*)realloc(v->data, cap * sizeof(uint32_t));
+    if (!p) return false;
+    STATS_ADD(ST_ALLOC_BYTES, (cap - v->cap) * sizeof(uint32_t));
+    v->data = p;
+    v->cap = cap;
+    return true;
+}
+
+/**
+ * @brief 追加一个行号（容量不足则倍增）。
+ */
+bool linev_push(LineVec* v, uint32_t line) {
+    if (!v) return false;
+    if (v->size == v->cap && !linev_reserve(v, (v->cap == 0) ? 64 : v->cap * 2)) return false;
+    v->data[v->size++] = line;
+    return true;
+}
+
+/**
+ * @brief 释放行号序列。
+ *
+ * @param v 目标序列；可为 NULL。
+ */
+void linev_free(LineVec* v) {
+    if (!v) return;
+    free(v->data);
+    linev_init(v);
+}
+
+/**
+ * @brief 输出一个符号；记录行号时 line 为 0 表示沿用前一项的行（序列开头记为第 1 行）。
+ */
+static bool emit_sym(SymEmitter* em, SymId id, int line) {
+    if (!symv_push(em->out, id)) return false;
+    if (!em->lines) return true;
+    if (line <= 0) line = em->lines->size ? (int)em->lines->data[em->lines->size - 1] : 1;
+    return linev_push(em->lines, (uint32_t)line);
+}
+
+/**
+ * @brief emit_tree 的符号版本：输出顺序与字符串版完全一致。
+ *
+ * 标签已在 sym_emitter_init 中驻留；解析器记录了子树的序列化长度时先一次性预留输出容量，
+ * 之后每个节点只做数组写入（叶子文本需查一次符号表），不再有逐节点的分配。
+ */
+static bool emit_node_sym(const ASTNode* root, SymEmitter* em) {
+    if (!root) return true;
+    if (root->serial_len) {
+        if (!symv_reserve(em->out, grow_cap(em->out->cap, em->out->size + root->serial_len))) return false;
+        if (em->lines && !linev_reserve(em->lines, grow_cap(em->lines->cap, em->lines->size + root->serial_len))) return false;
+    }
+
+    WalkStack st;
+    walk_init(&st);
+    bool ok = true;
+    const ASTNode* n = root;
+    while (ok) {
+        if (n) {
+            if ((int)n->kind < 0 || n->kind >= AST_KIND_COUNT) { ok = false; break; }
+            ok = emit_sym(em, em->open_tag[n->kind], n->line);
+            if (ok && n->kind == AST_TOKEN && n->text) {
+                SymId id;
+                ok = symtab_intern(em->syms, n->text, &id) && emit_sym(em, id, n->line);
+            }
+            ok = ok && walk_push(&st, n);
+            n = NULL;
+            continue;
+        }
+        if (st.size == 0) break;
+        WalkFrame* top = &st.data[st.size - 1];
+        if (top->next < top->node->child_count) {
+            n = top->node->children[top->next++];
+        } else {
+            ok = emit_sym(em, em->close_tag[top->node->kind], 0);
+            st.size--;
+        }
+    }
+    walk_free(&st);
+    return ok;
+}
+
+/**
+ * @brief 对整棵 AST 做前序序列化，输出驻留后的符号 ID 序列。
+ *
+ * @param root AST 根节点。
+ * @param syms 符号表。
+ * @param out  输出序列（需已初始化）。
+ * @return 成功返回 true；失败返回 false。
+ */
+bool ast_serialize_symbols(const ASTNode* root, SymTab* syms, SymVec* out) {
+    if (!root) return false;
+
+    SymEmitter em;
+    if (!sym_emitter_init(&em, syms, out)) return false;
+    return emit_node_sym(root, &em);
+}
+
+/**
+ * @brief 初始化符号序列化上下文：预先驻留全部进/出标签。
+ *
+ * @return 成功返回 true；参数为 NULL 或内存不足返回 false。
+ */
+bool sym_emitter_init(SymEmitter* em, SymTab* syms, SymVec* out) {
+    if (!em || !syms || !out) return false;
+    em->syms = syms;
+    em->out = out;
+    em->lines = NULL;
+
+    char buf[64];
+    for (int k = 0; k < AST_KIND_COUNT; ++ k) {
+        snprintf(buf, sizeof(buf), "<%s>", ast_kind_name((ASTKind)k));
+        if (!symtab_intern(syms, buf, &em->open_tag[k])) return false;
+        snprintf(buf, sizeof(buf), "</%s>", ast_kind_name((ASTKind)k));
+        if (!symtab_intern(syms, buf, &em->close_tag[k])) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 追加一棵子树的序列化结果。
+ */
+bool sym_emit_node(SymEmitter* em, const ASTNode* n) {
+    return em && emit_node_sym(n, em);
+}
+
+/**
+ * @brief 只输出某种节点的进入标签（流式序列化时包裹顶层子树用）。
+ */
+bool sym_emit_open(SymEmitter* em, ASTKind kind) {
+    if (!em || (int)kind < 0 || kind >= AST_KIND_COUNT) return false;
+    return emit_sym(em, em->open_tag[kind], 0);
+}
+
+/**
+ * @brief 只输出某种节点的退出标签。
+ */
+bool sym_emit_close(SymEmitter* em, ASTKind kind) {
+    if (!em || (int)kind < 0 || kind >= AST_KIND_COUNT) return false;
+    return emit_sym(em, em->close_tag[kind], 0);
+}
@@ -0,0 +1,792 @@
+/**
+* @file batch.c
+ * @brief 多对多批量比较：收集文件、一次性前端处理、两两比较与排序。
+ */
+
+#include "../include/batch.h"
+#include "../include/pipeline.h"
+#include "../include/filemap.h"
+#include "../include/threadpool.h"
+#include "../include/fingerprint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+/**
+ * @brief 内部 strdup（非 POSIX 环境可用）。
+ */
+static char* xstrdup(const char* s) {
+    if (!s) return NULL;
+    size_t n = strlen(s);
+    char* p = (char*)malloc(n + 1);
+    if (!p) return NULL;
+    memcpy(p, s, n + 1);
+    return p;
+}
+
+/**
+ * @brief 初始化空语料。
+ */
+void batch_init(BatchCorpus* c) {
+    c->files = NULL;
+    c->count = 0;
+    c->cap = 0;
+    symtab_init(&c->syms);
+}
+
+/**
+ * @brief 释放语料中的全部路径、序列与符号表。
+ */
+void batch_free(BatchCorpus* c) {
+    if (!c) return;
+    for (size_t i = 0; i < c->count; i++) {
+        free(c->files[i].path);
+        symv_free(&c->files[i].seq);
+    }
+    free(c->files);
+    symtab_free(&c->syms);
+    batch_init(c);
+}
+
+/**
+ * @brief 追加一个待比较文件（仅记录路径，不读取）。
+ */
+bool batch_add_path(BatchCorpus* c, const char* path) {
+    if (!c || !path) return false;
+    if (c->count == c->cap) {
+        size_t nc = (c->cap == 0) ? 16 : c->cap * 2;
+        BatchFile* p = (BatchFile*)realloc(c->files, nc * sizeof(BatchFile));
+        if (!p) return false;
+        c->files = p;
+        c->cap = nc;
+    }
+    BatchFile* f = &c->files[c->count];
+    f->path = xstrdup(path);
+    if (!f->path) return false;
+    symv_init(&f->seq);
+    f->ok = false;
+    c->count++;
+    return true;
+}
+
+/**
+ * @brief 判断文件名是否为 C 源文件/头文件（.c / .h）。
+ */
+static bool is_c_source(const char* name) {
+    size_t n = strlen(name);
+    return n > 2 && name[n - 2] == '.' && (name[n - 1] == 'c' || name[n - 1] == 'h');
+}
+
+static int cmp_path(const void* x, const void* y) {
+    return strcmp(((const BatchFile*)x)->path, ((const BatchFile*)y)->path);
+}
+
+/**
+ * @brief 收集目录下的全部 .c/.h 文件（不递归）。
+ */
+static bool collect_dir(BatchCorpus* c, const char* dir) {
+    const size_t first = c->count;
+    char path[4096];
+
+#ifdef _WIN32
+    char pattern[4096];
+    snprintf(pattern, sizeof(pattern), "%s\\*", dir);
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA(pattern, &fd);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    do {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+        if (!is_c_source(fd.cFileName)) continue;
+        snprintf(path, sizeof(path), "%s\\%s", dir, fd.cFileName);
+        if (!batch_add_path(c, path)) { FindClose(h); return false; }
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+#else
+    DIR* d = opendir(dir);
+    if (!d) return false;
+    struct dirent* e;
+    while ((e = readdir(d)) != NULL) {
+        if (!is_c_source(e->d_name)) continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+        struct stat st;
+        if (stat(path, &st) != 0 || (st.st_mode & S_IFMT) != S_IFREG) continue;
+        if (!batch_add_path(c, path)) { closedir(d); return false; }
+    }
+    closedir(d);
+#endif
+
+    // 目录遍历顺序与平台有关，排序保证输出稳定
+    qsort(c->files + first, c->count - first, sizeof(BatchFile), cmp_path);
+    return true;
+}
+
+/**
+ * @brief 读取列表文件：每行一个路径，忽略空行与 '#' 开头的注释行。
+ */
+static bool collect_list(BatchCorpus* c, const char* list) {
+    char* text = pipeline_read_file(list, NULL);
+    if (!text) return false;
+
+    char* line = text;
+    while (*line) {
+        char* end = line;
+        while (*end && *end != '\n') end++;
+        char* next = *end ? end + 1 : end;
+
+        while (end > line && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) end--;
+        while (line < end && (*line == ' ' || *line == '\t')) line++;
+        *end = '\0';
+
+        if (*line && *line != '#' && !batch_add_path(c, line)) {
+            free(text);
+            return false;
+        }
+        line = next;
+    }
+    free(text);
+    return true;
+}
+
+/**
+ * @brief 从目录或列表文件收集待比较文件。
+ *
+ * @param dir_or_list 目录（收集其中的 .c/.h）或文本列表文件（每行一个路径）。
+ * @return 成功返回 true；路径不存在或读取失败返回 false。
+ */
+bool batch_collect(BatchCorpus* c, const char* dir_or_list) {
+    struct stat st;
+    if (!c || !dir_or_list || stat(dir_or_list, &st) != 0) return false;
+    if ((st.st_mode & S_IFMT) == S_IFDIR) return collect_dir(c, dir_or_list);
+    return collect_list(c, dir_or_list);
+}
+
+/**
+ * @brief 前端工作线程的私有状态。
+ *
+ * 前端本身可重入（Tokenizer / Parser / 序列化器的状态都在调用栈上，节点分配在调用私有的区域中），
+ * 并发时唯一共享的可变状态是符号表与缓存计数器，因此每个工作线程各持一份：
+ * 符号 ID 先驻留到私有符号表，全部完成后再按文件顺序重映射到语料符号表。
+ */
+typedef struct {
+    SymTab   syms;      // 私有符号表
+    SeqCache cache;     // 缓存副本：目录与调用方共用，计数器私有（结束时累加回去）
+    SymId*   remap;     // 私有 ID -> 语料 ID；SYM_NONE 表示尚未映射
+    size_t   remap_cap;
+} LoadWorker;
+
+/**
+ * @brief 并行前端任务的共享上下文。
+ */
+typedef struct {
+    BatchCorpus* c;
+    LoadWorker*  workers;
+    bool         use_cache;
+    int*         owner;     // owner[i]：处理第 i 个文件的工作线程
+} LoadJob;
+
+/**
+ * @brief 单个文件：映射 -> 前端（或读缓存），序列中的 ID 属于工作线程的私有符号表。
+ *
+ * 每个工作线程打开下一个文件时，其它线程仍在做词法 / 语法分析，文件读入（映射页缺页）与计算自然重叠。
+ */
+static void load_task(void* ctx, size_t index, int worker) {
+    LoadJob* job = (LoadJob*)ctx;
+    LoadWorker* w = &job->workers[worker];
+    BatchFile* f = &job->c->files[index];
+    job->owner[index] = worker;
+
+    FileMap src;
+    if (!filemap_open(&src, f->path)) return;
+    f->ok = pipeline_load_symbols(job->use_cache ? &w->cache : NULL, src.data, src.size,
+                                  &w->syms, &f->seq, NULL, NULL);
+    if (!f->ok) symv_free(&f->seq);
+    filemap_close(&src);
+}
+
+/**
+ * @brief 把序列中的私有 ID 改写为语料 ID（首次出现的名称驻留到语料符号表）。
+ */
+static bool remap_sequence(SymTab* global, LoadWorker* w, SymVec* seq) {
+    const size_t n = symtab_size(&w->syms);
+    if (n > w->remap_cap) {
+        SymId* p = (SymId*)realloc(w->remap, n * sizeof(SymId));
+        if (!p) return false;
+        for (size_t i = w->remap_cap; i < n; i++) p[i] = SYM_NONE;
+        w->remap = p;
+        w->remap_cap = n;
+    }
+    for (size_t i = 0; i < seq->size; i++) {
+        SymId* g = &w->remap[seq->data[i]];
+        if (*g == SYM_NONE && !symtab_intern(global, symtab_name(&w->syms, seq->data[i]), g)) return false;
+        seq->data[i] = *g;
+    }
+    return true;
+}
+
+/**
+ * @brief 串行前端：所有文件直接驻留到语料符号表。
+ */
+static size_t load_serial(BatchCorpus* c, SeqCache* cache) {
+    size_t ok = 0;
+    for (size_t i = 0; i < c->count; i++) {
+        BatchFile* f = &c->files[i];
+        FileMap src;
+        if (!filemap_open(&src, f->path)) continue;
+        f->ok = pipeline_load_symbols(cache, src.data, src.size, &c->syms, &f->seq, NULL, NULL);
+        if (!f->ok) symv_free(&f->seq);
+        filemap_close(&src);
+        if (f->ok) ok++;
+    }
+    return ok;
+}
+
+/**
+ * @brief 对每个文件执行一次前端处理，缓存其符号序列。
+ *
+ * 多线程时各文件由线程池并行处理（工作窃取，大小不一的文件也能均衡），
+ * 随后按文件下标顺序把私有 ID 合并到语料符号表：合并顺序与线程数、调度无关，
+ * 因此语料符号 ID 的分配是确定的，比较结果与串行完全一致。
+ *
+ * @param cache 磁盘缓存；内容未变的文件直接读取缓存序列。可为 NULL。
+ * @param jobs  线程数；<= 0 为 CPU 核数，1 为串行。
+ * @return 处理成功的文件数。
+ */
+size_t batch_load(BatchCorpus* c, SeqCache* cache, int jobs) {
+    const int threads = jobs > 0 ? jobs : tp_cpu_count();
+    if (threads <= 1 || c->count < 2) return load_serial(c, cache);
+
+    ThreadPool* pool = tp_create(threads < (int)c->count ? threads : (int)c->count);
+    const int nworkers = pool ? tp_size(pool) : 1;
+    LoadWorker* workers = (LoadWorker*)calloc((size_t)nworkers, sizeof(LoadWorker));
+    int* owner = (int*)malloc(c->count * sizeof(int));
+    if (!pool || !workers || !owner) {
+        tp_destroy(pool);
+        free(workers);
+        free(owner);
+        return load_serial(c, cache);
+    }
+    for (int w = 0; w < nworkers; w++) {
+        symtab_init(&workers[w].syms);
+        if (cache) {
+            workers[w].cache = *cache;
+            workers[w].cache.hits = workers[w].cache.misses = workers[w].cache.stores = 0;
+            workers[w].cache.frag_hits = workers[w].cache.frag_stores = 0;
+        }
+    }
+
+    LoadJob job = { c, workers, cache != NULL, owner };
+    tp_parallel_for(pool, c->count, load_task, &job);
+    tp_destroy(pool);
+
+    size_t ok = 0;
+    for (size_t i = 0; i < c->count; i++) {
+        BatchFile* f = &c->files[i];
+        if (!f->ok) continue;
+        if (!remap_sequence(&c->syms, &workers[owner[i]], &f->seq)) {
+            f->ok = false;
+            symv_free(&f->seq);
+            continue;
+        }
+        ok++;
+    }
+
+    for (int w = 0; w < nworkers; w++) {
+        if (cache) {
+            cache->hits += workers[w].cache.hits;
+            cache->misses += workers[w].cache.misses;
+            cache->stores += workers[w].cache.stores;
+            cache->frag_hits += workers[w].cache.frag_hits;
+            cache->frag_stores += workers[w].cache.frag_stores;
+        }
+        symtab_free(&workers[w].syms);
+        free(workers[w].remap);
+    }
+    free(workers);
+    free(owner);
+    return ok;
+}
+
+/**
+ * @brief 比较第 a、b 个文件；costs 非 NULL 时为加权距离，低于 min_sim 的只标记 below。
+ */
+static void compare_pair_with(const BatchCorpus* c, const BatchOptions* opt, const EditCosts* costs,
+                              size_t a, size_t b, BatchPair* out) {
+    const SymVec* sa = &c->files[a].seq;
+    const SymVec* sb = &c->files[b].seq;
+
+    out->a = a;
+    out->b = b;
+    out->below = false;
+
+    if (costs) {
+        out->dist = edit_distance_weighted(costs, sa, sb);
+        out->sim = similarity_weighted(costs, out->dist, sa, sb);
+        out->below = out->sim < opt->min_sim;
+        return;
+    }
+    if (opt->min_sim > 0.0) {
+        const size_t k = max_dist_for_similarity(opt->min_sim, sa->size, sb->size);
+        out->dist = edit_distance_symvec_bounded(sa, sb, k, opt->engine);
+        out->below = out->dist > k;
+    } else {
+        out->dist = edit_distance_symvec(sa, sb, opt->engine);
+    }
+    out->sim = similarity_from_dist(out->dist, sa->size, sb->size);
+}
+
+/**
+ * @brief 比较语料中的第 a、b 个文件。
+ *
+ * min_sim > 0 时由 max_dist_for_similarity 得到距离上界，
+ * 超出上界的文件对提前终止，只记录相似度上界。
+ * opt->costs 非 NULL 时为加权距离（每次调用都要按符号表绑定代价，批量比较请用 batch_compare_all）。
+ */
+void batch_compare_pair(const BatchCorpus* c, const BatchOptions* opt,
+                        size_t a, size_t b, BatchPair* out) {
+    EditCosts costs;
+    if (opt->costs && edit_costs_bind(&costs, opt->costs, &c->syms)) {
+        compare_pair_with(c, opt, &costs, a, b, out);
+        edit_costs_free(&costs);
+        return;
+    }
+    compare_pair_with(c, opt, NULL, a, b, out);
+}
+
+/**
+ * @brief 并行比较任务的共享上下文：pairs[i] 的 (a, b) 已预先填好。
+ */
+typedef struct {
+    const BatchCorpus*  c;
+    const BatchOptions* opt;
+    BatchPair*          pairs;
+    const EditCosts*    costs;  // 已绑定到 c->syms 的代价表；NULL 为单位代价
+} CompareJob;
+
+static void compare_task(void* ctx, size_t index, int worker) {
+    (void)worker;
+    CompareJob* job = (CompareJob*)ctx;
+    BatchPair* p = &job->pairs[index];
+    compare_pair_with(job->c, job->opt, job->costs, p->a, p->b, p);
+}
+
+/**
+ * @brief 并行 Winnowing 任务的共享上下文。
+ */
+typedef struct {
+    const BatchCorpus* c;
+    const uint64_t*    sym_hash;
+    FpVec*             sets;
+    bool               failed;
+} WinnowJob;
+
+static void winnow_task(void* ctx, size_t index, int worker) {
+    (void)worker;
+    WinnowJob* job = (WinnowJob*)ctx;
+    if (!job->c->files[index].ok) return;
+    if (!fp_winnow(&job->c->files[index].seq, job->sym_hash, FP_DEFAULT_K, FP_DEFAULT_W,
+                   &job->sets[index])) {
+        job->failed = true;     // 只会由 false 变为 true，无需加锁
+    }
+}
+
+/**
+ * @brief 指纹预筛：只返回重合度不低于 opt->prefilter 的文件对（(a, b) 已填好）。
+ */
+static BatchPair* prefilter_pairs(const BatchCorpus* c, const BatchOptions* opt,
+                                  ThreadPool* pool, size_t* npairs) {
+    *npairs = 0;
+    uint64_t* sym_hash = fp_symbol_table(&c->syms);
+    FpVec* sets = (FpVec*)malloc((c->count ? c->count : 1) * sizeof(FpVec));
+    if (!sym_hash || !sets) {
+        free(sym_hash);
+        free(sets);
+        return NULL;
+    }
+    for (size_t i = 0; i < c->count; i++) fp_init(&sets[i]);
+
+    WinnowJob job = { c, sym_hash, sets, false };
+    tp_parallel_for(pool, c->count, winnow_task, &job);
+
+    size_t nc = 0;
+    FpCandidate* cand = job.failed ? NULL : fp_candidates(sets, c->count, opt->prefilter, 0, &nc);
+    BatchPair* pairs = cand ? (BatchPair*)malloc((nc ? nc : 1) * sizeof(BatchPair)) : NULL;
+    if (pairs) {
+        for (size_t i = 0; i < nc; i++) {
+            pairs[i].a = cand[i].a;
+            pairs[i].b = cand[i].b;
+        }
+        *npairs = nc;
+    }
+
+    free(cand);
+    for (size_t i = 0; i < c->count; i++) fp_free(&sets[i]);
+    free(sets);
+    free(sym_hash);
+    return pairs;
+}
+
+/**
+ * @brief 计算成功加载文件之间的两两相似度。
+ *
+ * 文件对先按 (a, b) 字典序展开到结果数组，再交给工作窃取线程池；
+ * 每个任务只写自己的结果槽，因此输出与线程数、调度顺序无关。
+ * opt->prefilter > 0 时先做 Winnowing 指纹预筛，只有候选对进入精确比较。
+ *
+ * @param npairs 输出文件对数量。
+ * @return 结果数组（按 (a, b) 字典序，调用方 free）；失败返回 NULL。
+ */
+BatchPair* batch_compare_all(const BatchCorpus* c, const BatchOptions* opt, size_t* npairs) {
+    size_t ok = 0;
+    for (size_t i = 0; i < c->count; i++) if (c->files[i].ok) ok++;
+
+    *npairs = 0;
+    const size_t total = ok * (ok > 0 ? ok - 1 : 0) / 2;
+    ThreadPool* pool = (opt->jobs == 1 || ok < 2) ? NULL : tp_create(opt->jobs);
+
+    size_t n = 0;
+    BatchPair* pairs = NULL;
+    if (opt->prefilter > 0.0) {
+        pairs = prefilter_pairs(c, opt, pool, &n);
+    } else {
+        pairs = (BatchPair*)malloc((total ? total : 1) * sizeof(BatchPair));
+        for (size_t a = 0; pairs && a < c->count; a++) {
+            if (!c->files[a].ok) continue;
+            for (size_t b = a + 1; b < c->count; b++) {
+                if (!c->files[b].ok) continue;
+                pairs[n].a = a;
+                pairs[n].b = b;
+                n++;
+            }
+        }
+    }
+    if (!pairs) {
+        tp_destroy(pool);
+        return NULL;
+    }
+
+    EditCosts costs;
+    if (opt->costs && !edit_costs_bind(&costs, opt->costs, &c->syms)) {
+        free(pairs);
+        tp_destroy(pool);
+        return NULL;
+    }
+
+    BatchOptions inner = *opt;
+    inner.engine = edit_engine_serial(opt->engine);     // 已按文件对并行，单对内不再开线程
+    CompareJob job = { c, &inner, pairs, opt->costs ? &costs : NULL };
+    tp_parallel_for(pool, n, compare_task, &job);
+    tp_destroy(pool);
+    if (opt->costs) edit_costs_free(&costs);
+
+    *npairs = n;
+    return pairs;
+}
+
+/**
+ * @brief 排序比较：相似度降序，相同时按 (a, b) 升序，保证结果确定。
+ */
+static int cmp_pair_desc(const void* x, const void* y) {
+    const BatchPair* p = (const BatchPair*)x;
+    const BatchPair* q = (const BatchPair*)y;
+    if (p->below != q->below) return p->below ? 1 : -1;
+    if (p->sim > q->sim) return -1;
+    if (p->sim < q->sim) return 1;
+    if (p->a != q->a) return p->a < q->a ? -1 : 1;
+    if (p->b != q->b) return p->b < q->b ? -1 : 1;
+    return 0;
+}
+
+/**
+ * @brief 将文件对按“最可疑优先”排序。
+ */
+void batch_sort_pairs(BatchPair* pairs, size_t n) {
+    if (pairs && n > 1) qsort(pairs, n, sizeof(BatchPair), cmp_pair_desc);
+}
+
+/**
+ * @brief 长度界候选：按长度排序后的第 i、j 个文件（i < j），bound 为相似度上界。
+ */
+typedef struct {
+    double bound;
+    size_t i, j;
+} BoundCand;
+
+/** @brief 候选堆的次序：上界大者优先，相同时按 (i, j) 升序。 */
+static bool cand_before(const BoundCand* p, const BoundCand* q) {
+    if (p->bound != q->bound) return p->bound > q->bound;
+    if (p->i != q->i) return p->i < q->i;
+    return p->j < q->j;
+}
+
+static void cand_sift_down(BoundCand* h, size_t n, size_t i) {
+    for (;;) {
+        size_t best = i;
+        const size_t l = 2 * i + 1, r = l + 1;
+        if (l < n && cand_before(&h[l], &h[best])) best = l;
+        if (r < n && cand_before(&h[r], &h[best])) best = r;
+        if (best == i) return;
+        const BoundCand t = h[i]; h[i] = h[best]; h[best] = t;
+        i = best;
+    }
+}
+
+/** @brief 结果堆（堆顶为当前第 k 名，即最不可疑的一对）的下沉。 */
+static void res_sift_down(BatchPair* h, size_t n, size_t i) {
+    for (;;) {
+        size_t worst = i;
+        const size_t l = 2 * i + 1, r = l + 1;
+        if (l < n && cmp_pair_desc(&h[l], &h[worst]) > 0) worst = l;
+        if (r < n && cmp_pair_desc(&h[r], &h[worst]) > 0) worst = r;
+        if (worst == i) return;
+        const BatchPair t = h[i]; h[i] = h[worst]; h[worst] = t;
+        i = worst;
+    }
+}
+
+static void res_sift_up(BatchPair* h, size_t i) {
+    while (i > 0) {
+        const size_t parent = (i - 1) / 2;
+        if (cmp_pair_desc(&h[i], &h[parent]) <= 0) return;
+        const BatchPair t = h[i]; h[i] = h[parent]; h[parent] = t;
+        i = parent;
+    }
+}
+
+/** @brief 把一轮的计算结果并入前 k 名（低于本轮门槛的直接丢弃）。 */
+static void res_merge(BatchPair* res, size_t* nres, size_t k, const BatchPair* batch, size_t nb) {
+    for (size_t i = 0; i < nb; i++) {
+        if (batch[i].below) continue;
+        if (*nres < k) {
+            res[*nres] = batch[i];
+            res_sift_up(res, (*nres)++);
+        } else if (cmp_pair_desc(&batch[i], &res[0]) < 0) {
+            res[0] = batch[i];
+            res_sift_down(res, *nres, 0);
+        }
+    }
+}
+
+/** @brief 按序列长度排序的文件。 */
+typedef struct {
+    size_t len;
+    size_t index;
+} LenEntry;
+
+static int cmp_by_length(const void* x, const void* y) {
+    const LenEntry* p = (const LenEntry*)x;
+    const LenEntry* q = (const LenEntry*)y;
+    if (p->len != q->len) return p->len < q->len ? -1 : 1;
+    return p->index < q->index ? -1 : (p->index > q->index);
+}
+
+/** @brief 候选 (i, j) 的长度上界（与 similarity_from_dist 同一公式，d 取下界 |la - lb|）。 */
+static BoundCand make_cand(const LenEntry* order, size_t i, size_t j) {
+    BoundCand cand = { similarity_from_dist(order[j].len - order[i].len, order[i].len, order[j].len), i, j };
+    return cand;
+}
+
+/**
+ * @brief 最可疑的 k 对，大部分文件对不做任何距离计算。
+ *
+ * 编辑距离不小于长度差，因此 1 - |la - lb| / max(la, lb) 是相似度上界。文件按序列长度排序后，
+ * 每个文件与其后各文件的上界单调不增，于是用“每个文件一个游标”的堆按上界从大到小枚举文件对；
+ * 结果满 k 对后，上界已不可能达到第 k 名相似度的文件对连同其后全部跳过，
+ * 进入计算的文件对也以第 k 名（及 min_sim）折算的距离上界调用带上界的编辑距离。
+ * 多线程时每轮取出若干候选并行计算，轮内使用轮开始时的门槛，只影响剪枝多少、不影响结果。
+ */
+BatchPair* batch_top_pairs(const BatchCorpus* c, const BatchOptions* opt, size_t k,
+                           size_t* npairs, size_t* computed) {
+    *npairs = 0;
+    if (computed) *computed = 0;
+
+    // 加权代价下编辑距离不再以长度差为下界：全量比较后截取
+    if (opt->costs) {
+        size_t n = 0;
+        BatchPair* all = batch_compare_all(c, opt, &n);
+        if (!all) return NULL;
+        batch_sort_pairs(all, n);
+        size_t keep = 0;
+        while (keep < n && keep < k && !all[keep].below) keep++;
+        *npairs = keep;
+        if (computed) *computed = n;
+        return all;
+    }
+
+    size_t nok = 0;
+    LenEntry* order = (LenEntry*)malloc((c->count ? c->count : 1) * sizeof(LenEntry));
+    BoundCand* heap = (BoundCand*)malloc((c->count ? c->count : 1) * sizeof(BoundCand));
+    BatchPair* res = (BatchPair*)malloc((k ? k : 1) * sizeof(BatchPair));
+    if (!order || !heap || !res) {
+        free(order);
+        free(heap);
+        free(res);
+        return NULL;
+    }
+    for (size_t i = 0; i < c->count; i++) {
+        if (!c->files[i].ok) continue;
+        order[nok].len = c->files[i].seq.size;
+        order[nok++].index = i;
+    }
+    qsort(order, nok, sizeof(LenEntry), cmp_by_length);
+
+    size_t nheap = 0;
+    for (size_t i = 0; k > 0 && i + 1 < nok; i++) heap[nheap++] = make_cand(order, i, i + 1);
+    for (size_t i = nheap / 2; i-- > 0;) cand_sift_down(heap, nheap, i);
+
+    ThreadPool* pool = (opt->jobs == 1 || nok < 2) ? NULL : tp_create(opt->jobs);
+    const size_t round = pool ? 4 * (size_t)tp_size(pool) : 1;
+    BatchPair* batch = (BatchPair*)malloc(round * sizeof(BatchPair));
+
+    BatchOptions inner = *opt;
+    inner.engine = edit_engine_serial(opt->engine);
+    size_t nres = 0, done = 0;
+    bool ok = batch != NULL;
+    while (ok && nheap > 0) {
+        // 本轮门槛：结果未满时为 min_sim，满后为第 k 名相似度（不低于 min_sim）
+        inner.min_sim = opt->min_sim;
+        if (nres == k && res[0].sim > inner.min_sim) inner.min_sim = res[0].sim;
+
+        size_t nb = 0;
+        while (nb < round && nheap > 0) {
+            const BoundCand top = heap[0];
+            const size_t a = order[top.i].index, b = order[top.j].index;
+            const size_t la = order[top.i].len, lb = order[top.j].len;
+            if (lb - la > max_dist_for_similarity(inner.min_sim, la, lb)) {
+                nheap = 0;  // 堆顶上界已不够，其余候选更低
+                break;
+            }
+            batch[nb].a = a < b ? a : b;
+            batch[nb].b = a < b ? b : a;
+            nb++;
+
+            if (top.j + 1 < nok) {
+                heap[0] = make_cand(order, top.i, top.j + 1);
+            } else {
+                heap[0] = heap[--nheap];
+            }
+            cand_sift_down(heap, nheap, 0);
+        }
+
+        CompareJob job = { c, &inner, batch, NULL };
+        tp_parallel_for(pool, nb, compare_task, &job);
+        done += nb;
+
+        res_merge(res, &nres, k, batch, nb);
+    }
+    tp_destroy(pool);
+    free(batch);
+    free(heap);
+    free(order);
+    if (!ok) {
+        free(res);
+        return NULL;
+    }
+
+    batch_sort_pairs(res, nres);
+    *npairs = nres;
+    if (computed) *computed = done;
+    return res;
+}
+
+/**
+ * @brief 单个查询序列与语料比较任务的共享上下文：pairs[i].a 为语料文件下标。
+ */
+typedef struct {
+    const BatchCorpus*  c;
+    const SymVec*       query;
+    const BatchOptions* opt;
+    BatchPair*          pairs;
+} MatchJob;
+
+static void match_task(void* ctx, size_t index, int worker) {
+    (void)worker;
+    MatchJob* job = (MatchJob*)ctx;
+    BatchPair* p = &job->pairs[index];
+    const SymVec* s = &job->c->files[p->a].seq;
+    p->below = false;
+    if (job->opt->min_sim > 0.0) {
+        const size_t k = max_dist_for_similarity(job->opt->min_sim, job->query->size, s->size);
+        p->dist = edit_distance_symvec_bounded(job->query, s, k, job->opt->engine);
+        p->below = p->dist > k;
+    } else {
+        p->dist = edit_distance_symvec(job->query, s, job->opt->engine);
+    }
+    p->sim = similarity_from_dist(p->dist, job->query->size, s->size);
+}
+
+/** @brief 上界降序，相同时按文件下标升序。 */
+static int cmp_match_bound(const void* x, const void* y) {
+    const BatchPair* p = (const BatchPair*)x;
+    const BatchPair* q = (const BatchPair*)y;
+    if (p->sim != q->sim) return p->sim > q->sim ? -1 : 1;
+    return p->a < q->a ? -1 : (p->a > q->a);
+}
+
+/**
+ * @brief 与 batch_top_pairs 相同的长度界剪枝，但只比较一个查询序列与语料中的各文件。
+ *
+ * 候选按长度上界降序排列后分轮计算，上界低于第 k 名时停止。
+ */
+BatchPair* batch_top_matches(const BatchCorpus* c, const BatchOptions* opt, const SymVec* query,
+                             const bool* skip, size_t k, size_t* npairs, size_t* computed) {
+    *npairs = 0;
+    if (computed) *computed = 0;
+
+    size_t ncand = 0;
+    BatchPair* cand = (BatchPair*)malloc((c->count ? c->count : 1) * sizeof(BatchPair));
+    BatchPair* res = (BatchPair*)malloc((k ? k : 1) * sizeof(BatchPair));
+    if (!cand || !res) {
+        free(cand);
+        free(res);
+        return NULL;
+    }
+    for (size_t i = 0; k > 0 && i < c->count; i++) {
+        if (!c->files[i].ok || (skip && skip[i])) continue;
+        const size_t la = query->size, lb = c->files[i].seq.size;
+        cand[ncand].a = i;
+        cand[ncand].b = 0;
+        cand[ncand].dist = la > lb ? la - lb : lb - la;     // 距离下界
+        cand[ncand].sim = similarity_from_dist(cand[ncand].dist, la, lb);
+        ncand++;
+    }
+    qsort(cand, ncand, sizeof(BatchPair), cmp_match_bound);
+
+    ThreadPool* pool = (opt->jobs == 1 || ncand < 2) ? NULL : tp_create(opt->jobs);
+    const size_t round = pool ? 4 * (size_t)tp_size(pool) : 1;
+
+    BatchOptions inner = *opt;
+    inner.engine = edit_engine_serial(opt->engine);
+    size_t nres = 0, next = 0;
+    while (next < ncand) {
+        inner.min_sim = opt->min_sim;
+        if (nres == k && res[0].sim > inner.min_sim) inner.min_sim = res[0].sim;
+
+        size_t nb = 0;
+        while (nb < round && next + nb < ncand) {
+            const BatchPair* p = &cand[next + nb];
+            const size_t lb = c->files[p->a].seq.size;
+            if (p->dist > max_dist_for_similarity(inner.min_sim, query->size, lb)) break;
+            nb++;
+        }
+        if (nb == 0) break;     // 其余候选的上界更低
+
+        MatchJob job = { c, query, &inner, cand + next };
+        tp_parallel_for(pool, nb, match_task, &job);
+        res_merge(res, &nres, k, cand + next, nb);
+        next += nb;
+    }
+    tp_destroy(pool);
+    free(cand);
+
+    batch_sort_pairs(res, nres);
+    *npairs = nres;
+    if (computed) *computed = next;
+    return res;
+}
@@ -0,0 +1,225 @@
+/**
+* @file edit_align.c
+ * @brief Hirschberg 线性空间对齐的实现。
+ *
+ * 每层把较长的一侧从中点切开，用位并行 Myers 算法分别求“前半 × 对侧全部前缀”的正向列
+ * 与“后半 × 对侧全部后缀”的反向列，两列之和最小处即最优路径穿过中点的位置，
+ * 然后对左上、右下两个子问题递归。问题足够小时改用完整 DP + 回溯。
+ */
+
+#include "../include/edit_align.h"
+#include "../include/edit_distance.c.h"
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief 子问题的 DP 单元数不超过该值时直接做完整 DP 回溯（uint32 表约 256 KiB）。 */
+#define ALIGN_BASE_CELLS 65536u
+
+/**
+ * @brief 初始化空脚本。
+ */
+void edit_script_init(EditScript* s) {
+    s->data = NULL;
+    s->size = 0;
+    s->cap = 0;
+    s->dist = 0;
+}
+
+/**
+ * @brief 释放脚本。
+ *
+ * @param s 目标脚本；可为 NULL。
+ */
+void edit_script_free(EditScript* s) {
+    if (!s) return;
+    free(s->data);
+    edit_script_init(s);
+}
+
+/**
+ * @brief 追加一段操作；与末段同类且首尾相接时直接合并。
+ */
+static bool push_run(EditScript* s, EditOp op, size_t ai, size_t na, size_t bi, size_t nb) {
+    if (na == 0 && nb == 0) return true;
+    if (op != EDIT_EQUAL) s->dist += (op == EDIT_INSERT) ? nb : na;
+
+    if (s->size > 0) {
+        EditRun* last = &s->data[s->size - 1];
+        if (last->op == op && last->a_begin + last->a_len == ai && last->b_begin + last->b_len == bi) {
+            last->a_len += na;
+            last->b_len += nb;
+            return true;
+        }
+    }
+    if (s->size == s->cap) {
+        const size_t nc = s->cap ? s->cap * 2 : 64;
+        EditRun* p = (EditRun*)realloc(s->data, nc * sizeof(EditRun));
+        if (!p) return false;
+        s->data = p;
+        s->cap = nc;
+    }
+    EditRun* r = &s->data[s->size++];
+    r->op = op;
+    r->a_begin = ai; r->a_len = na;
+    r->b_begin = bi; r->b_len = nb;
+    return true;
+}
+
+/**
+ * @brief 一侧只有一个符号：能在对侧找到相同符号就对齐到第一处，否则与对侧首个符号替换。
+ */
+static bool align_single(const SymId* a, size_t ai, size_t n, const SymId* b, size_t bi, size_t m,
+                         EditScript* out) {
+    if (n == 1) {
+        size_t k = 0;
+        while (k < m && b[bi + k] != a[ai]) k++;
+        if (k == m) {
+            return push_run(out, EDIT_SUBST, ai, 1, bi, 1) &&
+                   push_run(out, EDIT_INSERT, ai + 1, 0, bi + 1, m - 1);
+        }
+        return push_run(out, EDIT_INSERT, ai, 0, bi, k) &&
+               push_run(out, EDIT_EQUAL, ai, 1, bi + k, 1) &&
+               push_run(out, EDIT_INSERT, ai + 1, 0, bi + k + 1, m - k - 1);
+    }
+    size_t k = 0;
+    while (k < n && a[ai + k] != b[bi]) k++;
+    if (k == n) {
+        return push_run(out, EDIT_SUBST, ai, 1, bi, 1) &&
+               push_run(out, EDIT_DELETE, ai + 1, n - 1, bi + 1, 0);
+    }
+    return push_run(out, EDIT_DELETE, ai, k, bi, 0) &&
+           push_run(out, EDIT_EQUAL, ai + k, 1, bi, 1) &&
+           push_run(out, EDIT_DELETE, ai + k + 1, n - k - 1, bi + 1, 0);
+}
+
+/**
+ * @brief 小规模子问题：完整 DP 表 + 回溯（相同/替换优先，其次删除，最后插入）。
+ */
+static bool align_base(const SymId* a, size_t ai, size_t n, const SymId* b, size_t bi, size_t m,
+                       EditScript* out) {
+    const size_t w = m + 1;
+    uint32_t* d = (uint32_t*)malloc((n + 1) * w * sizeof(uint32_t));
+    unsigned char* ops = (unsigned char*)malloc(n + m);
+    if (!d || !ops) { free(d); free(ops); return false; }
+
+    for (size_t j = 0; j <= m; ++ j) d[j] = (uint32_t)j;
+    for (size_t i = 1; i <= n; ++ i) {
+        uint32_t* row = d + i * w;
+        const uint32_t* up = row - w;
+        row[0] = (uint32_t)i;
+        const SymId ca = a[ai + i - 1];
+        for (size_t j = 1; j <= m; ++ j) {
+            uint32_t best = up[j - 1] + (ca != b[bi + j - 1]);
+            if (up[j] + 1 < best) best = up[j] + 1;
+            if (row[j - 1] + 1 < best) best = row[j - 1] + 1;
+            row[j] = best;
+        }
+    }
+
+    // 回溯得到逆序操作
+    size_t i = n, j = m, k = 0;
+    while (i > 0 || j > 0) {
+        const uint32_t v = d[i * w + j];
+        if (i > 0 && j > 0) {
+            const bool same = a[ai + i - 1] == b[bi + j - 1];
+            if (v == d[(i - 1) * w + j - 1] + !same) {
+                ops[k++] = same ? EDIT_EQUAL : EDIT_SUBST;
+                i--; j--;
+                continue;
+            }
+        }
+        if (i > 0 && v == d[(i - 1) * w + j] + 1) { ops[k++] = EDIT_DELETE; i--; }
+        else { ops[k++] = EDIT_INSERT; j--; }
+    }
+    free(d);
+
+    bool ok = true;
+    size_t pa = ai, pb = bi;
+    while (ok && k > 0) {
+        const EditOp op = (EditOp)ops[--k];
+        const size_t na = (op == EDIT_INSERT) ? 0 : 1;
+        const size_t nb = (op == EDIT_DELETE) ? 0 : 1;
+        ok = push_run(out, op, pa, na, pb, nb);
+        pa += na;
+        pb += nb;
+    }
+    free(ops);
+    return ok;
+}
+
+/**
+ * @brief 对齐 A[ai, ai + n) 与 B[bi, bi + m)，操作按顺序追加到 out。
+ *
+ * 总是切开较长的一侧，DP 列沿较短一侧展开，因此两条列的长度不超过 min(n, m) + 1；
+ * 递归深度为 O(log(n + m))。
+ */
+static bool align_rec(const SymId* a, size_t ai, size_t n, const SymId* b, size_t bi, size_t m,
+                      EditScript* out) {
+    if (n == 0) return push_run(out, EDIT_INSERT, ai, 0, bi, m);
+    if (m == 0) return push_run(out, EDIT_DELETE, ai, n, bi, 0);
+    if (n == 1 || m == 1) return align_single(a, ai, n, b, bi, m, out);
+    if ((n + 1) <= ALIGN_BASE_CELLS / (m + 1)) return align_base(a, ai, n, b, bi, m, out);
+
+    const bool split_a = n >= m;
+    const size_t len = split_a ? m : n;        // DP 列所沿的一侧长度
+    size_t* fwd = (size_t*)malloc((len + 1) * sizeof(size_t));
+    size_t* rev = (size_t*)malloc((len + 1) * sizeof(size_t));
+    if (!fwd || !rev) { free(fwd); free(rev); return false; }
+
+    // fwd[k]：被切一侧的前半与对侧前 k 个符号的距离；rev[k]：后半与对侧后 k 个符号的距离
+    const SymId* cut   = split_a ? a + ai : b + bi;
+    const SymId* other = split_a ? b + bi : a + ai;
+    const size_t total = split_a ? n : m;
+    const size_t mid = total / 2;
+    bool ok = levenshtein_column_myers(cut, mid, other, len, false, fwd) &&
+              levenshtein_column_myers(cut + mid, total - mid, other, len, true, rev);
+
+    size_t best_k = 0, best = (size_t)-1;
+    for (size_t k = 0; ok && k <= len; ++ k) {
+        const size_t cost = fwd[k] + rev[len - k];
+        if (cost < best) { best = cost; best_k = k; }
+    }
+    free(fwd);
+    free(rev);
+    if (!ok) return false;
+
+    if (split_a) {
+        return align_rec(a, ai, mid, b, bi, best_k, out) &&
+               align_rec(a, ai + mid, n - mid, b, bi + best_k, m - best_k, out);
+    }
+    return align_rec(a, ai, best_k, b, bi, mid, out) &&
+           align_rec(a, ai + best_k, n - best_k, b, bi + mid, m - mid, out);
+}
+
+/**
+ * @brief 求 A -> B 的最优编辑脚本；脚本代价 out->dist 与 edit_distance_symvec 的结果相同。
+ */
+bool edit_align(const SymVec* a, const SymVec* b, EditScript* out) {
+    if (!a || !b || !out) return false;
+    out->size = 0;
+    out->dist = 0;
+
+    if (!align_rec(a->data, 0, a->size, b->data, 0, b->size, out)) {
+        out->size = 0;
+        out->dist = 0;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 符号区间 -> 源码行区间（行号序列单调不减，首尾两项即为区间端点）。
+ */
+void edit_span_lines(const LineVec* lines, size_t begin, size_t len, uint32_t* first, uint32_t* last) {
+    uint32_t lo = 0, hi = 0;
+    if (lines && lines->size > 0) {
+        size_t s = begin, e = begin + len - 1;
+        if (len == 0) s = e = begin > 0 ? begin - 1 : 0;
+        if (s >= lines->size) s = lines->size - 1;
+        if (e >= lines->size) e = lines->size - 1;
+        lo = lines->data[s];
+        hi = lines->data[e];
+    }
+    if (first) *first = lo;
+    if (last) *last = hi;
+}
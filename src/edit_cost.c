@@ -0,0 +1,419 @@
+/**
+* @file edit_cost.c
+ * @brief 加权编辑距离：代价模型、代价文件解析与反对角线向量化 DP。
+ */
+
+#include "../include/edit_cost.h"
+#include "../include/stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// x86 上 AVX2 按函数开启、运行时检测；AArch64 总有 NEON
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define EC_SIMD_AVX2 1
+#define EC_AVX2_FN __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(__AVX2__)
+#define EC_SIMD_AVX2 1
+#define EC_AVX2_FN
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define EC_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// 代价文件中的类别集合用 64 位位图表示
+_Static_assert(EC_CLASS_COUNT <= 64, "EC_CLASS_COUNT must fit in a 64-bit set");
+
+static const char* const LEAF_NAMES[EC_LEAF_COUNT] = { "ID", "NUM", "STR", "CHR", "KW", "OP" };
+
+static uint8_t clamp_cost(unsigned c) {
+    return (uint8_t)(c > EDIT_COST_MAX ? EDIT_COST_MAX : c);
+}
+
+void edit_cost_uniform(EditCostModel* m, unsigned sub, unsigned indel) {
+    memset(m->sub, clamp_cost(sub), sizeof(m->sub));
+    memset(m->indel, clamp_cost(indel), sizeof(m->indel));
+}
+
+/** @brief 设置 x、y 两个类别之间的替换代价（两个方向）。 */
+static void set_sub(EditCostModel* m, int x, int y, uint8_t c) {
+    m->sub[x][y] = c;
+    m->sub[y][x] = c;
+}
+
+void edit_cost_kind_preset(EditCostModel* m) {
+    edit_cost_uniform(m, 2, 2);
+
+    static const ASTKind LOOPS[] = { AST_FOR, AST_WHILE, AST_DO_WHILE };
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            if (i == j) continue;
+            set_sub(m, EC_OPEN(LOOPS[i]), EC_OPEN(LOOPS[j]), 1);
+        }
+    }
+    set_sub(m, EC_OPEN(AST_IF), EC_OPEN(AST_SWITCH), 1);
+
+    // 出标签只是进标签的回声：插入删除为 0，出标签之间互换也为 0
+    for (int k = 0; k < AST_KIND_COUNT; k++) {
+        m->indel[EC_CLOSE(k)] = 0;
+        for (int l = 0; l < AST_KIND_COUNT; l++) set_sub(m, EC_CLOSE(k), EC_CLOSE(l), 0);
+    }
+}
+
+/**
+ * @brief 代价文件中的名称 -> 类别集合（位图，EC_CLASS_COUNT 不超过 64）。
+ *
+ * @return 名称无效时返回 0。
+ */
+static uint64_t parse_classes(const char* name) {
+    uint64_t set = 0;
+    if (name[0] == '@') {
+        for (int l = 0; l < EC_LEAF_COUNT; l++) {
+            if (strcmp(name + 1, "*") == 0 || strcmp(name + 1, LEAF_NAMES[l]) == 0) set |= 1ull << EC_LEAF(l);
+        }
+        return set;
+    }
+    const bool close = name[0] == '/';
+    const char* kind = close ? name + 1 : name;
+    for (int k = 0; k < AST_KIND_COUNT; k++) {
+        if (strcmp(kind, "*") == 0 || strcmp(kind, ast_kind_name((ASTKind)k)) == 0) {
+            set |= 1ull << (close ? EC_CLOSE(k) : EC_OPEN(k));
+        }
+    }
+    return set;
+}
+
+static bool parse_cost(const char* s, uint8_t* out) {
+    char* end = NULL;
+    const long v = strtol(s, &end, 10);
+    if (end == s || *end != '\0' || v < 0 || v > EDIT_COST_MAX) return false;
+    *out = (uint8_t)v;
+    return true;
+}
+
+/**
+ * @brief 解析一行规则；空行与注释行视为成功。
+ */
+static bool parse_rule(EditCostModel* m, char* line) {
+    char* hash = strchr(line, '#');
+    if (hash) *hash = '\0';
+    char* tok[4];
+    int n = 0;
+    for (char* p = strtok(line, " \t\r\n"); p; p = strtok(NULL, " \t\r\n")) {
+        if (n == 4) return false;
+        tok[n++] = p;
+    }
+    if (n == 0) return true;
+
+    uint8_t c, d;
+    if (strcmp(tok[0], "default") == 0 && n == 3) {
+        if (!parse_cost(tok[1], &c) || !parse_cost(tok[2], &d)) return false;
+        edit_cost_uniform(m, c, d);
+        return true;
+    }
+    if (strcmp(tok[0], "indel") == 0 && n == 3) {
+        const uint64_t set = parse_classes(tok[1]);
+        if (!set || !parse_cost(tok[2], &c)) return false;
+        for (int x = 0; x < EC_CLASS_COUNT; x++) if (set >> x & 1) m->indel[x] = c;
+        return true;
+    }
+    if (strcmp(tok[0], "sub") == 0 && n == 4) {
+        const uint64_t sa = parse_classes(tok[1]), sb = parse_classes(tok[2]);
+        if (!sa || !sb || !parse_cost(tok[3], &c)) return false;
+        for (int x = 0; x < EC_CLASS_COUNT; x++) {
+            if (!(sa >> x & 1)) continue;
+            for (int y = 0; y < EC_CLASS_COUNT; y++) if (sb >> y & 1) set_sub(m, x, y, c);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool edit_cost_load(EditCostModel* m, const char* path) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return false;
+    char line[512];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp)) ok = parse_rule(m, line);
+    fclose(fp);
+    return ok;
+}
+
+/**
+ * @brief 由序列化标签（"<IF>"、"</IF>"、"NUM"、"var_3"、"+" 等）确定类别。
+ */
+static uint8_t classify(const char* name) {
+    const size_t len = strlen(name);
+    if (len > 2 && name[0] == '<' && name[len - 1] == '>') {
+        const bool close = name[1] == '/';
+        const char* kind = name + (close ? 2 : 1);
+        const size_t klen = len - (close ? 3 : 2);
+        for (int k = 0; k < AST_KIND_COUNT; k++) {
+            const char* kn = ast_kind_name((ASTKind)k);
+            if (strlen(kn) == klen && memcmp(kn, kind, klen) == 0) {
+                return (uint8_t)(close ? EC_CLOSE(k) : EC_OPEN(k));
+            }
+        }
+    }
+    if (strcmp(name, "NUM") == 0) return EC_LEAF(EC_LEAF_NUM);
+    if (strcmp(name, "STR") == 0) return EC_LEAF(EC_LEAF_STR);
+    if (strcmp(name, "CHR") == 0) return EC_LEAF(EC_LEAF_CHR);
+    if (!isalpha((unsigned char)name[0]) && name[0] != '_') return EC_LEAF(EC_LEAF_OP);
+
+    // 关键字标签全为大写字母；归一化后的标识符带小写前缀（var_ / id_ / fn_ / gv_）
+    for (const char* p = name; *p; p++) {
+        if (!isupper((unsigned char)*p)) return EC_LEAF(EC_LEAF_ID);
+    }
+    return EC_LEAF(EC_LEAF_KW);
+}
+
+static bool simd_available(void);
+
+bool edit_costs_bind(EditCosts* t, const EditCostModel* m, const SymTab* syms) {
+    const size_t n = symtab_size(syms);
+    t->sym_class = (uint8_t*)malloc(n ? n : 1);
+    t->nsyms = n;
+    if (!t->sym_class) return false;
+    for (size_t i = 0; i < n; i++) t->sym_class[i] = classify(symtab_name(syms, (SymId)i));
+    for (int x = 0; x < EC_CLASS_COUNT; x++) {
+        t->indel[x] = m->indel[x];
+        for (int y = 0; y < EC_CLASS_COUNT; y++) t->sub[x * EC_CLASS_COUNT + y] = m->sub[x][y];
+    }
+    t->simd = simd_available();
+    return true;
+}
+
+void edit_costs_free(EditCosts* t) {
+    if (!t) return;
+    free(t->sym_class);
+    t->sym_class = NULL;
+    t->nsyms = 0;
+}
+
+size_t edit_cost_total(const EditCosts* t, const SymVec* s) {
+    size_t sum = 0;
+    for (size_t i = 0; i < s->size; i++) sum += t->indel[t->sym_class[s->data[i]]];
+    return sum;
+}
+
+static inline uint32_t sub_cost(const EditCosts* t, SymId x, SymId y) {
+    return x == y ? 0 : t->sub[t->sym_class[x] * EC_CLASS_COUNT + t->sym_class[y]];
+}
+
+static inline size_t min3z(size_t a, size_t b, size_t c) {
+    const size_t m = a < b ? a : b;
+    return m < c ? m : c;
+}
+
+/**
+ * @brief 逐行两行 DP（size_t 单元，任意规模都不会溢出）。
+ */
+size_t edit_distance_weighted_dp(const EditCosts* t, const SymVec* a, const SymVec* b) {
+    const size_t n = a->size, m = b->size;
+    if (m == 0) return edit_cost_total(t, a);
+    if (n == 0) return edit_cost_total(t, b);
+
+    size_t* prev = (size_t*)malloc((m + 1) * sizeof(size_t));
+    size_t* curr = (size_t*)malloc((m + 1) * sizeof(size_t));
+    if (!prev || !curr) { free(prev); free(curr); return 0; }
+
+    prev[0] = 0;
+    for (size_t j = 1; j <= m; j++) prev[j] = prev[j - 1] + t->indel[t->sym_class[b->data[j - 1]]];
+    for (size_t i = 1; i <= n; i++) {
+        const SymId ai = a->data[i - 1];
+        const size_t del = t->indel[t->sym_class[ai]];
+        curr[0] = prev[0] + del;
+        for (size_t j = 1; j <= m; j++) {
+            const SymId bj = b->data[j - 1];
+            curr[j] = min3z(prev[j] + del, curr[j - 1] + t->indel[t->sym_class[bj]],
+                            prev[j - 1] + sub_cost(t, ai, bj));
+        }
+        size_t* tmp = prev; prev = curr; curr = tmp;
+    }
+    const size_t dist = prev[m];
+    free(prev);
+    free(curr);
+
+    STATS_ADD(ST_DISTANCES, 1);
+    STATS_ADD(ST_DP_CELLS, n * m);
+    return dist;
+}
+
+/**
+ * @brief 反对角线 DP 的预处理数组：A 正序、B 倒序，同一条反对角线上的单元在两边都是连续下标。
+ *
+ * 单元 (i, j) 位于第 d = i + j 条反对角线，按 i 存放；b 的第 j 个符号在倒序数组中的下标为 m - d + i。
+ */
+typedef struct {
+    const EditCosts* t;
+    size_t    n, m;
+    uint32_t* sa;       // sa[i]   = a 的第 i+1 个符号
+    uint32_t* rowa;     // rowa[i] = 其类别 * EC_CLASS_COUNT
+    uint32_t* dela;     // dela[i] = 其删除代价
+    uint32_t* rb;       // rb[k]   = b 的第 m-k 个符号
+    uint32_t* colb;     // colb[k] = 其类别
+    uint32_t* insb;     // insb[k] = 其插入代价
+} DiagInput;
+
+/**
+ * @brief 计算一条反对角线 [lo, hi] 内的单元：cur[i] = min(up + del, left + ins, diag + sub)。
+ *
+ * d1 / d2 为前一条、前两条反对角线；k0 为 i = lo 时 b 符号在倒序数组中的下标。
+ */
+static void diag_scalar(const DiagInput* in, size_t lo, size_t hi, size_t k0,
+                        const uint32_t* d2, const uint32_t* d1, uint32_t* cur) {
+    for (size_t i = lo, k = k0; i <= hi; i++, k++) {
+        const uint32_t up = d1[i - 1] + in->dela[i - 1];
+        const uint32_t left = d1[i] + in->insb[k];
+        const uint32_t sub = in->sa[i - 1] == in->rb[k] ? 0 : in->t->sub[in->rowa[i - 1] + in->colb[k]];
+        const uint32_t dg = d2[i - 1] + sub;
+        uint32_t v = up < left ? up : left;
+        cur[i] = v < dg ? v : dg;
+    }
+}
+
+#if defined(EC_SIMD_AVX2)
+EC_AVX2_FN
+static void diag_avx2(const DiagInput* in, size_t lo, size_t hi, size_t k0,
+                      const uint32_t* d2, const uint32_t* d1, uint32_t* cur) {
+    size_t i = lo, k = k0;
+    const int* sub = (const int*)in->t->sub;
+    for (; i + 8 <= hi + 1; i += 8, k += 8) {
+        const __m256i up = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(d1 + i - 1)),
+                                            _mm256_loadu_si256((const __m256i*)(in->dela + i - 1)));
+        const __m256i left = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(d1 + i)),
+                                              _mm256_loadu_si256((const __m256i*)(in->insb + k)));
+        const __m256i idx = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(in->rowa + i - 1)),
+                                             _mm256_loadu_si256((const __m256i*)(in->colb + k)));
+        const __m256i same = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(in->sa + i - 1)),
+                                                _mm256_loadu_si256((const __m256i*)(in->rb + k)));
+        const __m256i cost = _mm256_andnot_si256(same, _mm256_i32gather_epi32(sub, idx, 4));
+        const __m256i dg = _mm256_add_epi32(_mm256_loadu_si256((const __m256i*)(d2 + i - 1)), cost);
+        _mm256_storeu_si256((__m256i*)(cur + i), _mm256_min_epu32(_mm256_min_epu32(up, left), dg));
+    }
+    if (i <= hi) diag_scalar(in, i, hi, k, d2, d1, cur);
+}
+
+static bool have_avx2(void) {
+#if defined(_MSC_VER)
+    return true;    // 仅在以 /arch:AVX2 编译时启用
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+#if defined(EC_SIMD_NEON)
+static void diag_neon(const DiagInput* in, size_t lo, size_t hi, size_t k0,
+                      const uint32_t* d2, const uint32_t* d1, uint32_t* cur) {
+    size_t i = lo, k = k0;
+    for (; i + 4 <= hi + 1; i += 4, k += 4) {
+        const uint32x4_t up = vaddq_u32(vld1q_u32(d1 + i - 1), vld1q_u32(in->dela + i - 1));
+        const uint32x4_t left = vaddq_u32(vld1q_u32(d1 + i), vld1q_u32(in->insb + k));
+        uint32_t g[4];      // NEON 没有 gather：查表部分逐个取
+        for (int l = 0; l < 4; l++) g[l] = in->t->sub[in->rowa[i - 1 + l] + in->colb[k + l]];
+        const uint32x4_t same = vceqq_u32(vld1q_u32(in->sa + i - 1), vld1q_u32(in->rb + k));
+        const uint32x4_t dg = vaddq_u32(vld1q_u32(d2 + i - 1), vbicq_u32(vld1q_u32(g), same));
+        vst1q_u32(cur + i, vminq_u32(vminq_u32(up, left), dg));
+    }
+    if (i <= hi) diag_scalar(in, i, hi, k, d2, d1, cur);
+}
+#endif
+
+/**
+ * @brief 向量内核是否可用：AVX2 需在运行时检测 CPU，NEON 是 AArch64 的基本指令集。
+ *
+ * 只在 edit_costs_bind 中调用，结果存入 EditCosts，并行比较时各线程只读。
+ */
+static bool simd_available(void) {
+#if defined(EC_SIMD_AVX2)
+    return have_avx2();
+#elif defined(EC_SIMD_NEON)
+    return true;
+#else
+    return false;
+#endif
+}
+
+size_t edit_distance_weighted(const EditCosts* t, const SymVec* a, const SymVec* b) {
+    const SymVec *A = a, *B = b;
+    if (A->size > B->size) { A = b; B = a; }   // A 为较短序列：反对角线长度不超过 n + 1
+    const size_t n = A->size, m = B->size;
+    if (n == 0) return edit_cost_total(t, B);
+
+    // 32 位单元的上界为全部删除再全部插入的代价
+    const size_t total_a = edit_cost_total(t, A), total_b = edit_cost_total(t, B);
+    if (total_a + total_b >= UINT32_MAX) return edit_distance_weighted_dp(t, a, b);
+
+    DiagInput in;
+    in.t = t;
+    in.n = n;
+    in.m = m;
+    uint32_t* buf = (uint32_t*)malloc((3 * n + 3 * m + 3 * (n + 1)) * sizeof(uint32_t));
+    if (!buf) return edit_distance_weighted_dp(t, a, b);
+    in.sa = buf;
+    in.rowa = in.sa + n;
+    in.dela = in.rowa + n;
+    in.rb = in.dela + n;
+    in.colb = in.rb + m;
+    in.insb = in.colb + m;
+    uint32_t* d2 = in.insb + m;
+    uint32_t* d1 = d2 + (n + 1);
+    uint32_t* cur = d1 + (n + 1);
+
+    for (size_t i = 0; i < n; i++) {
+        const uint8_t c = t->sym_class[A->data[i]];
+        in.sa[i] = A->data[i];
+        in.rowa[i] = (uint32_t)c * EC_CLASS_COUNT;
+        in.dela[i] = t->indel[c];
+    }
+    for (size_t k = 0; k < m; k++) {
+        const SymId s = B->data[m - 1 - k];
+        in.rb[k] = s;
+        in.colb[k] = t->sym_class[s];
+        in.insb[k] = t->indel[t->sym_class[s]];
+    }
+
+    uint32_t row0 = 0, col0 = 0;    // D(0, d) 与 D(d, 0)：第 0 行 / 第 0 列的前缀和
+    for (size_t d = 0; d <= n + m; d++) {
+        const size_t lo = d > m ? d - m : 0;
+        const size_t hi = d < n ? d : n;
+        if (d > 0 && d <= m) row0 += in.insb[m - d];
+        if (d > 0 && d <= n) col0 += in.dela[d - 1];
+        if (lo == 0) cur[0] = row0;
+        if (hi == d) cur[d] = col0;
+
+        const size_t s = lo > 0 ? lo : 1;
+        const size_t e = hi < d ? hi : d - 1;
+        if (d >= 2 && s <= e) {
+#if defined(EC_SIMD_AVX2)
+            if (t->simd) diag_avx2(&in, s, e, m - d + s, d2, d1, cur);
+            else diag_scalar(&in, s, e, m - d + s, d2, d1, cur);
+#elif defined(EC_SIMD_NEON)
+            if (t->simd) diag_neon(&in, s, e, m - d + s, d2, d1, cur);
+            else diag_scalar(&in, s, e, m - d + s, d2, d1, cur);
+#else
+            diag_scalar(&in, s, e, m - d + s, d2, d1, cur);
+#endif
+        }
+        uint32_t* tmp = d2; d2 = d1; d1 = cur; cur = tmp;
+    }
+    const size_t dist = d1[n];
+    free(buf);
+
+    STATS_ADD(ST_DISTANCES, 1);
+    STATS_ADD(ST_DP_CELLS, n * m);
+    return dist;
+}
+
+double similarity_weighted(const EditCosts* t, size_t dist, const SymVec* a, const SymVec* b) {
+    const size_t ta = edit_cost_total(t, a), tb = edit_cost_total(t, b);
+    const size_t mx = ta > tb ? ta : tb;
+    if (mx == 0) return 1.0;
+    const double s = 1.0 - (double)dist / (double)mx;
+    return s < 0.0 ? 0.0 : s;
+}
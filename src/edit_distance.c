@@ -6,14 +6,18 @@
  */
 
 #include "../include//edit_distance.c.h"
+#include "../include/threadpool.h"
+#include "../include/stats.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
 /**
  * @brief 求 3 个 size_t 的最小值（Levenshtein DP 的工具函数）。
  */
 static inline size_t min3(const size_t a, const size_t b, const size_t c) {
-    return a < b ? a : b < c ? b : c;
+    const size_t ab = a < b ? a : b;
+    return ab < c ? ab : c;
 }
 
 /**
@@ -86,9 +90,666 @@ size_t levenshtein_strvec(const StrVec *a, const StrVec *b) {
     free(v[0]);
     free(v[1]);
 
+    STATS_ADD(ST_DISTANCES, 1);
+    STATS_ADD(ST_DP_CELLS, n * m);
     return dist;
 }
 
+/**
+ * @brief 计算两条符号序列（SymVec）之间的 Levenshtein 距离。
+ *
+ * 与 levenshtein_strvec 相同的两行 DP，但 token 已驻留为整数 ID：
+ * 相等判断退化为一次整数比较，行缓冲也只需按较短序列开辟。
+ *
+ * @param a 序列 A（非 NULL）。
+ * @param b 序列 B（非 NULL）。
+ * @return 编辑距离（>=0）。
+ */
+size_t levenshtein_symvec(const SymVec *a, const SymVec *b) {
+    if (!a || !b) return 0;
+
+    const SymVec *A = a, *B = b;
+    if (B->size > A->size) { A = b; B = a; }
+    const size_t n = A->size, m = B->size;
+    if (m == 0) return n;
+
+    size_t *prev = (size_t*)malloc((m + 1) * sizeof(size_t));
+    size_t *curr = (size_t*)malloc((m + 1) * sizeof(size_t));
+    if (!prev || !curr) { free(prev); free(curr); return 0; }
+
+    for (size_t j = 0; j <= m; ++ j) {
+        prev[j] = j;
+    }
+
+    const SymId *bs = B->data;
+    for (size_t i = 1; i <= n; ++ i) {
+        const SymId ai = A->data[i - 1];
+        curr[0] = i;
+
+        for (size_t j = 1; j <= m; ++ j) {
+            const size_t del = prev[j] + 1;
+            const size_t ins = curr[j - 1] + 1;
+            const size_t sub = prev[j - 1] + (ai != bs[j - 1]);
+
+            curr[j] = min3(del, ins, sub);
+        }
+
+        size_t *t = prev; prev = curr; curr = t;
+    }
+
+    const size_t dist = prev[m];
+    free(prev);
+    free(curr);
+
+    STATS_ADD(ST_DISTANCES, 1);
+    STATS_ADD(ST_DP_CELLS, n * m);
+    return dist;
+}
+
+/**
+ * @brief 模式串某个符号在某个 64 位块内的匹配位图（稀疏 Peq 表项）。
+ */
+typedef struct {
+    size_t   block;
+    uint64_t mask;
+} PeqEntry;
+
+/**
+ * @brief Myers/Hyyrö 位并行算法的单块推进（处理文本的一个符号）。
+ *
+ * @param pv   块内纵向 +1 差分位图（输入/输出）。
+ * @param mv   块内纵向 -1 差分位图（输入/输出）。
+ * @param eq   该文本符号在本块模式位置上的匹配位图。
+ * @param hin  从上一块进入的横向差分（-1/0/+1）。
+ * @param high 本块最高有效行对应的位（末块可能不满 64 行）。
+ * @return 从本块最高有效行流出的横向差分（-1/0/+1）。
+ */
+static inline int myers_advance(uint64_t *pv, uint64_t *mv, uint64_t eq, int hin, uint64_t high) {
+    const uint64_t Pv = *pv, Mv = *mv;
+    const uint64_t Xv = eq | Mv;
+    if (hin < 0) eq |= 1;
+    const uint64_t Xh = (((eq & Pv) + Pv) ^ Pv) | eq;
+    uint64_t Ph = Mv | ~(Xh | Pv);
+    uint64_t Mh = Pv & Xh;
+
+    int hout = 0;
+    if (Ph & high) hout = 1;
+    else if (Mh & high) hout = -1;
+
+    Ph <<= 1;
+    Mh <<= 1;
+    if (hin < 0) Mh |= 1;
+    else if (hin > 0) Ph |= 1;
+
+    *pv = Mh | ~(Xv | Ph);
+    *mv = Ph & Xv;
+    return hout;
+}
+
+/**
+ * @brief 位并行 Levenshtein 距离（Myers 1999 / Hyyrö 多块版本）。
+ *
+ * 以较短序列为模式串，按 64 行一块打包 DP 列的纵向差分，每读入文本的一个符号
+ * 逐块推进一次，整体 O(ceil(m/64)·n)，结果与 levenshtein_symvec 完全一致。
+ *
+ * 符号表可能很大（变量名归一化会产生大量只出现一次的符号），因此 Peq 表按
+ * 符号压缩为 (块号, 位图) 的稀疏列表，总表项数不超过 m。
+ *
+ * @param a 序列 A（非 NULL）。
+ * @param b 序列 B（非 NULL）。
+ * @return 编辑距离（>=0）；内存不足时退回经典 DP。
+ */
+size_t levenshtein_symvec_myers(const SymVec *a, const SymVec *b) {
+    if (!a || !b) return 0;
+
+    const SymVec *T = a, *P = b;
+    if (P->size > T->size) { T = b; P = a; }
+    const size_t n = T->size, m = P->size;
+    if (m == 0) return n;
+
+    const size_t nblocks = (m + 63) / 64;
+
+    // 1) 符号 -> 模式串局部编号（不在模式串中的符号编号为 UINT32_MAX）
+    SymId maxid = 0;
+    for (size_t i = 0; i < m; ++ i) if (P->data[i] > maxid) maxid = P->data[i];
+
+    uint32_t *local = (uint32_t*)malloc(((size_t)maxid + 1) * sizeof(uint32_t));
+    uint32_t *count = (uint32_t*)calloc(m + 1, sizeof(uint32_t));
+    size_t   *last_blk = (size_t*)malloc(m * sizeof(size_t));
+    PeqEntry *peq = (PeqEntry*)malloc(m * sizeof(PeqEntry));
+    uint64_t *pv = (uint64_t*)malloc(nblocks * sizeof(uint64_t));
+    uint64_t *mv = (uint64_t*)malloc(nblocks * sizeof(uint64_t));
+    if (!local || !count || !last_blk || !peq || !pv || !mv) {
+        free(local); free(count); free(last_blk); free(peq); free(pv); free(mv);
+        return levenshtein_symvec(a, b);
+    }
+    for (size_t s = 0; s <= maxid; ++ s) local[s] = UINT32_MAX;
+
+    // 2) 统计每个局部符号涉及的块数，构建 CSR 形式的稀疏 Peq
+    uint32_t k = 0;
+    for (size_t i = 0; i < m; ++ i) {
+        const SymId s = P->data[i];
+        if (local[s] == UINT32_MAX) { last_blk[k] = (size_t)-1; local[s] = k++; }
+        const uint32_t l = local[s];
+        if (last_blk[l] != i / 64) { last_blk[l] = i / 64; count[l + 1]++; }
+    }
+    for (uint32_t l = 0; l < k; ++ l) count[l + 1] += count[l]; // count[l] 变为起始偏移
+
+    for (uint32_t l = 0; l < k; ++ l) last_blk[l] = (size_t)-1;
+    size_t *fill = last_blk; // 复用：fill[l] 为下一个写入位置
+    for (uint32_t l = 0; l < k; ++ l) fill[l] = count[l];
+    for (size_t i = 0; i < m; ++ i) {
+        const uint32_t l = local[P->data[i]];
+        const size_t blk = i / 64;
+        const uint64_t bit = (uint64_t)1 << (i % 64);
+        if (fill[l] > count[l] && peq[fill[l] - 1].block == blk) {
+            peq[fill[l] - 1].mask |= bit;
+        } else {
+            peq[fill[l]].block = blk;
+            peq[fill[l]].mask = bit;
+            fill[l]++;
+        }
+    }
+
+    // 3) 逐列推进
+    for (size_t blk = 0; blk < nblocks; ++ blk) { pv[blk] = ~(uint64_t)0; mv[blk] = 0; }
+    const uint64_t high_full = (uint64_t)1 << 63;
+    const uint64_t high_last = (uint64_t)1 << ((m - 1) % 64);
+
+    size_t score = m;
+    for (size_t j = 0; j < n; ++ j) {
+        const SymId c = T->data[j];
+        const PeqEntry *e = NULL, *end = NULL;
+        if (c <= maxid && local[c] != UINT32_MAX) {
+            e = peq + count[local[c]];
+            end = peq + count[local[c] + 1];
+        }
+
+        int h = 1; // 第 0 行：D[0][j] = j，横向差分恒为 +1
+        for (size_t blk = 0; blk < nblocks; ++ blk) {
+            uint64_t eq = 0;
+            if (e != end && e->block == blk) eq = (e++)->mask;
+            h = myers_advance(&pv[blk], &mv[blk], eq, h,
+                              blk + 1 == nblocks ? high_last : high_full);
+        }
+        score = (size_t)((ptrdiff_t)score + h);
+    }
+
+    free(local); free(count); free(last_blk); free(peq); free(pv); free(mv);
+    STATS_ADD(ST_DISTANCES, 1);
+    STATS_ADD(ST_DP_CELLS, n * m);
+    return score;
+}
+
+/** @brief 波前分块：每条横带的 64 位字数（1024 行，横带状态 pv/mv 共 256 字节）。 */
+#define WF_BAND_WORDS 16
+/** @brief 波前分块：每块的文本列数（块内文本与横向差分约 20 KiB，可留在 L1/L2 缓存中）。 */
+#define WF_CHUNK_COLS 4096
+/** @brief 总字运算量低于该值时直接串行计算，线程调度开销得不偿失。 */
+#define WF_MIN_WORK   ((size_t)1 << 22)
+
+/**
+ * @brief 波前并行的共享状态。
+ *
+ * DP 表按“横带（band，WF_BAND_WORDS 个位并行字）× 列块（chunk，WF_CHUNK_COLS 列）”分块。
+ * 块 (b, c) 依赖同一横带的左侧块 (b, c-1)（横带的 pv/mv 状态）与上方块 (b-1, c)
+ * （这些列在横带上边界的横向差分 hd），同一反对角线 b + c = d 上的块互不依赖。
+ */
+typedef struct {
+    const SymId* text;
+    size_t       n;
+    const SymId* pat;
+    size_t       m;
+    size_t       nblocks;   // 模式串的 64 位字数
+    size_t       nbands;
+    size_t       nchunks;
+    uint64_t*    pv;        // 每个字的纵向 +1 差分（按横带划分归属）
+    uint64_t*    mv;        // 每个字的纵向 -1 差分
+    signed char* hd;        // 每列的横向差分：上一横带的下边界 / 本横带算完后的下边界
+    size_t       diag;      // 当前处理的反对角线
+    struct WfScratch* scratch;  // 每个工作线程一份
+} WfJob;
+
+/**
+ * @brief 线程私有的横带 Peq 表：符号 -> 本横带内 (字号, 位图) 的稀疏列表。
+ *
+ * 同一线程连续处理同一横带时直接复用（band 记录当前表对应的横带）。
+ */
+typedef struct WfScratch {
+    size_t    band;
+    SymId     keys[WF_BAND_WORDS * 64 * 2];
+    uint32_t  start[WF_BAND_WORDS * 64 * 2];  // 槽 -> 表项区间 [start, end)
+    uint32_t  end[WF_BAND_WORDS * 64 * 2];
+    PeqEntry  peq[WF_BAND_WORDS * 64];
+    uint32_t  row_slot[WF_BAND_WORDS * 64];
+} WfScratch;
+
+#define WF_SLOTS (WF_BAND_WORDS * 64 * 2)
+
+static size_t wf_slot(const SymId* keys, SymId s) {
+    size_t h = (size_t)(s * 0x9e3779b97f4a7c15ull) & (WF_SLOTS - 1);
+    while (keys[h] != SYM_NONE && keys[h] != s) h = (h + 1) & (WF_SLOTS - 1);
+    return h;
+}
+
+/**
+ * @brief 为横带 band 建立 Peq 表（表项按字号升序，与推进顺序一致）。
+ */
+static void wf_build_band(const WfJob* job, WfScratch* sc, size_t band) {
+    const size_t r0 = band * WF_BAND_WORDS * 64;
+    size_t r1 = r0 + WF_BAND_WORDS * 64;
+    if (r1 > job->m) r1 = job->m;
+
+    for (size_t s = 0; s < WF_SLOTS; ++ s) { sc->keys[s] = SYM_NONE; sc->start[s] = 0; sc->end[s] = 0; }
+
+    // 1) 统计每个符号涉及的字数（同一符号的行按升序出现，字号相同则合并）
+    for (size_t r = r0; r < r1; ++ r) {
+        const size_t h = wf_slot(sc->keys, job->pat[r]);
+        if (sc->keys[h] == SYM_NONE) { sc->keys[h] = job->pat[r]; sc->start[h] = UINT32_MAX; }
+        const uint32_t w = (uint32_t)((r - r0) / 64);
+        if (sc->start[h] != w) { sc->start[h] = w; sc->end[h]++; }
+        sc->row_slot[r - r0] = (uint32_t)h;
+    }
+    // 2) end 暂存个数，转为区间
+    uint32_t off = 0;
+    for (size_t s = 0; s < WF_SLOTS; ++ s) {
+        if (sc->keys[s] == SYM_NONE) continue;
+        const uint32_t cnt = sc->end[s];
+        sc->start[s] = off;
+        sc->end[s] = off;       // 填充游标
+        off += cnt;
+    }
+    // 3) 填表
+    for (size_t r = r0; r < r1; ++ r) {
+        const uint32_t h = sc->row_slot[r - r0];
+        const size_t w = (r - r0) / 64;
+        const uint64_t bit = (uint64_t)1 << ((r - r0) % 64);
+        if (sc->end[h] > sc->start[h] && sc->peq[sc->end[h] - 1].block == w) {
+            sc->peq[sc->end[h] - 1].mask |= bit;
+        } else {
+            sc->peq[sc->end[h]].block = w;
+            sc->peq[sc->end[h]].mask = bit;
+            sc->end[h]++;
+        }
+    }
+    sc->band = band;
+}
+
+/**
+ * @brief 计算当前反对角线上的第 index 个块。
+ */
+static void wf_tile_task(void* ctx, size_t index, int worker) {
+    WfJob* job = (WfJob*)ctx;
+    size_t band = job->diag < job->nchunks ? 0 : job->diag - job->nchunks + 1;
+    band += index;
+    const size_t chunk = job->diag - band;
+
+    WfScratch* sc = &job->scratch[worker];
+    if (sc->band != band) wf_build_band(job, sc, band);
+
+    const size_t w0 = band * WF_BAND_WORDS;
+    size_t w1 = w0 + WF_BAND_WORDS;
+    if (w1 > job->nblocks) w1 = job->nblocks;
+    const size_t j0 = chunk * WF_CHUNK_COLS;
+    size_t j1 = j0 + WF_CHUNK_COLS;
+    if (j1 > job->n) j1 = job->n;
+
+    const uint64_t high_full = (uint64_t)1 << 63;
+    const uint64_t high_last = (uint64_t)1 << ((job->m - 1) % 64);
+    uint64_t pv[WF_BAND_WORDS], mv[WF_BAND_WORDS];
+    const size_t nw = w1 - w0;
+    memcpy(pv, job->pv + w0, nw * sizeof(uint64_t));
+    memcpy(mv, job->mv + w0, nw * sizeof(uint64_t));
+
+    for (size_t j = j0; j < j1; ++ j) {
+        const size_t h = wf_slot(sc->keys, job->text[j]);
+        const PeqEntry *e = NULL, *end = NULL;
+        if (sc->keys[h] != SYM_NONE) {
+            e = sc->peq + sc->start[h];
+            end = sc->peq + sc->end[h];
+        }
+        int hin = job->hd[j];
+        for (size_t w = 0; w < nw; ++ w) {
+            uint64_t eq = 0;
+            if (e != end && e->block == w) eq = (e++)->mask;
+            hin = myers_advance(&pv[w], &mv[w], eq, hin,
+                                w0 + w + 1 == job->nblocks ? high_last : high_full);
+        }
+        job->hd[j] = (signed char)hin;
+    }
+
+    memcpy(job->pv + w0, pv, nw * sizeof(uint64_t));
+    memcpy(job->mv + w0, mv, nw * sizeof(uint64_t));
+}
+
+/**
+ * @brief 分块波前并行的位并行编辑距离：一对超长序列也能用满全部核心。
+ *
+ * 以较短序列为模式串，按 WF_BAND_WORDS 个字划分横带、按 WF_CHUNK_COLS 列划分列块，
+ * 沿反对角线逐条并行计算各块（每条反对角线之间同步一次）。每个块内的推进与
+ * levenshtein_symvec_myers 完全相同，只是横带之间改为逐列传递横向差分，
+ * 因此结果与 levenshtein_symvec / levenshtein_strvec 逐位一致，与线程数无关。
+ *
+ * @param jobs 线程数；<= 0 为 CPU 核数，1 或规模较小时退回串行 levenshtein_symvec_myers。
+ * @return 编辑距离；内存不足时退回串行计算。
+ */
+size_t levenshtein_symvec_wavefront(const SymVec *a, const SymVec *b, int jobs) {
+    if (!a || !b) return 0;
+
+    const SymVec *T = a, *P = b;
+    if (P->size > T->size) { T = b; P = a; }
+    const size_t n = T->size, m = P->size;
+    if (m == 0) return n;
+
+    const size_t nblocks = (m + 63) / 64;
+    const int threads = jobs > 0 ? jobs : tp_cpu_count();
+    if (threads <= 1 || nblocks * n < WF_MIN_WORK) return levenshtein_symvec_myers(a, b);
+
+    WfJob job;
+    job.text = T->data;
+    job.n = n;
+    job.pat = P->data;
+    job.m = m;
+    job.nblocks = nblocks;
+    job.nbands = (nblocks + WF_BAND_WORDS - 1) / WF_BAND_WORDS;
+    job.nchunks = (n + WF_CHUNK_COLS - 1) / WF_CHUNK_COLS;
+    job.pv = (uint64_t*)malloc(nblocks * sizeof(uint64_t));
+    job.mv = (uint64_t*)malloc(nblocks * sizeof(uint64_t));
+    job.hd = (signed char*)malloc(n);
+
+    ThreadPool* pool = tp_create(threads);
+    const int nworkers = pool ? tp_size(pool) : 1;
+    job.scratch = (WfScratch*)malloc((size_t)nworkers * sizeof(WfScratch));
+    if (!job.pv || !job.mv || !job.hd || !job.scratch || !pool) {
+        free(job.pv); free(job.mv); free(job.hd); free(job.scratch);
+        tp_destroy(pool);
+        return levenshtein_symvec_myers(a, b);
+    }
+    for (int w = 0; w < nworkers; ++ w) job.scratch[w].band = (size_t)-1;
+    for (size_t w = 0; w < nblocks; ++ w) { job.pv[w] = ~(uint64_t)0; job.mv[w] = 0; }
+    memset(job.hd, 1, n);   // 第 0 行：D[0][j] = j，横向差分恒为 +1
+
+    const size_t ndiag = job.nbands + job.nchunks - 1;
+    for (size_t d = 0; d < ndiag; ++ d) {
+        const size_t first = d < job.nchunks ? 0 : d - job.nchunks + 1;
+        const size_t last = d < job.nbands ? d : job.nbands - 1;
+        job.diag = d;
+        tp_parallel_for(pool, last - first + 1, wf_tile_task, &job);
+    }
+    tp_destroy(pool);
+
+    // D[m][n] = D[m][0] + Σ 最后一横带下边界的横向差分
+    ptrdiff_t score = (ptrdiff_t)m;
+    for (size_t j = 0; j < n; ++ j) score += job.hd[j];
+
+    free(job.pv); free(job.mv); free(job.hd); free(job.scratch);
+    STATS_ADD(ST_DISTANCES, 1);
+    STATS_ADD(ST_DP_CELLS, n * m);
+    return (size_t)score;
+}
+
+/**
+ * @brief 位并行求整列 DP：col[i] = D(text, pat[0..i))，i = 0..m。
+ *
+ * 与 levenshtein_symvec_myers 相同的推进方式；读完整段文本后，各块的纵向差分位图
+ * 正好描述最后一列，逐行累加即可得到整列。供 Hirschberg 分治在每层求中间列使用，
+ * 模式串符号用开放寻址表映射（每层只花 O(m) 建表，不按符号表大小开辟数组）。
+ *
+ * @param reverse 为 true 时文本与模式串都从末尾倒序读取（求后缀的 DP 列）。
+ * @param col     输出数组，至少 m + 1 项。
+ * @return 成功返回 true；内存不足返回 false。
+ */
+bool levenshtein_column_myers(const SymId *text, size_t n, const SymId *pat, size_t m,
+                              bool reverse, size_t *col) {
+    if (!col) return false;
+    col[0] = n;
+    if (m == 0) return true;
+
+    const size_t nblocks = (m + 63) / 64;
+    size_t cap = 16;
+    while (cap < m * 2) cap <<= 1;
+    const size_t mask = cap - 1;
+
+    SymId    *keys = (SymId*)malloc(cap * sizeof(SymId));
+    uint32_t *slot_local = (uint32_t*)malloc(cap * sizeof(uint32_t));
+    uint32_t *count = (uint32_t*)calloc(m + 1, sizeof(uint32_t));
+    size_t   *last_blk = (size_t*)malloc(m * sizeof(size_t));
+    PeqEntry *peq = (PeqEntry*)malloc(m * sizeof(PeqEntry));
+    uint64_t *pv = (uint64_t*)malloc(nblocks * sizeof(uint64_t));
+    uint64_t *mv = (uint64_t*)malloc(nblocks * sizeof(uint64_t));
+    uint32_t *pat_local = (uint32_t*)malloc(m * sizeof(uint32_t));
+    if (!keys || !slot_local || !count || !last_blk || !peq || !pv || !mv || !pat_local) {
+        free(keys); free(slot_local); free(count); free(last_blk); free(peq); free(pv); free(mv); free(pat_local);
+        return false;
+    }
+    for (size_t s = 0; s < cap; ++ s) keys[s] = SYM_NONE;
+
+    // 1) 模式串符号 -> 局部编号（pat_local[i] 为第 i 行的局部编号）
+    uint32_t k = 0;
+    for (size_t i = 0; i < m; ++ i) {
+        const SymId s = reverse ? pat[m - 1 - i] : pat[i];
+        size_t h = (size_t)(s * 0x9e3779b97f4a7c15ull) & mask;
+        while (keys[h] != SYM_NONE && keys[h] != s) h = (h + 1) & mask;
+        if (keys[h] == SYM_NONE) { keys[h] = s; slot_local[h] = k; last_blk[k] = (size_t)-1; k++; }
+        const uint32_t l = slot_local[h];
+        pat_local[i] = l;
+        if (last_blk[l] != i / 64) { last_blk[l] = i / 64; count[l + 1]++; }
+    }
+    for (uint32_t l = 0; l < k; ++ l) count[l + 1] += count[l];
+
+    size_t *fill = last_blk;
+    for (uint32_t l = 0; l < k; ++ l) fill[l] = count[l];
+    for (size_t i = 0; i < m; ++ i) {
+        const uint32_t l = pat_local[i];
+        const size_t blk = i / 64;
+        const uint64_t bit = (uint64_t)1 << (i % 64);
+        if (fill[l] > count[l] && peq[fill[l] - 1].block == blk) {
+            peq[fill[l] - 1].mask |= bit;
+        } else {
+            peq[fill[l]].block = blk;
+            peq[fill[l]].mask = bit;
+            fill[l]++;
+        }
+    }
+
+    // 2) 逐个文本符号推进
+    for (size_t blk = 0; blk < nblocks; ++ blk) { pv[blk] = ~(uint64_t)0; mv[blk] = 0; }
+    const uint64_t high_full = (uint64_t)1 << 63;
+    const uint64_t high_last = (uint64_t)1 << ((m - 1) % 64);
+
+    for (size_t j = 0; j < n; ++ j) {
+        const SymId c = reverse ? text[n - 1 - j] : text[j];
+        const PeqEntry *e = NULL, *end = NULL;
+        size_t h = (size_t)(c * 0x9e3779b97f4a7c15ull) & mask;
+        while (keys[h] != SYM_NONE && keys[h] != c) h = (h + 1) & mask;
+        if (keys[h] == c) {
+            e = peq + count[slot_local[h]];
+            end = peq + count[slot_local[h] + 1];
+        }
+
+        int hd = 1;
+        for (size_t blk = 0; blk < nblocks; ++ blk) {
+            uint64_t eq = 0;
+            if (e != end && e->block == blk) eq = (e++)->mask;
+            hd = myers_advance(&pv[blk], &mv[blk], eq, hd,
+                               blk + 1 == nblocks ? high_last : high_full);
+        }
+    }
+
+    // 3) 纵向差分累加为整列
+    for (size_t i = 0; i < m; ++ i) {
+        const uint64_t bit = (uint64_t)1 << (i % 64);
+        const size_t blk = i / 64;
+        col[i + 1] = col[i] + ((pv[blk] & bit) ? 1 : 0) - ((mv[blk] & bit) ? 1 : 0);
+    }
+
+    free(keys); free(slot_local); free(count); free(last_blk); free(peq); free(pv); free(mv); free(pat_local);
+    STATS_ADD(ST_DP_CELLS, n * m);
+    return true;
+}
+
+/**
+ * @brief 带上界的编辑距离（Ukkonen 对角带 + 提前终止）。
+ *
+ * 设 n >= m、Δ = n - m，则穿过对角线 d = j - i 的任意路径代价至少为
+ * |d| + |d + Δ|；只计算满足该下界 <= max_dist 的对角带，宽度约 max_dist + 1。
+ * 每行结束时若带内所有单元的“当前值 + 剩余下界”都超过 max_dist，立即返回。
+ * 带外单元视为 max_dist + 1（饱和），因此带内结果在 <= max_dist 时是精确的。
+ *
+ * @param a        序列 A（非 NULL）。
+ * @param b        序列 B（非 NULL）。
+ * @param max_dist 距离上界 k。
+ * @return 距离 <= k 时返回精确距离；否则返回 k + 1。
+ */
+size_t levenshtein_symvec_bounded(const SymVec *a, const SymVec *b, size_t max_dist) {
+    if (!a || !b) return 0;
+
+    const SymVec *A = a, *B = b;
+    if (B->size > A->size) { A = b; B = a; }
+    const size_t n = A->size, m = B->size;
+    const size_t delta = n - m;
+    if (delta > max_dist) return max_dist + 1;
+    if (m == 0) return n;
+
+    // 距离不可能超过 n：收紧上界，同时避免 k + 1 溢出
+    const size_t k = (max_dist < n) ? max_dist : n;
+    const size_t INF = k + 1;
+
+    // 对角线范围：d ∈ [-dneg, dpos]
+    const size_t dneg = (k + delta) / 2;
+    const size_t dpos = (k - delta) / 2;
+
+    size_t *prev = (size_t*)malloc((m + 2) * sizeof(size_t));
+    size_t *curr = (size_t*)malloc((m + 2) * sizeof(size_t));
+    if (!prev || !curr) {
+        free(prev); free(curr);
+        const size_t d = levenshtein_symvec(a, b);
+        return d <= k ? d : INF;
+    }
+
+    size_t hi = (dpos < m) ? dpos : m;
+    for (size_t j = 0; j <= hi; ++ j) prev[j] = j;
+    prev[hi + 1] = INF;
+
+    const SymId *bs = B->data;
+    size_t cells = 0;
+    for (size_t i = 1; i <= n; ++ i) {
+        const size_t lo = (i > dneg) ? i - dneg : 0;
+        hi = (i + dpos < m) ? i + dpos : m;
+        if (lo > hi) {
+            free(prev); free(curr);
+            STATS_ADD(ST_DISTANCES, 1);
+            STATS_ADD(ST_DP_CELLS, cells);
+            return INF;
+        }
+        cells += hi - lo + 1;
+
+        const SymId ai = A->data[i - 1];
+        size_t j = lo;
+        if (lo == 0) {
+            curr[0] = i <= k ? i : INF;
+            j = 1;
+        } else {
+            curr[lo - 1] = INF;
+        }
+
+        size_t row_best = INF;
+        if (lo == 0) {
+            const size_t rem = (i > delta) ? i - delta : delta - i; // |(m - 0) - (n - i)|
+            if (curr[0] < INF && curr[0] + rem <= k) row_best = curr[0] + rem;
+        }
+
+        for (; j <= hi; ++ j) {
+            const size_t del = prev[j] + 1;
+            const size_t ins = curr[j - 1] + 1;
+            const size_t sub = prev[j - 1] + (ai != bs[j - 1]);
+            size_t v = min3(del, ins, sub);
+            if (v > INF) v = INF;
+            curr[j] = v;
+
+            // 剩余代价下界：|(m - j) - (n - i)|
+            const size_t rj = m - j, ri = n - i;
+            const size_t rem = rj > ri ? rj - ri : ri - rj;
+            if (v < INF && v + rem < row_best) row_best = v + rem;
+        }
+        if (hi < m) curr[hi + 1] = INF;
+
+        if (row_best > k) {
+            free(prev); free(curr);
+            STATS_ADD(ST_DISTANCES, 1);
+            STATS_ADD(ST_DP_CELLS, cells);
+            return INF;
+        }
+
+        size_t *t = prev; prev = curr; curr = t;
+    }
+
+    const size_t dist = prev[m];
+    free(prev);
+    free(curr);
+    STATS_ADD(ST_DISTANCES, 1);
+    STATS_ADD(ST_DP_CELLS, cells);
+    return dist <= k ? dist : INF;
+}
+
+/**
+ * @brief 由相似度下限反推允许的最大编辑距离。
+ *
+ * sim = 1 - dist / max(lenA, lenB) >= min_sim  ⇔  dist <= (1 - min_sim)·max(lenA, lenB)。
+ *
+ * @param min_sim 相似度下限（0~1）。
+ * @return 最大允许距离 k；配合 levenshtein_symvec_bounded 使用。
+ */
+size_t max_dist_for_similarity(double min_sim, size_t lenA, size_t lenB) {
+    const size_t mx = (lenA > lenB) ? lenA : lenB;
+    if (min_sim <= 0.0) return mx;
+    if (min_sim >= 1.0) return 0;
+    // 加一个很小的 epsilon，避免 0.6·x 恰为整数时浮点误差导致少算 1
+    const double k = (1.0 - min_sim) * (double)mx + 1e-9;
+    return (size_t)k;
+}
+
+/**
+ * @brief 按指定引擎计算符号序列编辑距离（各引擎结果一致，仅性能不同）。
+ */
+size_t edit_distance_symvec(const SymVec *a, const SymVec *b, EditEngine engine) {
+    switch (engine) {
+        case ED_ENGINE_DP:      return levenshtein_symvec(a, b);
+        case ED_ENGINE_BITPAR:  return levenshtein_symvec_myers(a, b);
+        case ED_ENGINE_WAVEFRONT: return levenshtein_symvec_wavefront(a, b, 0);
+        default:                return levenshtein_symvec_myers(a, b);
+    }
+}
+
+/**
+ * @brief 调用方已按任务并行（批量文件对、函数对）时使用的引擎：波前引擎换成结果相同的串行位并行。
+ */
+EditEngine edit_engine_serial(EditEngine engine) {
+    return engine == ED_ENGINE_WAVEFRONT ? ED_ENGINE_BITPAR : engine;
+}
+
+/**
+ * @brief 带上界的编辑距离：按带宽自动选择对角带 DP 或整表引擎。
+ *
+ * 带宽约 k + 1 个单元/行，位并行引擎约 ceil(m/64) 个字/行（每字十余条指令）；
+ * 带宽较窄时对角带更快，否则用完整引擎计算后再与 k 比较。
+ *
+ * @return 距离 <= max_dist 时为精确值，否则返回 max_dist + 1。
+ */
+size_t edit_distance_symvec_bounded(const SymVec *a, const SymVec *b, size_t max_dist, EditEngine engine) {
+    if (!a || !b) return 0;
+    const size_t la = a->size, lb = b->size;
+    const size_t m = la < lb ? la : lb;
+    const size_t delta = la > lb ? la - lb : lb - la;
+    if (delta > max_dist) return max_dist + 1;
+
+    if (engine == ED_ENGINE_DP || max_dist < m / 8) {
+        return levenshtein_symvec_bounded(a, b, max_dist);
+    }
+    const size_t d = edit_distance_symvec(a, b, engine);
+    return d <= max_dist ? d : max_dist + 1;
+}
+
 /**
  * @brief 将编辑距离转换为 [0,1] 相似度（归一化编辑距离的线性映射）。
  *
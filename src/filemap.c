@@ -0,0 +1,129 @@
+/**
+* @file filemap.c
+ * @brief 只读文件映射的平台实现。
+ */
+
+#include "../include/filemap.h"
+#include "../include/pipeline.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief 退回路径：整体读入堆缓冲区。
+ */
+static bool filemap_read_fallback(FileMap* m, const char* path) {
+    size_t len = 0;
+    char* content = pipeline_read_file(path, &len);
+    if (!content) return false;
+    if (len == 0) {
+        free(content);
+        return true;
+    }
+    m->data = content;
+    m->size = len;
+    m->mapped = false;
+    return true;
+}
+
+bool filemap_open(FileMap* m, const char* path) {
+    if (!m || !path) return false;
+    m->data = "";
+    m->size = 0;
+    m->mapped = false;
+
+#ifdef _WIN32
+    m->file = NULL;
+    m->mapping = NULL;
+
+    HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size) || (unsigned long long)size.QuadPart > (size_t)-1) {
+        CloseHandle(f);
+        return false;
+    }
+    // 空文件无法创建映射对象，直接返回空视图
+    if (size.QuadPart == 0) {
+        CloseHandle(f);
+        return true;
+    }
+
+    HANDLE map = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    const char* view = map ? (const char*)MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!view) {
+        if (map) CloseHandle(map);
+        CloseHandle(f);
+        return filemap_read_fallback(m, path);
+    }
+
+    m->data = view;
+    m->size = (size_t)size.QuadPart;
+    m->mapped = true;
+    m->file = f;
+    m->mapping = map;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    // 非普通文件（管道等）不能映射，退回读入
+    if (!S_ISREG(st.st_mode)) {
+        close(fd);
+        return filemap_read_fallback(m, path);
+    }
+    // 空文件不能 mmap（长度 0），直接返回空视图
+    if (st.st_size == 0) {
+        close(fd);
+        return true;
+    }
+
+    void* view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // 映射建立后描述符即可关闭
+    if (view == MAP_FAILED) return filemap_read_fallback(m, path);
+
+#ifdef MADV_SEQUENTIAL
+    // tokenizer 严格顺序扫描，提示内核加大预读
+    madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+
+    m->data = (const char*)view;
+    m->size = (size_t)st.st_size;
+    m->mapped = true;
+    return true;
+#endif
+}
+
+void filemap_close(FileMap* m) {
+    if (!m) return;
+    if (m->mapped) {
+#ifdef _WIN32
+        UnmapViewOfFile((LPCVOID)m->data);
+        CloseHandle((HANDLE)m->mapping);
+        CloseHandle((HANDLE)m->file);
+        m->file = NULL;
+        m->mapping = NULL;
+#else
+        munmap((void*)m->data, m->size);
+#endif
+    } else if (m->size > 0) {
+        free((void*)m->data);
+    }
+    m->data = "";
+    m->size = 0;
+    m->mapped = false;
+}
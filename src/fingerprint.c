@@ -0,0 +1,291 @@
+/**
+* @file fingerprint.c
+ * @brief Winnowing 指纹与倒排索引候选对的实现。
+ */
+
+#include "../include/fingerprint.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define FP_BASE 0x100000001b3ull    // k-gram 多项式滚动哈希的基数（mod 2^64）
+
+void fp_init(FpVec* v) {
+    v->data = NULL;
+    v->size = 0;
+    v->cap = 0;
+}
+
+void fp_free(FpVec* v) {
+    if (!v) return;
+    free(v->data);
+    fp_init(v);
+}
+
+static bool fp_push(FpVec* v, uint64_t h) {
+    if (v->size == v->cap) {
+        size_t nc = v->cap ? v->cap * 2 : 64;
+        uint64_t* p = (uint64_t*)realloc(v->data, nc * sizeof(uint64_t));
+        if (!p) return false;
+        v->data = p;
+        v->cap = nc;
+    }
+    v->data[v->size++] = h;
+    return true;
+}
+
+/**
+ * @brief 64 位终混合（MurmurHash3 fmix64），使滚动哈希的低位也均匀分布。
+ */
+static uint64_t fmix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+uint64_t fp_symbol_hash(const char* name) {
+    uint64_t h = 1469598103934665603ull;
+    for (const unsigned char* p = (const unsigned char*)name; p && *p; ++ p) {
+        h ^= *p;
+        h *= 1099511628211ull;
+    }
+    return fmix64(h);
+}
+
+/**
+ * @brief 判断名称是否为 tokenizer 归一化出的标识符 var_<N>。
+ */
+static bool is_var_name(const char* s) {
+    if (strncmp(s, "var_", 4) != 0 || s[4] == '\0') return false;
+    for (s += 4; *s; ++ s) if (*s < '0' || *s > '9') return false;
+    return true;
+}
+
+/**
+ * @brief 单个标签的比较用哈希。
+ *
+ * tokenizer 为每次出现的标识符分配递增编号（var_0, var_1, ...），
+ * 编号只反映出现位置；若按名称哈希，含标识符的 k-gram 几乎不可能在两份代码间重合。
+ * 因此所有 var_<N> 共用同一个哈希（即只保留“这里是一个标识符”）。
+ */
+uint64_t fp_label_hash(const char* name) {
+    return fp_symbol_hash(is_var_name(name) ? "var_" : name);
+}
+
+uint64_t* fp_symbol_table(const SymTab* syms) {
+    const size_t n = symtab_size(syms);
+    uint64_t* t = (uint64_t*)malloc((n ? n : 1) * sizeof(uint64_t));
+    if (!t) return NULL;
+    for (size_t i = 0; i < n; i++) t[i] = fp_label_hash(symtab_name(syms, (SymId)i));
+    return t;
+}
+
+static int cmp_u64(const void* x, const void* y) {
+    const uint64_t a = *(const uint64_t*)x, b = *(const uint64_t*)y;
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief Winnowing：每个窗口取最右的最小 k-gram 哈希，最小值位置变化时记录一次。
+ *
+ * 只保留最近 w 个 k-gram 哈希（环形缓冲），不为整条序列分配哈希数组。
+ */
+bool fp_winnow(const SymVec* seq, const uint64_t* sym_hash, size_t k, size_t w, FpVec* out) {
+    if (!seq || !sym_hash || !out || k == 0 || w == 0) return false;
+    out->size = 0;
+    if (seq->size == 0) return true;
+
+    if (k > seq->size) k = seq->size;
+    const size_t ngram = seq->size - k + 1;
+    if (w > ngram) w = ngram;
+
+    uint64_t* ring = (uint64_t*)malloc(w * sizeof(uint64_t));
+    if (!ring) return false;
+
+    // B^(k-1)，滚动时移出最早的符号
+    uint64_t top = 1;
+    for (size_t i = 1; i < k; i++) top *= FP_BASE;
+
+    uint64_t h = 0;
+    for (size_t i = 0; i < k; i++) h = h * FP_BASE + sym_hash[seq->data[i]];
+
+    bool ok = true;
+    size_t min_pos = 0;             // 当前窗口最小值的绝对位置
+    bool have_min = false;
+    for (size_t g = 0; g < ngram && ok; g++) {
+        if (g > 0) {
+            h = (h - sym_hash[seq->data[g - 1]] * top) * FP_BASE + sym_hash[seq->data[g + k - 1]];
+        }
+        const uint64_t gh = fmix64(h);
+        ring[g % w] = gh;
+        if (g + 1 < w) continue;    // 第一个窗口尚未填满
+
+        const size_t lo = g + 1 - w;
+        if (!have_min || min_pos < lo) {
+            // 最小值滑出窗口：重新扫描整个窗口，取最右的最小值
+            min_pos = lo;
+            for (size_t j = lo + 1; j <= g; j++) {
+                if (ring[j % w] <= ring[min_pos % w]) min_pos = j;
+            }
+            have_min = true;
+            ok = fp_push(out, ring[min_pos % w]);
+        } else if (gh <= ring[min_pos % w]) {
+            min_pos = g;
+            ok = fp_push(out, gh);
+        }
+    }
+    free(ring);
+    if (!ok) return false;
+
+    // 升序去重，便于集合求交
+    qsort(out->data, out->size, sizeof(uint64_t), cmp_u64);
+    size_t u = 0;
+    for (size_t i = 0; i < out->size; i++) {
+        if (u == 0 || out->data[u - 1] != out->data[i]) out->data[u++] = out->data[i];
+    }
+    out->size = u;
+    return true;
+}
+
+size_t fp_shared(const FpVec* a, const FpVec* b) {
+    size_t i = 0, j = 0, n = 0;
+    while (i < a->size && j < b->size) {
+        if (a->data[i] < b->data[j]) i++;
+        else if (a->data[i] > b->data[j]) j++;
+        else { n++; i++; j++; }
+    }
+    return n;
+}
+
+double fp_overlap(size_t shared, size_t size_a, size_t size_b) {
+    const size_t m = size_a < size_b ? size_a : size_b;
+    return m ? (double)shared / (double)m : 0.0;
+}
+
+/** @brief 倒排表条目：(指纹, 文件)。 */
+typedef struct {
+    uint64_t h;
+    uint32_t doc;
+} FpPosting;
+
+static int cmp_posting(const void* x, const void* y) {
+    const FpPosting* p = (const FpPosting*)x;
+    const FpPosting* q = (const FpPosting*)y;
+    if (p->h != q->h) return p->h < q->h ? -1 : 1;
+    return (p->doc > q->doc) - (p->doc < q->doc);
+}
+
+static int cmp_size(const void* x, const void* y) {
+    const size_t a = *(const size_t*)x, b = *(const size_t*)y;
+    return (a > b) - (a < b);
+}
+
+/**
+ * @brief 倒排索引求候选对。
+ *
+ * 1) 全部 (指纹, 文件) 按指纹排序，相同指纹连成一组（倒排表）；
+ * 2) 按文件建立“文件 -> 所在组”的 CSR 表；
+ * 3) 对每个文件 a，沿其各组的倒排表为 b > a 的文件累计共享数，
+ *    只有真正共享过指纹的文件对才会被触及。
+ */
+FpCandidate* fp_candidates(const FpVec* sets, size_t n, double min_overlap, size_t max_df,
+                           size_t* ncand) {
+    *ncand = 0;
+    if (n > UINT32_MAX) return NULL;
+
+    size_t total = 0;
+    for (size_t i = 0; i < n; i++) total += sets[i].size;
+
+    FpPosting* post = (FpPosting*)malloc((total ? total : 1) * sizeof(FpPosting));
+    size_t* group_of = (size_t*)malloc((total ? total : 1) * sizeof(size_t));     // 条目 -> 组下标
+    size_t* group_start = (size_t*)malloc((total + 1) * sizeof(size_t));
+    size_t* doc_start = (size_t*)calloc(n + 1, sizeof(size_t));
+    size_t* doc_groups = (size_t*)malloc((total ? total : 1) * sizeof(size_t));
+    uint32_t* count = (uint32_t*)calloc(n ? n : 1, sizeof(uint32_t));
+    size_t* touched = (size_t*)malloc((n ? n : 1) * sizeof(size_t));
+    FpCandidate* cand = NULL;
+    size_t ncap = 0, nc = 0;
+    bool ok = post && group_of && group_start && doc_start && doc_groups && count && touched;
+
+    if (ok) {
+        size_t t = 0;
+        for (size_t d = 0; d < n; d++) {
+            for (size_t i = 0; i < sets[d].size; i++) {
+                post[t].h = sets[d].data[i];
+                post[t].doc = (uint32_t)d;
+                t++;
+            }
+        }
+        qsort(post, total, sizeof(FpPosting), cmp_posting);
+
+        // 分组
+        size_t ng = 0;
+        for (size_t i = 0; i < total; i++) {
+            if (i == 0 || post[i].h != post[i - 1].h) group_start[ng++] = i;
+            group_of[i] = ng - 1;
+        }
+        group_start[ng] = total;
+
+        // 文件 -> 组（CSR）；每个文件的组下标按指纹升序
+        for (size_t i = 0; i < total; i++) doc_start[post[i].doc + 1]++;
+        for (size_t d = 0; d < n; d++) doc_start[d + 1] += doc_start[d];
+        size_t* fill = touched;     // 借用 touched 作为填充游标
+        for (size_t d = 0; d < n; d++) fill[d] = doc_start[d];
+        for (size_t i = 0; i < total; i++) doc_groups[fill[post[i].doc]++] = group_of[i];
+    }
+
+    for (size_t a = 0; ok && a < n; a++) {
+        size_t nt = 0;
+        for (size_t gi = doc_start[a]; gi < doc_start[a + 1]; gi++) {
+            const size_t g = doc_groups[gi];
+            const size_t lo = group_start[g], hi = group_start[g + 1];
+            if (max_df && hi - lo > max_df) continue;
+            for (size_t i = lo; i < hi; i++) {
+                const size_t b = post[i].doc;
+                if (b <= a) continue;
+                if (count[b]++ == 0) touched[nt++] = b;
+            }
+        }
+
+        qsort(touched, nt, sizeof(size_t), cmp_size);
+        for (size_t i = 0; i < nt; i++) {
+            const size_t b = touched[i];
+            const double ov = fp_overlap(count[b], sets[a].size, sets[b].size);
+            if (ok && ov >= min_overlap) {
+                if (nc == ncap) {
+                    size_t cap2 = ncap ? ncap * 2 : 64;
+                    FpCandidate* p = (FpCandidate*)realloc(cand, cap2 * sizeof(FpCandidate));
+                    if (!p) ok = false;
+                    else { cand = p; ncap = cap2; }
+                }
+                if (ok) {
+                    cand[nc].a = a;
+                    cand[nc].b = b;
+                    cand[nc].shared = count[b];
+                    cand[nc].overlap = ov;
+                    nc++;
+                }
+            }
+            count[b] = 0;
+        }
+    }
+
+    free(post);
+    free(group_of);
+    free(group_start);
+    free(doc_start);
+    free(doc_groups);
+    free(count);
+    free(touched);
+
+    if (!ok) {
+        free(cand);
+        return NULL;
+    }
+    if (!cand) cand = (FpCandidate*)malloc(sizeof(FpCandidate));   // 无候选时也返回可 free 的非 NULL 指针
+    if (!cand) return NULL;
+    *ncand = nc;
+    return cand;
+}
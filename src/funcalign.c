@@ -0,0 +1,382 @@
+/**
+* @file funcalign.c
+ * @brief 函数级对齐的实现：并行填充相似度矩阵，匈牙利算法求最优匹配。
+ */
+
+#include "../include/funcalign.h"
+#include "../include/threadpool.h"
+#include "../include/fingerprint.h"
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FSC_MAGIC  "CDFP"
+#define FSC_FORMAT 1u
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * @brief 函数级比较用的局部序列：标识符按函数内出现次序重新编号。
+ *
+ * 全文件递增的 var_<N> 使同一个函数放在文件不同位置时序列不同；
+ * 改为函数内编号（编号 ID 取 symtab_size 之后的区间，不与其它符号冲突）后，
+ * 摘要相同的函数序列必然逐符号相同，得分也就与函数所在位置无关，可以跨次复用。
+ */
+typedef struct {
+    SymId*    data;     // 全部函数的局部序列首尾相接
+    size_t*   off;      // 第 i 个函数为 data[off[i], off[i+1])
+    uint64_t* key;      // 局部序列的内容键（只依赖符号名称，跨进程稳定）
+} LocalSeqs;
+
+static void local_free(LocalSeqs* ls) {
+    free(ls->data);
+    free(ls->off);
+    free(ls->key);
+}
+
+static bool is_var_name(const char* s) {
+    if (strncmp(s, "var_", 4) != 0 || s[4] == '\0') return false;
+    for (s += 4; *s; ++ s) if (*s < '0' || *s > '9') return false;
+    return true;
+}
+
+static bool build_local(const SymVec* seq, const FuncTable* ft, const bool* is_var,
+                        const uint64_t* name_hash, SymId nsym, LocalSeqs* ls) {
+    size_t total = 0;
+    for (size_t i = 0; i < ft->size; i++) total += ft->data[i].seq_end - ft->data[i].seq_begin;
+    ls->data = (SymId*)malloc((total ? total : 1) * sizeof(SymId));
+    ls->off = (size_t*)malloc((ft->size + 1) * sizeof(size_t));
+    ls->key = (uint64_t*)malloc((ft->size ? ft->size : 1) * sizeof(uint64_t));
+    if (!ls->data || !ls->off || !ls->key) return false;
+
+    size_t k = 0;
+    for (size_t i = 0; i < ft->size; i++) {
+        ls->off[i] = k;
+        SymId next_var = 0;
+        uint64_t h = mix64(0x243f6a8885a308d3ull + (ft->data[i].seq_end - ft->data[i].seq_begin));
+        for (size_t p = ft->data[i].seq_begin; p < ft->data[i].seq_end; p++) {
+            const SymId s = seq->data[p];
+            if (is_var[s]) {
+                h = mix64(h ^ (0x13198a2e03707344ull + next_var));
+                ls->data[k++] = nsym + next_var++;
+            } else {
+                h = mix64(h ^ name_hash[s]);
+                ls->data[k++] = s;
+            }
+        }
+        ls->key[i] = h;
+    }
+    ls->off[ft->size] = k;
+    return true;
+}
+
+static SymVec local_slice(const LocalSeqs* ls, size_t i) {
+    SymVec v = { ls->data + ls->off[i], ls->off[i + 1] - ls->off[i], ls->off[i + 1] - ls->off[i] };
+    return v;
+}
+
+/** @brief 函数对得分的键：顺序无关（编辑距离对称）。 */
+static void pair_key(uint64_t ka, uint64_t kb, uint64_t* k0, uint64_t* k1) {
+    *k0 = ka < kb ? ka : kb;
+    *k1 = ka < kb ? kb : ka;
+}
+
+static FuncScoreEntry* fscore_slot(const FuncScoreCache* c, uint64_t k0, uint64_t k1) {
+    if (c->cap == 0) return NULL;
+    size_t i = (size_t)mix64(k0 ^ (k1 * 0x9e3779b97f4a7c15ull)) & (c->cap - 1);
+    while (c->slots[i].used && !(c->slots[i].ka == k0 && c->slots[i].kb == k1)) i = (i + 1) & (c->cap - 1);
+    return &c->slots[i];
+}
+
+static bool fscore_put(FuncScoreCache* c, uint64_t k0, uint64_t k1, uint64_t dist) {
+    if ((c->count + 1) * 2 > c->cap) {
+        const size_t nc = c->cap ? c->cap * 2 : 1024;
+        FuncScoreCache grown = { (FuncScoreEntry*)calloc(nc, sizeof(FuncScoreEntry)), nc, 0, c->hits, c->added };
+        if (!grown.slots) return false;
+        for (size_t i = 0; i < c->cap; i++) {
+            if (!c->slots[i].used) continue;
+            *fscore_slot(&grown, c->slots[i].ka, c->slots[i].kb) = c->slots[i];
+            grown.count++;
+        }
+        free(c->slots);
+        *c = grown;
+    }
+    FuncScoreEntry* e = fscore_slot(c, k0, k1);
+    if (!e->used) c->count++;
+    e->used = true;
+    e->ka = k0;
+    e->kb = k1;
+    e->dist = dist;
+    return true;
+}
+
+void fscore_init(FuncScoreCache* c) {
+    memset(c, 0, sizeof(*c));
+}
+
+void fscore_free(FuncScoreCache* c) {
+    if (!c) return;
+    free(c->slots);
+    fscore_init(c);
+}
+
+bool fscore_load(FuncScoreCache* c, const char* path) {
+    if (!c || !path) return false;
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    char magic[4];
+    uint32_t format = 0;
+    uint64_t count = 0;
+    bool ok = fread(magic, 1, 4, fp) == 4 && memcmp(magic, FSC_MAGIC, 4) == 0
+           && fread(&format, 4, 1, fp) == 1 && format == FSC_FORMAT
+           && fread(&count, 8, 1, fp) == 1;
+    for (uint64_t i = 0; ok && i < count; i++) {
+        uint64_t e[3];
+        ok = fread(e, 8, 3, fp) == 3 && fscore_put(c, e[0], e[1], e[2]);
+    }
+    fclose(fp);
+    c->added = 0;
+    return ok;
+}
+
+bool fscore_save(const FuncScoreCache* c, const char* path) {
+    if (!c || !path) return false;
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+
+    const uint32_t format = FSC_FORMAT;
+    const uint64_t count = c->count;
+    bool ok = fwrite(FSC_MAGIC, 1, 4, fp) == 4 && fwrite(&format, 4, 1, fp) == 1
+           && fwrite(&count, 8, 1, fp) == 1;
+    for (size_t i = 0; ok && i < c->cap; i++) {
+        if (!c->slots[i].used) continue;
+        const uint64_t e[3] = { c->slots[i].ka, c->slots[i].kb, c->slots[i].dist };
+        ok = fwrite(e, 8, 3, fp) == 3;
+    }
+    if (fclose(fp) != 0) ok = false;
+    if (!ok) remove(path);
+    return ok;
+}
+
+enum { ALIGN_COMPUTED = 0, ALIGN_REUSED, ALIGN_IDENTICAL };
+
+typedef struct {
+    const LocalSeqs*       la;
+    const LocalSeqs*       lb;
+    size_t                 nb;
+    const FuncScoreCache*  scores;
+    EditEngine             engine;
+    size_t*                dist;
+    double*                sim;
+    unsigned char*         how;     // 每个函数对得分的来源（ALIGN_*）
+} AlignJob;
+
+static void align_task(void* ctx, size_t index, int worker) {
+    (void)worker;
+    AlignJob* job = (AlignJob*)ctx;
+    const size_t i = index / job->nb, j = index % job->nb;
+    const SymVec a = local_slice(job->la, i);
+    const SymVec b = local_slice(job->lb, j);
+    const uint64_t ka = job->la->key[i], kb = job->lb->key[j];
+
+    size_t dist;
+    unsigned char how = ALIGN_COMPUTED;
+    const FuncScoreEntry* e = NULL;
+    if (job->scores) {
+        uint64_t k0, k1;
+        pair_key(ka, kb, &k0, &k1);
+        e = fscore_slot(job->scores, k0, k1);
+        if (e && !e->used) e = NULL;
+    }
+    if (e) {
+        dist = (size_t)e->dist;
+        how = ALIGN_REUSED;
+    } else if (ka == kb && a.size == b.size && memcmp(a.data, b.data, a.size * sizeof(SymId)) == 0) {
+        dist = 0;
+        how = ALIGN_IDENTICAL;
+    } else {
+        dist = edit_distance_symvec(&a, &b, job->engine);
+    }
+    job->how[index] = how;
+    job->dist[index] = dist;
+    job->sim[index] = similarity_from_dist(dist, a.size, b.size);
+}
+
+/**
+ * @brief 匈牙利算法（势函数版，O(n²·m)）：n <= m，cost 为 n × m 行优先，求最小总代价。
+ *
+ * @param row_of 输出：row_of[j] 为分配到列 j 的行（n 表示未分配）。
+ */
+static bool hungarian(const double* cost, size_t n, size_t m, size_t* row_of) {
+    double* u = (double*)calloc(n + 1, sizeof(double));
+    double* v = (double*)calloc(m + 1, sizeof(double));
+    double* minv = (double*)malloc((m + 1) * sizeof(double));
+    size_t* p = (size_t*)calloc(m + 1, sizeof(size_t));     // p[j]：列 j 匹配的行（1 起，0 为无）
+    size_t* way = (size_t*)calloc(m + 1, sizeof(size_t));
+    bool* used = (bool*)malloc((m + 1) * sizeof(bool));
+    const bool ok = u && v && minv && p && way && used;
+
+    for (size_t i = 1; ok && i <= n; i++) {
+        p[0] = i;
+        size_t j0 = 0;
+        for (size_t j = 0; j <= m; j++) { minv[j] = DBL_MAX; used[j] = false; }
+        do {
+            used[j0] = true;
+            const size_t i0 = p[j0];
+            double delta = DBL_MAX;
+            size_t j1 = 0;
+            for (size_t j = 1; j <= m; j++) {
+                if (used[j]) continue;
+                const double cur = cost[(i0 - 1) * m + (j - 1)] - u[i0] - v[j];
+                if (cur < minv[j]) { minv[j] = cur; way[j] = j0; }
+                if (minv[j] < delta) { delta = minv[j]; j1 = j; }
+            }
+            for (size_t j = 0; j <= m; j++) {
+                if (used[j]) { u[p[j]] += delta; v[j] -= delta; }
+                else minv[j] -= delta;
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            const size_t j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+    if (ok) for (size_t j = 1; j <= m; j++) row_of[j - 1] = p[j] ? p[j] - 1 : n;
+
+    free(u);
+    free(v);
+    free(minv);
+    free(p);
+    free(way);
+    free(used);
+    return ok;
+}
+
+static int cmp_match(const void* x, const void* y) {
+    const FuncMatch* p = (const FuncMatch*)x;
+    const FuncMatch* q = (const FuncMatch*)y;
+    return (p->a > q->a) - (p->a < q->a);
+}
+
+bool func_align(const SymTab* syms, const SymVec* seq_a, const FuncTable* fa,
+                const SymVec* seq_b, const FuncTable* fb, EditEngine engine, int jobs,
+                FuncScoreCache* scores, FuncAlignment* out) {
+    if (!syms || !seq_a || !fa || !seq_b || !fb || !out) return false;
+    memset(out, 0, sizeof(*out));
+    out->na = fa->size;
+    out->nb = fb->size;
+    if (fa->size == 0 || fb->size == 0) return true;
+
+    const size_t na = fa->size, nb = fb->size, cells = na * nb;
+    const size_t nsym = symtab_size(syms);
+    bool* is_var = (bool*)malloc(nsym ? nsym : 1);
+    uint64_t* name_hash = (uint64_t*)malloc((nsym ? nsym : 1) * sizeof(uint64_t));
+    LocalSeqs la = { NULL, NULL, NULL }, lb = { NULL, NULL, NULL };
+    size_t* dist = (size_t*)malloc(cells * sizeof(size_t));
+    unsigned char* how = (unsigned char*)malloc(cells);
+    out->sim = (double*)malloc(cells * sizeof(double));
+    const size_t nmatch = na < nb ? na : nb;
+    out->matches = (FuncMatch*)malloc(nmatch * sizeof(FuncMatch));
+
+    bool ok = is_var && name_hash && dist && how && out->sim && out->matches;
+    for (size_t i = 0; ok && i < nsym; i++) {
+        const char* name = symtab_name(syms, (SymId)i);
+        is_var[i] = is_var_name(name);
+        name_hash[i] = fp_symbol_hash(name);
+    }
+    ok = ok && build_local(seq_a, fa, is_var, name_hash, (SymId)nsym, &la)
+            && build_local(seq_b, fb, is_var, name_hash, (SymId)nsym, &lb);
+    free(is_var);
+    free(name_hash);
+
+    if (ok) {
+        AlignJob job = { &la, &lb, nb, scores, edit_engine_serial(engine), dist, out->sim, how };
+        ThreadPool* pool = (jobs == 1 || cells < 2) ? NULL : tp_create(jobs);
+        tp_parallel_for(pool, cells, align_task, &job);
+        tp_destroy(pool);
+
+        // 新算出的得分串行写回（并行阶段只读 scores）
+        for (size_t k = 0; scores && k < cells; k++) {
+            if (how[k] == ALIGN_REUSED) {
+                scores->hits++;
+            } else if (how[k] == ALIGN_COMPUTED) {
+                uint64_t k0, k1;
+                pair_key(la.key[k / nb], lb.key[k % nb], &k0, &k1);
+                if (fscore_put(scores, k0, k1, dist[k])) scores->added++;
+            }
+        }
+    }
+    local_free(&la);
+    local_free(&lb);
+    free(how);
+    if (!ok) {
+        free(dist);
+        func_alignment_free(out);
+        return false;
+    }
+
+    // 权重 = 相似度 × 两函数长度之和；转置使行数不超过列数，代价 = 最大权重 - 权重
+    const bool flip = na > nb;
+    const size_t n = flip ? nb : na, m = flip ? na : nb;
+    double* cost = (double*)malloc(cells * sizeof(double));
+    size_t* row_of = (size_t*)malloc(m * sizeof(size_t));
+    ok = cost && row_of;
+    double total_len = 0.0, wmax = 0.0;
+    for (size_t i = 0; i < na; i++) total_len += (double)(fa->data[i].seq_end - fa->data[i].seq_begin);
+    for (size_t j = 0; j < nb; j++) total_len += (double)(fb->data[j].seq_end - fb->data[j].seq_begin);
+
+    if (ok) {
+        for (size_t i = 0; i < na; i++) {
+            for (size_t j = 0; j < nb; j++) {
+                const double len = (double)(fa->data[i].seq_end - fa->data[i].seq_begin
+                                          + fb->data[j].seq_end - fb->data[j].seq_begin);
+                const double w = out->sim[i * nb + j] * len;
+                cost[flip ? j * m + i : i * m + j] = w;
+                if (w > wmax) wmax = w;
+            }
+        }
+        for (size_t k = 0; k < cells; k++) cost[k] = wmax - cost[k];
+        ok = hungarian(cost, n, m, row_of);
+    }
+
+    if (ok) {
+        double score = 0.0;
+        for (size_t c = 0; c < m; c++) {
+            if (row_of[c] == n) continue;
+            const size_t i = flip ? c : row_of[c], j = flip ? row_of[c] : c;
+            FuncMatch* fm = &out->matches[out->nmatch++];
+            fm->a = i;
+            fm->b = j;
+            fm->dist = dist[i * nb + j];
+            fm->sim = out->sim[i * nb + j];
+            score += fm->sim * (double)(fa->data[i].seq_end - fa->data[i].seq_begin
+                                      + fb->data[j].seq_end - fb->data[j].seq_begin);
+        }
+        qsort(out->matches, out->nmatch, sizeof(FuncMatch), cmp_match);
+        out->overall = total_len > 0.0 ? score / total_len : 0.0;
+    }
+
+    free(cost);
+    free(row_of);
+    free(dist);
+    if (!ok) func_alignment_free(out);
+    return ok;
+}
+
+void func_alignment_free(FuncAlignment* al) {
+    if (!al) return;
+    free(al->sim);
+    free(al->matches);
+    memset(al, 0, sizeof(*al));
+}
@@ -13,6 +13,20 @@
 #include "edit_distance.c.h"
 #include "tokenizer.h"
 #include "std_token.h"
+#include "symtab.h"
+#include "pipeline.h"
+#include "batch.h"
+#include "filemap.h"
+#include "fingerprint.h"
+#include "minhash.h"
+#include "merkle.h"
+#include "funcalign.h"
+#include "edit_align.h"
+#include "stats.h"
+#include "report.h"
+#include "edit_cost.h"
+#include "serve.h"
+#include <time.h>
 
 // ========== UI 美化宏定义 ==========
 // ANSI 颜色代码
@@ -36,6 +50,8 @@
 
 // ========== 工具函数 ==========
 
+const char* verdict_short(double similarity);
+
 /**
  * 打印带颜色的进度条
  * @param label 当前操作描述
@@ -66,151 +82,68 @@ void print_separator() {
 }
 
 /**
- * 读取文件内容到字符串
+ * 以只读映射打开文件（大文件不再整体复制到堆上）
  */
-char* read_file(const char* filename) {
-    FILE* fp = fopen(filename, "r");
-    if (!fp) {
+int open_source(const char* filename, FileMap* out) {
+    if (!filemap_open(out, filename)) {
         printf("  " RED ICON_CROSS " [错误] 无法打开文件: %s" RESET "\n", filename);
-        return NULL;
-    }
-
-    fseek(fp, 0, SEEK_END);
-    long size = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    char* content = (char*)malloc(size + 1);
-    if (!content) {
-        printf("  " RED ICON_CROSS " [错误] 内存分配失败" RESET "\n");
-        fclose(fp);
-        return NULL;
+        return 0;
     }
-
-    size_t read_size = fread(content, 1, size, fp);
-    content[read_size] = '\0';
-    fclose(fp);
-
-    return content;
+    return 1;
 }
 
 /**
- * 将源代码转换为Token数组
+ * 错误提示：终端模式为彩色输出；机器可读模式（rep 非 NULL）写到标准错误，不混入结果
  */
+void print_error(const ReportWriter* rep, const char* what, const char* arg) {
+    if (rep) fprintf(stderr, "[错误] %s: %s\n", what, arg);
+    else printf("  " RED ICON_CROSS " [错误] %s: %s" RESET "\n", what, arg);
+}
+
 /**
- * 将源代码转换为Token数组 (修复了内存泄露隐患)
+ * 跳过的文件：终端模式为黄色提示，机器可读模式写到标准错误
  */
-Token** tokenize_code(const char* source, size_t* token_count) {
-    Tokenizer tk;
-    tokenizer_init(&tk, source);
-
-    size_t capacity = 1024;
-    size_t count = 0;
-    Token** tokens = (Token**)malloc(capacity * sizeof(Token*));
-
-    if (!tokens) return NULL;
-
-    while (!tokenizer_is_eof(&tk)) {
-        Token* tok = tokenizer_next_token(&tk);
-
-        // 处理 tokenizer 返回 NULL 或 EOF 的情况
-        if (!tok || tok->type == TOKEN_EOF) {
-            if (tok) token_free(tok);
-            break;
-        }
-
-        // 扩容检查
-        if (count >= capacity) {
-            size_t new_capacity = capacity * 2;
-            Token** new_tokens = (Token**)realloc(tokens, new_capacity * sizeof(Token*));
-
-            if (!new_tokens) {
-                // [修复] 扩容失败时，必须释放所有已分配的 Token 和数组本身
-                fprintf(stderr, RED "  [错误] 内存不足，Token数组扩容失败\n" RESET);
-                for (size_t i = 0; i < count; i++) {
-                    token_free(tokens[i]);
-                }
-                free(tokens);
-                return NULL;
-            }
-            tokens = new_tokens;
-            capacity = new_capacity;
-        }
-
-        tokens[count++] = tok;
-    }
-
-    *token_count = count;
-    return tokens;
+void print_skipped(const ReportWriter* rep, const char* path) {
+    if (rep) fprintf(stderr, "[跳过] %s（无法读取或无有效代码）\n", path);
+    else printf("  " YELLOW ICON_ARROW " [跳过] %s（无法读取或无有效代码）\n" RESET, path);
 }
 
 /**
  * 处理单个代码文件
+ * 输出为驻留到 syms 的符号序列，两个文件须共用同一张符号表
  */
-int process_code(const char* filename, const char* source, StrVec* out_vec) {
+int process_code(const char* filename, const char* source, size_t len, SymTab* syms, SymVec* out_vec,
+                 SeqCache* cache, int jobs) {
     printf("\n" BOLD WHITE "┌── 处理文件: %s" RESET "\n", filename);
 
-    // --- 步骤 1: 词法分析 ---
-    print_step("词法分析", 0);
+    // --- 词法分析 -> 语法分析 -> 序列化（流式：逐个顶层函数完成后立即序列化并回收） ---
+    print_step("流式解析", 0);
 
     size_t token_count = 0;
-    Token** tokens = tokenize_code(source, &token_count);
-
-    // 情况 1: 内存分配完全失败 (tokens 为 NULL)
-    if (!tokens) {
-        print_step("词法分析", -1);
-        return 0;
-    }
-
-    // 情况 2: 文件是空的 (tokens 不为 NULL，但数量为 0)
-    // [修复点] 这个检查必须在 if (!tokens) 外面
-    if (token_count == 0) {
-        printf("  " YELLOW ICON_ARROW " [警告] 文件为空或无有效代码\n" RESET);
-        print_step("词法分析", -1); // 标记为失败（因为无法进行后续步骤）
-        free(tokens); // 释放刚才分配的空数组
-        return 0;
-    }
-
-    // 成功
-    print_step("词法分析", 1);
-
-    // --- 步骤 2: 语法分析 ---
-    print_step("构建语法树(AST)", 0);
-
-    ASTNode* ast = ast_parse_tokens((Token* const*)tokens, token_count);
-
-    if (!ast) {
-        print_step("构建语法树(AST)", -1);
-        // 清理资源
-        for (size_t i = 0; i < token_count; i++) token_free(tokens[i]);
-        free(tokens);
-        return 0;
-    }
-    print_step("构建语法树(AST)", 1);
-
-    // --- 步骤 3: 序列化 ---
-    print_step("结构序列化", 0);
-
-    sv_init(out_vec);
-    int serial_success = ast_serialize_preorder(ast, out_vec);
-
-    if (!serial_success) {
-        print_step("结构序列化", -1);
-        ast_free(ast);
-        for (size_t i = 0; i < token_count; i++) token_free(tokens[i]);
-        free(tokens);
-        sv_free(out_vec);
+    bool from_cache = false;
+    const size_t frag_hits = cache ? cache->frag_hits : 0;
+    symv_init(out_vec);
+    // 无缓存时大文件按顶层边界切块并行分析（结果与串行一致）
+    const bool ok = cache ? pipeline_load_symbols(cache, source, len, syms, out_vec, &token_count, &from_cache)
+                          : pipeline_build_parallel(source, len, syms, out_vec, &token_count, jobs);
+    if (!ok) {
+        // 文件是空的 (没有任何 token)
+        if (token_count == 0) {
+            printf("  " YELLOW ICON_ARROW " [警告] 文件为空或无有效代码\n" RESET);
+        }
+        print_step("流式解析", -1);
+        symv_free(out_vec);
         return 0;
     }
-    print_step("结构序列化", 1);
-
-    // --- 资源清理 ---
-    // 先释放AST
-    ast_free(ast);
-    // 再释放Token (安全)
-    for (size_t i = 0; i < token_count; i++) {
-        token_free(tokens[i]);
+    print_step("流式解析", 1);
+    if (from_cache) {
+        printf("  " GREEN ICON_CHECK " 命中缓存，跳过词法与语法分析" RESET "\n");
+    } else if (cache && cache->frag_hits > frag_hits) {
+        printf("  " GREEN ICON_CHECK " 增量分析: 复用 %zu 个未修改片段，重新识别 %zu 个Token" RESET "\n",
+               cache->frag_hits - frag_hits, token_count);
+    } else {
+        printf("  " GREEN ICON_CHECK " 共识别 %zu 个Token" RESET "\n", token_count);
     }
-    free(tokens);
 
     // 总结输出
     printf("  " MAGENTA ICON_STAR " 特征提取完成:" RESET " 生成 %zu 个特征节点\n", out_vec->size);
@@ -284,42 +217,240 @@ void print_centered_row(const char* text, int box_width, const char* border) {
     printf("%s\n", border);
 }
 
+/**
+ * 函数级摘要：列出两份代码中结构完全相同的函数（整文件相似度会被其余代码稀释）
+ */
+void print_function_matches(const SymTab* syms, const SymVec* seq1, const SymVec* seq2) {
+    FuncTable fa, fb;
+    functable_init(&fa);
+    functable_init(&fb);
+    if (functable_from_symbols(syms, seq1, &fa) && functable_from_symbols(syms, seq2, &fb)) {
+        size_t cap = fa.size < fb.size ? fa.size : fb.size;
+        FuncPair* pairs = (FuncPair*)malloc((cap ? cap : 1) * sizeof(FuncPair));
+        size_t n = 0;
+        if (pairs && functable_join(&fa, &fb, pairs, &n)) {
+            printf("  " MAGENTA ICON_STAR " 函数级: A 共 %zu 个函数，B 共 %zu 个，结构完全相同 %zu 对" RESET "\n",
+                   fa.size, fb.size, n);
+            for (size_t i = 0; i < n; i++) {
+                const FuncDigest* d = &fa.data[pairs[i].a];
+                printf("      A 第 %zu 个函数 = B 第 %zu 个函数（%zu 个特征节点）\n",
+                       pairs[i].a + 1, pairs[i].b + 1, d->seq_end - d->seq_begin);
+            }
+            printf("\n");
+        }
+        free(pairs);
+    }
+    functable_free(&fa);
+    functable_free(&fb);
+}
+
+/**
+ * 函数级对齐报告：每对匹配函数的相似度，以及未匹配的函数
+ */
+void print_alignment(const FuncTable* fa, const FuncTable* fb, const FuncAlignment* al) {
+    printf("  " MAGENTA ICON_STAR " 函数级对齐: A 共 %zu 个函数，B 共 %zu 个，匹配 %zu 对" RESET "\n",
+           al->na, al->nb, al->nmatch);
+    for (size_t i = 0; i < al->nmatch; i++) {
+        const FuncMatch* m = &al->matches[i];
+        const char* color = m->sim >= 0.9 ? RED : m->sim >= 0.6 ? YELLOW : m->sim >= 0.3 ? CYAN : GREEN;
+        printf("      A 第 %3zu 个 (%5zu) <-> B 第 %3zu 个 (%5zu)  %s%6.2f%% %s" RESET "\n",
+               m->a + 1, fa->data[m->a].seq_end - fa->data[m->a].seq_begin,
+               m->b + 1, fb->data[m->b].seq_end - fb->data[m->b].seq_begin,
+               color, m->sim * 100, verdict_short(m->sim));
+    }
+    if (al->na != al->nb) {
+        printf("      （%s 另有 %zu 个函数未匹配）\n", al->na > al->nb ? "A" : "B",
+               (al->na > al->nb ? al->na : al->nb) - al->nmatch);
+    }
+    printf("\n");
+}
+
+/**
+ * 函数级对齐；有缓存目录时复用此前算过的函数对得分并写回
+ */
+int align_functions(const SymTab* syms, const SymVec* seq1, const FuncTable* fa,
+                    const SymVec* seq2, const FuncTable* fb, EditEngine engine, int jobs,
+                    SeqCache* cache, int quiet, FuncAlignment* out) {
+    FuncScoreCache scores;
+    fscore_init(&scores);
+    char path[4096] = "";
+    if (cache) {
+        snprintf(path, sizeof(path), "%s/funcpairs.v%u.fps", cache->dir, (unsigned)PIPELINE_VERSION);
+        fscore_load(&scores, path);
+    }
+
+    int ok = func_align(syms, seq1, fa, seq2, fb, engine, jobs, cache ? &scores : NULL, out)
+             && out->nmatch > 0;
+    if (ok && cache) {
+        if (!quiet) {
+            printf("  " GREEN ICON_CHECK " 函数对得分: 复用 %zu 对，新计算 %zu 对" RESET "\n",
+                   scores.hits, scores.added);
+        }
+        if (scores.added) fscore_save(&scores, path);
+    }
+    fscore_free(&scores);
+    return ok;
+}
+
+/** 差异报告中短于该长度（符号数）的相同段并入相邻的差异块，避免输出碎片 */
+#define DIFF_MIN_MATCH 16
+
+/**
+ * 打印一个差异报告块：操作名 + 两侧源码行区间
+ */
+static void print_diff_block(const char* label, const char* color,
+                             const LineVec* la, size_t a_begin, size_t a_len,
+                             const LineVec* lb, size_t b_begin, size_t b_len, const char* detail) {
+    uint32_t a0, a1, b0, b1;
+    edit_span_lines(la, a_begin, a_len, &a0, &a1);
+    edit_span_lines(lb, b_begin, b_len, &b0, &b1);
+    char ra[32], rb[32];
+    if (a_len) snprintf(ra, sizeof(ra), "%u-%u", a0, a1); else snprintf(ra, sizeof(ra), "(第 %u 行后)", a0);
+    if (b_len) snprintf(rb, sizeof(rb), "%u-%u", b0, b1); else snprintf(rb, sizeof(rb), "(第 %u 行后)", b0);
+    printf("      %s%s" RESET "  A %-14s <->  B %-14s %s\n", color, label, ra, rb, detail);
+}
+
+/**
+ * 差异定位：以线性空间对齐求编辑脚本，把相同/差异段映射回两份源码的行区间
+ *
+ * 重新执行一次前端以取得行号（缓存的序列不含行号），序列与比较时所用的完全一致。
+ */
+void print_diff(const char* file1, const char* file2, SymTab* syms) {
+    FileMap s1, s2;
+    if (!open_source(file1, &s1)) return;
+    if (!open_source(file2, &s2)) { filemap_close(&s1); return; }
+
+    SymVec a, b;
+    LineVec la, lb;
+    symv_init(&a); symv_init(&b);
+    linev_init(&la); linev_init(&lb);
+    EditScript script;
+    edit_script_init(&script);
+
+    int ok = pipeline_build_located(s1.data, s1.size, syms, &a, &la, NULL)
+          && pipeline_build_located(s2.data, s2.size, syms, &b, &lb, NULL)
+          && edit_align(&a, &b, &script);
+    filemap_close(&s1);
+    filemap_close(&s2);
+
+    if (!ok) {
+        printf("  " YELLOW ICON_ARROW " [警告] 差异定位失败（内存不足或前端处理失败）\n" RESET);
+    } else {
+        printf("  " MAGENTA ICON_STAR " 差异定位: 编辑脚本代价 %zu（行号为符号所在的源码行）" RESET "\n", script.dist);
+        size_t i = 0;
+        while (i < script.size) {
+            const EditRun* r = &script.data[i];
+            if (r->op == EDIT_EQUAL && r->a_len >= DIFF_MIN_MATCH) {
+                char detail[64];
+                snprintf(detail, sizeof(detail), "(%zu 个符号)", r->a_len);
+                print_diff_block("相同", GREEN, &la, r->a_begin, r->a_len, &lb, r->b_begin, r->b_len, detail);
+                i++;
+                continue;
+            }
+            // 合并到下一个足够长的相同段为止
+            const size_t a0 = r->a_begin, b0 = r->b_begin;
+            size_t a_end = a0, b_end = b0, nsub = 0, ndel = 0, nins = 0;
+            for (; i < script.size; i++) {
+                const EditRun* q = &script.data[i];
+                if (q->op == EDIT_EQUAL && q->a_len >= DIFF_MIN_MATCH) break;
+                if (q->op == EDIT_SUBST) nsub += q->a_len;
+                else if (q->op == EDIT_DELETE) ndel += q->a_len;
+                else if (q->op == EDIT_INSERT) nins += q->b_len;
+                a_end = q->a_begin + q->a_len;
+                b_end = q->b_begin + q->b_len;
+            }
+            char detail[96];
+            snprintf(detail, sizeof(detail), "(替换 %zu, 删除 %zu, 插入 %zu)", nsub, ndel, nins);
+            print_diff_block("差异", YELLOW, &la, a0, a_end - a0, &lb, b0, b_end - b0, detail);
+        }
+        printf("\n");
+    }
+
+    edit_script_free(&script);
+    linev_free(&la); linev_free(&lb);
+    symv_free(&a); symv_free(&b);
+}
+
+/**
+ * 整文件编辑距离与相似度；costs 非 NULL 时为加权编辑距离（距离以代价计）；
+ * wavefront 引擎按 jobs 取线程数（<= 0 为 CPU 核数）
+ */
+size_t file_distance(const SymTab* syms, const SymVec* a, const SymVec* b, EditEngine engine, int jobs,
+                     const EditCostModel* costs, double* similarity) {
+    EditCosts table;
+    if (costs && edit_costs_bind(&table, costs, syms)) {
+        const size_t dist = edit_distance_weighted(&table, a, b);
+        *similarity = similarity_weighted(&table, dist, a, b);
+        edit_costs_free(&table);
+        return dist;
+    }
+    const size_t dist = engine == ED_ENGINE_WAVEFRONT ? levenshtein_symvec_wavefront(a, b, jobs)
+                                                      : edit_distance_symvec(a, b, engine);
+    *similarity = similarity_from_dist(dist, a->size, b->size);
+    return dist;
+}
+
 /**
  * 比较两个代码文件的相似度
  */
-void compare_files(const char* file1, const char* file2) {
+void compare_files(const char* file1, const char* file2, EditEngine engine, SeqCache* cache,
+                   int by_function, int show_diff, int jobs, const EditCostModel* costs) {
     // 1. Banner
     system("cls"); // 清屏
     printf(CYAN BOLD "\n╔════════════════════════════════════════════════════════════╗\n");
     printf("║             " ICON_CODE " 代码结构相似度检测系统 v3.0         ║\n");
     printf("╚════════════════════════════════════════════════════════════╝\n" RESET);
 
-    char* source1 = read_file(file1);
-    char* source2 = read_file(file2);
-
-    if (!source1 || !source2) {
-        if(source1) free(source1);
-        if(source2) free(source2);
+    FileMap source1, source2;
+    STATS_TIMER(t_read);
+    if (!open_source(file1, &source1)) return;
+    if (!open_source(file2, &source2)) {
+        filemap_close(&source1);
         return;
     }
+    STATS_STAGE_END(t_read, ST_STAGE_READ);
 
     // 2. 处理代码 (process_code 内部已含步骤打印)
-    StrVec seq1, seq2;
-    int success1 = process_code(file1, source1, &seq1);
-    int success2 = process_code(file2, source2, &seq2);
+    SymTab syms;
+    symtab_init(&syms);
 
-    free(source1);
-    free(source2);
+    SymVec seq1, seq2;
+    STATS_TIMER(t_front);
+    int success1 = process_code(file1, source1.data, source1.size, &syms, &seq1, cache, jobs);
+    int success2 = process_code(file2, source2.data, source2.size, &syms, &seq2, cache, jobs);
+    STATS_STAGE_END(t_front, ST_STAGE_FRONTEND);
+
+    filemap_close(&source1);
+    filemap_close(&source2);
 
     if (!success1 || !success2) {
-        if (success1) sv_free(&seq1);
-        if (success2) sv_free(&seq2);
+        if (success1) symv_free(&seq1);
+        if (success2) symv_free(&seq2);
+        symtab_free(&syms);
         return;
     }
 
-    // 3. 计算相似度
-    size_t distance = levenshtein_strvec(&seq1, &seq2);
-    double similarity = similarity_from_dist(distance, seq1.size, seq2.size);
+    // 3. 计算相似度（函数级模式下为按函数长度加权的匹配相似度）
+    FuncTable fa, fb;
+    FuncAlignment align;
+    functable_init(&fa);
+    functable_init(&fb);
+    memset(&align, 0, sizeof(align));
+    if (by_function) {
+        STATS_TIMER(t_align);
+        if (!functable_from_symbols(&syms, &seq1, &fa) || !functable_from_symbols(&syms, &seq2, &fb)
+            || !align_functions(&syms, &seq1, &fa, &seq2, &fb, engine, jobs, cache, 0, &align)) {
+            printf("  " YELLOW ICON_ARROW " [警告] 未能按函数对齐（无函数定义），改为整文件比较\n" RESET);
+            by_function = 0;
+        }
+        STATS_STAGE_END(t_align, ST_STAGE_ALIGN);
+    }
+    double similarity = align.overall;
+    if (!by_function) {
+        STATS_TIMER(t_dist);
+        file_distance(&syms, &seq1, &seq2, engine, jobs, costs, &similarity);
+        STATS_STAGE_END(t_dist, ST_STAGE_DISTANCE);
+    }
 
     // ================= UI 动态绘制逻辑 =================
 
@@ -419,28 +550,704 @@ void compare_files(const char* file1, const char* file2) {
     printf("╝\n" RESET);
     printf("\n");
 
+    if (by_function) print_alignment(&fa, &fb, &align);
+    else print_function_matches(&syms, &seq1, &seq2);
+    if (show_diff) {
+        STATS_TIMER(t_diff);
+        print_diff(file1, file2, &syms);
+        STATS_STAGE_END(t_diff, ST_STAGE_DIFF);
+    }
+
     // 清理
-    sv_free(&seq1);
-    sv_free(&seq2);
+    func_alignment_free(&align);
+    functable_free(&fa);
+    functable_free(&fb);
+    symv_free(&seq1);
+    symv_free(&seq2);
+    symtab_free(&syms);
+}
+
+/** 机器可读模式各类记录的列名 */
+static const char* const PAIR_COLS[] = { "file_a", "file_b", "mode", "similarity", "distance", "len_a", "len_b" };
+static const char* const BATCH_COLS[] = { "rank", "file_a", "file_b", "similarity", "distance" };
+static const char* const QUERY_COLS[] = { "rank", "file", "similarity", "estimate" };
+static const char* const INDEX_COLS[] = { "index", "files", "added", "documents" };
+#define NCOLS(cols) (sizeof(cols) / sizeof((cols)[0]))
+
+int load_sequence(const char* path, SymTab* syms, SymVec* out, SeqCache* cache, int jobs);
+
+/**
+ * 机器可读模式的双文件比较：不清屏、不绘制界面，只写出一条记录
+ * 函数级模式下 similarity 为按函数长度加权的整体相似度，distance 为空
+ */
+int report_pair(ReportWriter* rep, const char* file1, const char* file2, EditEngine engine,
+                SeqCache* cache, int by_function, int jobs, const EditCostModel* costs) {
+    SymTab syms;
+    symtab_init(&syms);
+    SymVec seq1, seq2;
+    if (!load_sequence(file1, &syms, &seq1, cache, jobs)) {
+        print_error(rep, "无法读取文件或无有效代码", file1);
+        symtab_free(&syms);
+        return 1;
+    }
+    if (!load_sequence(file2, &syms, &seq2, cache, jobs)) {
+        print_error(rep, "无法读取文件或无有效代码", file2);
+        symv_free(&seq1);
+        symtab_free(&syms);
+        return 1;
+    }
+
+    FuncTable fa, fb;
+    FuncAlignment align;
+    functable_init(&fa);
+    functable_init(&fb);
+    memset(&align, 0, sizeof(align));
+    if (by_function) {
+        STATS_TIMER(t_align);
+        if (!functable_from_symbols(&syms, &seq1, &fa) || !functable_from_symbols(&syms, &seq2, &fb)
+            || !align_functions(&syms, &seq1, &fa, &seq2, &fb, engine, jobs, cache, 1, &align)) {
+            by_function = 0;    // 与终端模式一致：无函数定义时改为整文件比较
+        }
+        STATS_STAGE_END(t_align, ST_STAGE_ALIGN);
+    }
+
+    report_str(rep, file1);
+    report_str(rep, file2);
+    report_str(rep, by_function ? "function" : "file");
+    if (by_function) {
+        report_real(rep, align.overall);
+        report_null(rep);
+    } else {
+        STATS_TIMER(t_dist);
+        double similarity = 0.0;
+        const size_t dist = file_distance(&syms, &seq1, &seq2, engine, jobs, costs, &similarity);
+        STATS_STAGE_END(t_dist, ST_STAGE_DISTANCE);
+        report_real(rep, similarity);
+        report_uint(rep, dist);
+    }
+    report_uint(rep, seq1.size);
+    report_uint(rep, seq2.size);
+    report_end_row(rep);
+
+    func_alignment_free(&align);
+    functable_free(&fa);
+    functable_free(&fb);
+    symv_free(&seq1);
+    symv_free(&seq2);
+    symtab_free(&syms);
+    return 0;
+}
+
+/**
+ * 相似度对应的判定词（批量模式的简短版）
+ */
+const char* verdict_short(double similarity) {
+    if (similarity >= 0.9) return "高度相似";
+    if (similarity >= 0.6) return "中度相似";
+    if (similarity >= 0.3) return "低度相似";
+    return "不相似";
+}
+
+/**
+ * 批量模式：目录/列表中的文件两两比较，输出最可疑的 top_k 对（及可选的相似度矩阵）
+ */
+int run_batch(const char* input, const BatchOptions* opt, size_t top_k, int show_matrix, SeqCache* cache,
+              ReportWriter* rep) {
+    if (!rep) printf(CYAN BOLD "\n══════════ " ICON_CODE " 批量相似度检测 ══════════\n" RESET);
+
+    BatchCorpus corpus;
+    batch_init(&corpus);
+
+    if (!batch_collect(&corpus, input)) {
+        print_error(rep, "无法读取目录或列表文件", input);
+        batch_free(&corpus);
+        return 1;
+    }
+    if (corpus.count < 2) {
+        if (rep) fprintf(stderr, "[警告] 至少需要 2 个文件，当前: %zu\n", corpus.count);
+        else printf("  " YELLOW ICON_ARROW " [警告] 至少需要 2 个文件，当前: %zu\n" RESET, corpus.count);
+        batch_free(&corpus);
+        return 1;
+    }
+
+    // 不需要矩阵、也不做指纹预筛时只求前 top_k 对，按长度上界剪掉绝大部分文件对
+    const int top_only = !show_matrix && opt->prefilter <= 0.0;
+
+    // 1. 前端：每个文件只处理一次
+    if (!rep) print_step("前端处理", 0);
+    STATS_TIMER(t_front);
+    size_t ok = batch_load(&corpus, cache, opt->jobs);
+    STATS_STAGE_END(t_front, ST_STAGE_FRONTEND);
+    if (rep) {
+        for (size_t i = 0; i < corpus.count; i++) {
+            if (!corpus.files[i].ok) print_skipped(rep, corpus.files[i].path);
+        }
+        size_t npairs = 0;
+        STATS_TIMER(t_dist);
+        BatchPair* pairs = top_only ? batch_top_pairs(&corpus, opt, top_k, &npairs, NULL)
+                                    : batch_compare_all(&corpus, opt, &npairs);
+        STATS_STAGE_END(t_dist, ST_STAGE_DISTANCE);
+        if (!pairs) {
+            batch_free(&corpus);
+            return 1;
+        }
+        if (!top_only) batch_sort_pairs(pairs, npairs);
+        for (size_t i = 0; i < npairs && i < top_k && !pairs[i].below; i++) {
+            report_uint(rep, i + 1);
+            report_str(rep, corpus.files[pairs[i].a].path);
+            report_str(rep, corpus.files[pairs[i].b].path);
+            report_real(rep, pairs[i].sim);
+            report_uint(rep, pairs[i].dist);
+            report_end_row(rep);
+        }
+        free(pairs);
+        batch_free(&corpus);
+        return 0;
+    }
+    print_step("前端处理", 1);
+    printf("  " MAGENTA ICON_STAR " 文件: %zu 个，成功: %zu 个" RESET "\n", corpus.count, ok);
+    if (cache) {
+        printf("  " MAGENTA ICON_STAR " 缓存: 命中 %zu，未命中 %zu，写入 %zu，复用片段 %zu" RESET "\n",
+               cache->hits, cache->misses, cache->stores, cache->frag_hits);
+    }
+    for (size_t i = 0; i < corpus.count; i++) {
+        if (!corpus.files[i].ok) print_skipped(NULL, corpus.files[i].path);
+    }
+
+    // 2. 两两比较
+    print_step("两两比较", 0);
+    size_t npairs = 0, computed = 0;
+    STATS_TIMER(t_dist);
+    BatchPair* pairs = top_only ? batch_top_pairs(&corpus, opt, top_k, &npairs, &computed)
+                                : batch_compare_all(&corpus, opt, &npairs);
+    STATS_STAGE_END(t_dist, ST_STAGE_DISTANCE);
+    if (!pairs) {
+        print_step("两两比较", -1);
+        batch_free(&corpus);
+        return 1;
+    }
+    print_step("两两比较", 1);
+    const size_t total_pairs = ok * (ok > 0 ? ok - 1 : 0) / 2;
+    if (top_only) {
+        printf("  " MAGENTA ICON_STAR " 长度界剪枝: %zu / %zu 对做了距离计算" RESET "\n", computed, total_pairs);
+    } else if (opt->prefilter > 0.0) {
+        printf("  " MAGENTA ICON_STAR " 指纹预筛: %zu / %zu 对进入精确比较" RESET "\n", npairs, total_pairs);
+    }
+
+    // 3. 相似度矩阵（pairs 此时按 (a, b) 字典序排列）
+    if (show_matrix) {
+        const size_t n = corpus.count;
+        double* mat = (double*)malloc(n * n * sizeof(double));
+        if (mat) {
+            for (size_t i = 0; i < n * n; i++) mat[i] = -1.0;
+            for (size_t i = 0; i < n; i++) if (corpus.files[i].ok) mat[i * n + i] = 1.0;
+            for (size_t i = 0; i < npairs; i++) {
+                double v = pairs[i].below ? -2.0 : pairs[i].sim;
+                mat[pairs[i].a * n + pairs[i].b] = v;
+                mat[pairs[i].b * n + pairs[i].a] = v;
+            }
+
+            printf("\n" BOLD "相似度矩阵(%%):" RESET "\n");
+            for (size_t i = 0; i < n; i++) printf("  [%zu] %s\n", i, corpus.files[i].path);
+            printf("%6s", "");
+            for (size_t j = 0; j < n; j++) printf("%8zu", j);
+            printf("\n");
+            for (size_t i = 0; i < n; i++) {
+                printf("%6zu", i);
+                for (size_t j = 0; j < n; j++) {
+                    double v = mat[i * n + j];
+                    if (v == -1.0) printf("%8s", "-");
+                    else if (v == -2.0) {
+                        char cell[16];
+                        snprintf(cell, sizeof(cell), "<%.0f", opt->min_sim * 100);
+                        printf("%8s", cell);
+                    }
+                    else printf("%8.2f", v * 100);
+                }
+                printf("\n");
+            }
+            free(mat);
+        }
+    }
+
+    // 4. 最可疑的 top_k 对
+    if (!top_only) batch_sort_pairs(pairs, npairs);
+    size_t shown = 0;
+    printf("\n" BOLD "最可疑的文件对 (top %zu / 共 %zu 对):" RESET "\n", top_k, top_only ? total_pairs : npairs);
+    for (size_t i = 0; i < npairs && shown < top_k; i++) {
+        const BatchPair* p = &pairs[i];
+        if (p->below) break; // 之后全部低于下限
+        const char* color = p->sim >= 0.9 ? RED : p->sim >= 0.6 ? YELLOW : p->sim >= 0.3 ? CYAN : GREEN;
+        printf("  %3zu. %s%6.2f%% %-8s" RESET "  %s  <->  %s\n",
+               shown + 1, color, p->sim * 100, verdict_short(p->sim),
+               corpus.files[p->a].path, corpus.files[p->b].path);
+        shown++;
+    }
+    if (shown == 0) {
+        printf("  (没有相似度不低于 %.0f%% 的文件对)\n", opt->min_sim * 100);
+    }
+    printf("\n");
+
+    free(pairs);
+    batch_free(&corpus);
+    return 0;
+}
+
+/**
+ * 常驻服务模式：语料只加载一次，之后从标准输入逐行读取请求（协议见 serve.h）
+ */
+int run_serve(const char* input, const ServeOptions* so, ReportWriter* rep) {
+    BatchCorpus corpus;
+    batch_init(&corpus);
+    if (*input && !batch_collect(&corpus, input)) {
+        print_error(rep, "无法读取目录或列表文件", input);
+        batch_free(&corpus);
+        return 1;
+    }
+
+    STATS_TIMER(t_front);
+    const size_t ok = batch_load(&corpus, so->cache, so->opt.jobs);
+    STATS_STAGE_END(t_front, ST_STAGE_FRONTEND);
+    for (size_t i = 0; i < corpus.count; i++) {
+        if (!corpus.files[i].ok) print_skipped(rep, corpus.files[i].path);
+    }
+    fprintf(stderr, "[服务] 语料已加载: %zu / %zu 个文件，等待请求\n", ok, corpus.count);
+
+    const int rc = serve_run(&corpus, so, stdin, rep);
+    batch_free(&corpus);
+    return rc;
+}
+
+/**
+ * 由符号序列计算 MinHash 签名（shingle 为 Winnowing 选出的 k-gram 指纹）
+ */
+int sequence_signature(const SymTab* syms, const SymVec* seq, MinHashSig* sig) {
+    uint64_t* sym_hash = fp_symbol_table(syms);
+    if (!sym_hash) return 0;
+    FpVec set;
+    fp_init(&set);
+    int ok = fp_winnow(seq, sym_hash, FP_DEFAULT_K, FP_DEFAULT_W, &set);
+    if (ok) minhash_sig(&set, sig);
+    fp_free(&set);
+    free(sym_hash);
+    return ok;
+}
+
+/**
+ * 读取单个文件并生成符号序列（不打印步骤，供索引/查询模式使用）
+ */
+int load_sequence(const char* path, SymTab* syms, SymVec* out, SeqCache* cache, int jobs) {
+    FileMap map;
+    STATS_TIMER(t_read);
+    if (!filemap_open(&map, path)) return 0;
+    STATS_STAGE_END(t_read, ST_STAGE_READ);
+    symv_init(out);
+    STATS_TIMER(t_front);
+    int ok = cache ? pipeline_load_symbols(cache, map.data, map.size, syms, out, NULL, NULL)
+                   : pipeline_build_parallel(map.data, map.size, syms, out, NULL, jobs);
+    STATS_STAGE_END(t_front, ST_STAGE_FRONTEND);
+    filemap_close(&map);
+    if (!ok) symv_free(out);
+    return ok;
+}
+
+/**
+ * 索引模式：将目录/列表中的文件签名加入 LSH 索引（同名文件覆盖旧签名）并保存
+ */
+int run_index_add(const char* index_path, const char* input, int jobs, SeqCache* cache, ReportWriter* rep) {
+    if (!rep) printf(CYAN BOLD "\n══════════ " ICON_CODE " 更新相似检索索引 ══════════\n" RESET);
+
+    LshIndex idx;
+    lsh_init(&idx);
+    FILE* probe = fopen(index_path, "rb");
+    if (probe) {
+        fclose(probe);
+        if (!lsh_load(&idx, index_path)) {
+            print_error(rep, "索引文件损坏或版本不符", index_path);
+            return 1;
+        }
+    }
+    const size_t before = idx.count;
+
+    BatchCorpus corpus;
+    batch_init(&corpus);
+    if (!batch_collect(&corpus, input)) {
+        print_error(rep, "无法读取目录或列表文件", input);
+        batch_free(&corpus);
+        lsh_free(&idx);
+        return 1;
+    }
+
+    if (!rep) print_step("前端处理", 0);
+    STATS_TIMER(t_front);
+    size_t ok = batch_load(&corpus, cache, jobs);
+    STATS_STAGE_END(t_front, ST_STAGE_FRONTEND);
+    if (!rep) print_step("前端处理", 1);
+
+    size_t added = 0;
+    for (size_t i = 0; i < corpus.count; i++) {
+        MinHashSig sig;
+        if (!corpus.files[i].ok) {
+            print_skipped(rep, corpus.files[i].path);
+            continue;
+        }
+        if (sequence_signature(&corpus.syms, &corpus.files[i].seq, &sig)
+            && lsh_add(&idx, corpus.files[i].path, &sig)) {
+            added++;
+        }
+    }
+    batch_free(&corpus);
+
+    int rc = 0;
+    if (!lsh_save(&idx, index_path)) {
+        print_error(rep, "无法写入索引文件", index_path);
+        rc = 1;
+    } else if (rep) {
+        report_str(rep, index_path);
+        report_uint(rep, ok);
+        report_uint(rep, added);
+        report_uint(rep, idx.count);
+        report_end_row(rep);
+    } else {
+        printf("  " MAGENTA ICON_STAR " 处理 %zu 个文件，加入 %zu 个签名；索引共 %zu 个文档（新增 %zu）" RESET "\n",
+               ok, added, idx.count, idx.count - before);
+    }
+    lsh_free(&idx);
+    return rc;
+}
+
+typedef struct {
+    size_t doc;
+    double estimate;
+    double sim;     // < 0 表示候选文件已无法读取
+} QueryResult;
+
+static int cmp_query_result(const void* x, const void* y) {
+    const QueryResult* p = (const QueryResult*)x;
+    const QueryResult* q = (const QueryResult*)y;
+    if (p->sim != q->sim) return p->sim > q->sim ? -1 : 1;
+    return (p->doc > q->doc) - (p->doc < q->doc);
+}
+
+/**
+ * 查询模式：LSH 取 top_k 候选，仅对候选计算精确的编辑距离相似度
+ */
+int run_query(const char* index_path, const char* file, size_t top_k, EditEngine engine, int jobs,
+              SeqCache* cache, ReportWriter* rep) {
+    if (!rep) printf(CYAN BOLD "\n══════════ " ICON_CODE " 相似检索 ══════════\n" RESET);
+
+    LshIndex idx;
+    lsh_init(&idx);
+    if (!lsh_load(&idx, index_path)) {
+        print_error(rep, "无法加载索引文件", index_path);
+        return 1;
+    }
+
+    SymTab syms;
+    symtab_init(&syms);
+    SymVec query;
+    MinHashSig sig;
+    if (!load_sequence(file, &syms, &query, cache, jobs)) {
+        print_error(rep, "无法读取文件或无有效代码", file);
+        symtab_free(&syms);
+        lsh_free(&idx);
+        return 1;
+    }
+    if (top_k == 0 || !sequence_signature(&syms, &query, &sig)) {
+        print_error(rep, top_k == 0 ? "候选数（--top）须为正整数" : "无法计算查询文件的签名（内存不足）", file);
+        symv_free(&query);
+        symtab_free(&syms);
+        lsh_free(&idx);
+        return 1;
+    }
+
+    LshHit* hits = (LshHit*)malloc(top_k * sizeof(LshHit));
+    QueryResult* res = (QueryResult*)malloc(top_k * sizeof(QueryResult));
+    size_t nhits = 0;
+    double lookup_ms = 0.0;
+    if (hits && res) {
+        clock_t t0 = clock();
+        nhits = lsh_query(&idx, &sig, top_k, hits);
+        lookup_ms = (double)(clock() - t0) * 1000.0 / CLOCKS_PER_SEC;
+    }
+    if (!rep) {
+        printf("  " MAGENTA ICON_STAR " 索引 %zu 个文档，候选 %zu 个，检索耗时 %.2f ms" RESET "\n",
+               idx.count, nhits, lookup_ms);
+    }
+
+    // 精确比较只针对候选（符号表与查询文件共用）
+    for (size_t i = 0; i < nhits; i++) {
+        SymVec cand;
+        res[i].doc = hits[i].doc;
+        res[i].estimate = hits[i].estimate;
+        res[i].sim = -1.0;
+        if (load_sequence(lsh_doc_name(&idx, hits[i].doc), &syms, &cand, cache, jobs)) {
+            STATS_TIMER(t_dist);
+            size_t dist = engine == ED_ENGINE_WAVEFRONT ? levenshtein_symvec_wavefront(&query, &cand, jobs)
+                                                        : edit_distance_symvec(&query, &cand, engine);
+            STATS_STAGE_END(t_dist, ST_STAGE_DISTANCE);
+            res[i].sim = similarity_from_dist(dist, query.size, cand.size);
+            symv_free(&cand);
+        }
+    }
+    if (nhits) qsort(res, nhits, sizeof(QueryResult), cmp_query_result);
+
+    if (rep) {
+        for (size_t i = 0; i < nhits; i++) {
+            report_uint(rep, i + 1);
+            report_str(rep, lsh_doc_name(&idx, res[i].doc));
+            if (res[i].sim < 0.0) report_null(rep);     // 候选文件已无法读取
+            else report_real(rep, res[i].sim);
+            report_real(rep, res[i].estimate);
+            report_end_row(rep);
+        }
+        nhits = 0;  // 跳过下方的终端输出
+    } else {
+        printf("\n" BOLD "最相似的历史文件 (top %zu):" RESET "\n", top_k);
+    }
+    for (size_t i = 0; i < nhits; i++) {
+        const QueryResult* r = &res[i];
+        const char* name = lsh_doc_name(&idx, r->doc);
+        if (r->sim < 0.0) {
+            printf("  %3zu.    -    %-8s  %s（估计 %.0f%%，文件已无法读取）\n",
+                   i + 1, "", name, r->estimate * 100);
+            continue;
+        }
+        const char* color = r->sim >= 0.9 ? RED : r->sim >= 0.6 ? YELLOW : r->sim >= 0.3 ? CYAN : GREEN;
+        printf("  %3zu. %s%6.2f%% %-8s" RESET "  %s（估计 %.0f%%）\n",
+               i + 1, color, r->sim * 100, verdict_short(r->sim), name, r->estimate * 100);
+    }
+    if (!rep) {
+        if (nhits == 0) printf("  (索引中没有结构相近的文件)\n");
+        printf("\n");
+    }
+
+    free(hits);
+    free(res);
+    symv_free(&query);
+    symtab_free(&syms);
+    lsh_free(&idx);
+    return 0;
 }
 
 // ========== 主程序入口 ==========
 
+/**
+ * 打印用法说明
+ */
+void print_usage(const char* prog) {
+    printf(YELLOW "\n用法: %s [选项] <文件1.c> <文件2.c>\n" RESET, prog);
+    printf(YELLOW "      %s [选项] --batch=<目录|列表文件>\n" RESET, prog);
+    printf(YELLOW "      %s [选项] --index=<索引文件> --index-add=<目录|列表文件>\n" RESET, prog);
+    printf(YELLOW "      %s [选项] --index=<索引文件> --query=<文件.c>\n" RESET, prog);
+    printf("选项:\n");
+    printf("  --engine=dp|bitpar|wavefront  编辑距离引擎 (默认 bitpar; wavefront 为单对大文件多线程分块, 结果均与 dp 一致)\n");
+    printf("  --idents=sequential|scoped  标识符归一化: 逐次编号 var_N (默认), 或按作用域首次出现编号 (局部 id_K/函数 fn_K/全局 gv_K, 抗改名且符号表更小)\n");
+    printf("  --by-function        双文件模式: 按函数两两比较并做最优一对一匹配, 报告每对函数的相似度\n");
+    printf("  --diff               双文件模式: 输出编辑脚本, 列出相同/差异片段在两份源码中的行区间\n");
+    printf("  --batch=PATH         批量模式: 目录下全部 .c/.h, 或每行一个路径的列表文件\n");
+    printf("  --top=K              批量模式: 输出最可疑的 K 对 (默认 20, K 须为正整数)\n");
+    printf("  --min-sim=S          批量模式: 相似度下限 (0~1), 低于下限的文件对提前终止计算\n");
+    printf("  --matrix             批量模式: 额外输出相似度矩阵\n");
+    printf("  --jobs=N             并行线程数 (默认/0 为 CPU 核数, 1 为串行): 批量前端与比较、函数级比较、大文件切块解析、wavefront 引擎\n");
+    printf("  --prefilter=R        批量模式: 指纹预筛, 只精确比较 k-gram 指纹重合度 >= R (0~1) 的文件对\n");
+    printf("  --cache=DIR          结构序列磁盘缓存目录: 内容未变的文件跳过词法/语法分析\n");
+    printf("  --index=PATH         MinHash/LSH 检索索引文件 (配合 --index-add 或 --query)\n");
+    printf("  --index-add=PATH     将目录/列表中的文件签名加入索引 (同路径覆盖)\n");
+    printf("  --query=FILE         在索引中检索与 FILE 最相似的 --top 个文件, 仅对候选精确比较\n");
+    printf("  --costs=kind|FILE    双文件/批量模式: 加权编辑距离 (kind: 循环/分支互换半价, 出标签不计; FILE: 代价规则文件)\n");
+    printf("  --serve=PATH         常驻服务: 加载目录/列表 (可为空) 为语料, 从标准输入逐行读取 query|add|check <文件>, 输出为 --format 记录 (默认 json)\n");
+    printf("  --format=json|csv|tsv 非交互输出: 不清屏、无颜色与边框, 每条结果一行记录 (json 为 JSON Lines)\n");
+    printf("  --stats              结束时输出各阶段耗时与计数 (token/AST 节点/符号/DP 单元/分配字节)\n");
+    printf("  --stats-json         同 --stats, 以单行 JSON 写到标准错误 (需以 ENABLE_STATS=ON 编译)\n");
+    printf("示例:\n");
+    printf("  %s codes/original.c codes/copied.c\n", prog);
+    printf("  %s --batch=submissions/ --top=20 --min-sim=0.6\n", prog);
+    printf("  %s --index=archive.lsh --query=new.c --top=10\n", prog);
+    printf("  %s --serve=archive/ --top=5 < requests.txt\n\n", prog);
+}
+
 int main(int argc, char* argv[]) {
-    // 检查命令行参数
-    if (argc != 3) {
-        printf(YELLOW "\n用法: %s <文件1.c> <文件2.c>\n" RESET, argv[0]);
-        printf("示例:\n");
-        printf("  %s codes/original.c codes/copied.c\n\n", argv[0]);
+    // 解析命令行参数
+    EditEngine engine = ED_ENGINE_BITPAR;
+    const char* files[2] = { NULL, NULL };
+    int nfiles = 0;
+    const char* batch_input = NULL;
+    size_t top_k = 20;
+    double min_sim = 0.0;
+    int show_matrix = 0;
+    int jobs = 0;
+    const char* cache_dir = NULL;
+    double prefilter = 0.0;
+    const char* index_path = NULL;
+    const char* index_add = NULL;
+    const char* query_file = NULL;
+    const char* serve_input = NULL;
+    const char* costs_arg = NULL;
+    int by_function = 0;
+    int show_diff = 0;
+    int show_stats = 0;
+    int stats_json = 0;
+    ReportFormat format = REPORT_TEXT;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--engine=dp") == 0) {
+            engine = ED_ENGINE_DP;
+        } else if (strcmp(argv[i], "--engine=bitpar") == 0) {
+            engine = ED_ENGINE_BITPAR;
+        } else if (strcmp(argv[i], "--engine=wavefront") == 0) {
+            engine = ED_ENGINE_WAVEFRONT;
+        } else if (strncmp(argv[i], "--batch=", 8) == 0) {
+            batch_input = argv[i] + 8;
+        } else if (strncmp(argv[i], "--top=", 6) == 0) {
+            // K 须为正整数（--top=0 在批量、检索与服务模式下都没有意义）
+            char* end = NULL;
+            top_k = (size_t)strtoul(argv[i] + 6, &end, 10);
+            if (top_k == 0 || *end != '\0' || argv[i][6] == '-') {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "--min-sim=", 10) == 0) {
+            min_sim = atof(argv[i] + 10);
+        } else if (strcmp(argv[i], "--idents=scoped") == 0) {
+            pipeline_set_ident_mode(TK_IDENT_SCOPED);
+        } else if (strcmp(argv[i], "--idents=sequential") == 0) {
+            pipeline_set_ident_mode(TK_IDENT_SEQUENTIAL);
+        } else if (strcmp(argv[i], "--by-function") == 0) {
+            by_function = 1;
+        } else if (strcmp(argv[i], "--diff") == 0) {
+            show_diff = 1;
+        } else if (strcmp(argv[i], "--matrix") == 0) {
+            show_matrix = 1;
+        } else if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            jobs = atoi(argv[i] + 7);
+        } else if (strncmp(argv[i], "--prefilter=", 12) == 0) {
+            prefilter = atof(argv[i] + 12);
+        } else if (strncmp(argv[i], "--cache=", 8) == 0) {
+            cache_dir = argv[i] + 8;
+        } else if (strncmp(argv[i], "--index=", 8) == 0) {
+            index_path = argv[i] + 8;
+        } else if (strncmp(argv[i], "--index-add=", 12) == 0) {
+            index_add = argv[i] + 12;
+        } else if (strncmp(argv[i], "--query=", 8) == 0) {
+            query_file = argv[i] + 8;
+        } else if (strncmp(argv[i], "--costs=", 8) == 0) {
+            costs_arg = argv[i] + 8;
+        } else if (strncmp(argv[i], "--serve=", 8) == 0) {
+            serve_input = argv[i] + 8;
+        } else if (strncmp(argv[i], "--format=", 9) == 0) {
+            if (!report_parse_format(argv[i] + 9, &format)) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            show_stats = 1;
+        } else if (strcmp(argv[i], "--stats-json") == 0) {
+            stats_json = 1;
+        } else if (strncmp(argv[i], "--", 2) == 0 || nfiles == 2) {
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            files[nfiles++] = argv[i];
+        }
+    }
+
+    // 索引模式：--index 必须且只能配合 --index-add / --query 之一，且不接受其它输入
+    const int index_mode = index_path || index_add || query_file;
+    if (serve_input) {
+        if (index_mode || batch_input || nfiles != 0 || show_diff || show_matrix || by_function) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (format == REPORT_TEXT) format = REPORT_JSON;    // 服务应答只有机器可读格式
+    } else if (index_mode) {
+        if (!index_path || (index_add != NULL) == (query_file != NULL) || batch_input || nfiles != 0) {
+            print_usage(argv[0]);
+            return 1;
+        }
+    } else if ((batch_input && nfiles != 0) || (!batch_input && nfiles != 2)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // 加权代价：内置 kind 模型或代价文件；只用于整文件与批量比较
+    static EditCostModel cost_model;
+    const EditCostModel* costs = NULL;
+    if (costs_arg) {
+        if (serve_input || index_mode || by_function || show_diff) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        edit_cost_uniform(&cost_model, 2, 2);
+        if (strcmp(costs_arg, "kind") == 0) {
+            edit_cost_kind_preset(&cost_model);
+        } else if (!edit_cost_load(&cost_model, costs_arg)) {
+            fprintf(stderr, "[错误] 无法读取代价文件: %s\n", costs_arg);
+            return 1;
+        }
+        costs = &cost_model;
+    }
+
+    // 差异报告与相似度矩阵只有终端版式
+    if (format != REPORT_TEXT && (show_diff || show_matrix)) {
+        print_usage(argv[0]);
         return 1;
     }
 
-    // 设置控制台编码为 UTF-8 (针对 Windows)
+    // 设置控制台编码为 UTF-8 (针对 Windows；机器可读输出不需要)
     #ifdef _WIN32
-    system("chcp 65001 > nul");
+    if (format == REPORT_TEXT) system("chcp 65001 > nul");
     #endif
 
-    compare_files(argv[1], argv[2]);
+    // 磁盘缓存不可用时只给出警告，照常执行完整前端
+    SeqCache cache;
+    SeqCache* cache_ptr = NULL;
+    if (cache_dir) {
+        if (seqcache_open(&cache, cache_dir)) cache_ptr = &cache;
+        else if (format != REPORT_TEXT) fprintf(stderr, "[警告] 无法使用缓存目录: %s\n", cache_dir);
+        else printf("  " YELLOW ICON_ARROW " [警告] 无法使用缓存目录: %s\n" RESET, cache_dir);
+    }
+
+    // 机器可读输出：全部记录经同一个缓冲写出器输出到标准输出
+    static ReportWriter writer;
+    ReportWriter* rep = NULL;
+    if (format != REPORT_TEXT) {
+        if (serve_input) report_init(&writer, stdout, format, SERVE_COLS, SERVE_NCOLS);
+        else if (index_add) report_init(&writer, stdout, format, INDEX_COLS, NCOLS(INDEX_COLS));
+        else if (query_file) report_init(&writer, stdout, format, QUERY_COLS, NCOLS(QUERY_COLS));
+        else if (batch_input) report_init(&writer, stdout, format, BATCH_COLS, NCOLS(BATCH_COLS));
+        else report_init(&writer, stdout, format, PAIR_COLS, NCOLS(PAIR_COLS));
+        rep = &writer;
+    }
 
-    return 0;
+    int rc = 0;
+    STATS_TIMER(t_total);
+    if (serve_input) {
+        const ServeOptions so = { { engine, min_sim, jobs, prefilter, NULL }, top_k, cache_ptr };
+        rc = run_serve(serve_input, &so, rep);
+    } else if (index_add) {
+        rc = run_index_add(index_path, index_add, jobs, cache_ptr, rep);
+    } else if (query_file) {
+        rc = run_query(index_path, query_file, top_k, engine, jobs, cache_ptr, rep);
+    } else if (batch_input) {
+        BatchOptions opt = { engine, min_sim, jobs, prefilter, costs };
+        rc = run_batch(batch_input, &opt, top_k, show_matrix, cache_ptr, rep);
+    } else if (rep) {
+        rc = report_pair(rep, files[0], files[1], engine, cache_ptr, by_function, jobs, costs);
+    } else {
+        compare_files(files[0], files[1], engine, cache_ptr, by_function, show_diff, jobs, costs);
+    }
+    STATS_STAGE_END(t_total, ST_STAGE_TOTAL);
+
+    if (rep && !report_flush(rep)) rc = 1;
+    if (show_stats) {
+        // 机器可读模式下标准输出只含结果记录
+        FILE* stats_out = rep ? stderr : stdout;
+        fprintf(stats_out, rep ? "运行统计:\n" : BOLD "运行统计:" RESET "\n");
+        stats_print(stats_out);
+    }
+    if (stats_json) stats_print_json(stderr);
+
+    seqcache_close(cache_ptr);
+    return rc;
 }
\ No newline at end of file
@@ -0,0 +1,230 @@
+/**
+* @file merkle.c
+ * @brief 子树结构哈希与函数摘要表的实现。
+ *
+ * 节点哈希：h = mix(类别种子)；AST_TOKEN 再混入标签哈希；之后依次混入每个子节点哈希。
+ * AST 与符号序列两条路径按同样的顺序组合，结果逐位一致。
+ */
+
+#include "../include/merkle.h"
+#include "../include/fingerprint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MK_CHILD_MUL 0x9e3779b97f4a7c15ull
+
+static uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+static uint64_t node_seed(ASTKind kind) {
+    return mix64(0x6a09e667f3bcc909ull + (uint64_t)kind);
+}
+
+static uint64_t add_label(uint64_t h, uint64_t label) {
+    return mix64(h ^ label);
+}
+
+static uint64_t add_child(uint64_t h, uint64_t child) {
+    return mix64(h * MK_CHILD_MUL + child);
+}
+
+uint64_t ast_merkle(ASTNode* node) {
+    if (!node) return 0;
+    uint64_t h = node_seed(node->kind);
+    if (node->kind == AST_TOKEN && node->text) h = add_label(h, fp_label_hash(node->text));
+    for (size_t i = 0; i < node->child_count; i ++) {
+        if (node->children[i]) h = add_child(h, ast_merkle(node->children[i]));
+    }
+    node->hash = h;
+    return h;
+}
+
+void functable_init(FuncTable* t) {
+    t->data = NULL;
+    t->size = 0;
+    t->cap = 0;
+}
+
+void functable_free(FuncTable* t) {
+    if (!t) return;
+    free(t->data);
+    functable_init(t);
+}
+
+static bool functable_push(FuncTable* t, uint64_t digest, size_t begin, size_t end) {
+    if (t->size == t->cap) {
+        size_t nc = t->cap ? t->cap * 2 : 16;
+        FuncDigest* p = (FuncDigest*)realloc(t->data, nc * sizeof(FuncDigest));
+        if (!p) return false;
+        t->data = p;
+        t->cap = nc;
+    }
+    t->data[t->size].digest = digest;
+    t->data[t->size].seq_begin = begin;
+    t->data[t->size].seq_end = end;
+    t->size++;
+    return true;
+}
+
+/**
+ * @brief 按序列化顺序推进下标 off（与 emit_node_sym 的输出长度一致），收集函数摘要。
+ */
+static bool collect(const ASTNode* n, size_t* off, FuncTable* out) {
+    const size_t begin = *off;
+    *off += 1;                                      // <KIND>
+    if (n->kind == AST_TOKEN && n->text) *off += 1; // 标签
+    for (size_t i = 0; i < n->child_count; i ++) {
+        if (n->children[i] && !collect(n->children[i], off, out)) return false;
+    }
+    *off += 1;                                      // </KIND>
+    return n->kind != AST_FUNCTION || functable_push(out, n->hash, begin, *off);
+}
+
+bool functable_from_ast(ASTNode* root, FuncTable* out) {
+    if (!root || !out) return false;
+    out->size = 0;
+    ast_merkle(root);
+    size_t off = 0;
+    return collect(root, &off, out);
+}
+
+typedef struct {
+    ASTKind  kind;
+    uint64_t h;
+    size_t   begin;
+} MerkleFrame;
+
+/**
+ * @brief 为每个符号 ID 标注：0 为普通标签，1..K 为 <KIND>，K+1..2K 为 </KIND>。
+ */
+static unsigned char* tag_table(const SymTab* syms) {
+    const size_t n = symtab_size(syms);
+    unsigned char* tag = (unsigned char*)calloc(n ? n : 1, 1);
+    if (!tag) return NULL;
+
+    char open[AST_KIND_COUNT][32], close[AST_KIND_COUNT][32];
+    for (int k = 0; k < AST_KIND_COUNT; ++ k) {
+        snprintf(open[k], sizeof(open[k]), "<%s>", ast_kind_name((ASTKind)k));
+        snprintf(close[k], sizeof(close[k]), "</%s>", ast_kind_name((ASTKind)k));
+    }
+    for (size_t i = 0; i < n; i++) {
+        const char* name = symtab_name(syms, (SymId)i);
+        if (name[0] != '<') continue;
+        for (int k = 0; k < AST_KIND_COUNT; ++ k) {
+            if (strcmp(name, open[k]) == 0) { tag[i] = (unsigned char)(1 + k); break; }
+            if (strcmp(name, close[k]) == 0) { tag[i] = (unsigned char)(1 + AST_KIND_COUNT + k); break; }
+        }
+    }
+    return tag;
+}
+
+bool functable_from_symbols(const SymTab* syms, const SymVec* seq, FuncTable* out) {
+    if (!syms || !seq || !out) return false;
+    out->size = 0;
+
+    unsigned char* tag = tag_table(syms);
+    uint64_t* label = fp_symbol_table(syms);
+    MerkleFrame* stack = NULL;
+    size_t depth = 0, cap = 0;
+    bool ok = tag && label;
+
+    for (size_t i = 0; ok && i < seq->size; i++) {
+        const SymId s = seq->data[i];
+        const int t = tag[s];
+        if (t == 0) {
+            // 叶子标签：只能出现在 <TOKEN> 内
+            ok = depth > 0 && stack[depth - 1].kind == AST_TOKEN;
+            if (ok) stack[depth - 1].h = add_label(stack[depth - 1].h, label[s]);
+        } else if (t <= AST_KIND_COUNT) {
+            if (depth == cap) {
+                size_t nc = cap ? cap * 2 : 64;
+                MerkleFrame* p = (MerkleFrame*)realloc(stack, nc * sizeof(MerkleFrame));
+                if (!p) { ok = false; break; }
+                stack = p;
+                cap = nc;
+            }
+            const ASTKind kind = (ASTKind)(t - 1);
+            stack[depth].kind = kind;
+            stack[depth].h = node_seed(kind);
+            stack[depth].begin = i;
+            depth++;
+        } else {
+            const ASTKind kind = (ASTKind)(t - 1 - AST_KIND_COUNT);
+            ok = depth > 0 && stack[depth - 1].kind == kind;
+            if (!ok) break;
+            const MerkleFrame f = stack[--depth];
+            if (kind == AST_FUNCTION) ok = functable_push(out, f.h, f.begin, i + 1);
+            if (depth > 0) stack[depth - 1].h = add_child(stack[depth - 1].h, f.h);
+        }
+    }
+    if (depth != 0) ok = false;
+
+    free(stack);
+    free(label);
+    free(tag);
+    if (!ok) out->size = 0;
+    return ok;
+}
+
+/**
+ * @brief 开放寻址表的一个槽：摘要 + 该摘要下尚未配对的 a 中函数链表头。
+ */
+typedef struct {
+    uint64_t digest;
+    size_t   head;      // a 中下标 + 1；0 表示链表已空
+    bool     used;
+} JoinSlot;
+
+bool functable_join(const FuncTable* a, const FuncTable* b, FuncPair* out, size_t* npairs) {
+    if (!a || !b || !npairs) return false;
+    *npairs = 0;
+    if (a->size == 0 || b->size == 0) return true;
+    if (!out) return false;
+
+    size_t cap = 16;
+    while (cap < a->size * 2) cap <<= 1;
+    const size_t mask = cap - 1;
+    JoinSlot* slots = (JoinSlot*)calloc(cap, sizeof(JoinSlot));
+    size_t* next = (size_t*)malloc(a->size * sizeof(size_t));
+    if (!slots || !next) {
+        free(slots);
+        free(next);
+        return false;
+    }
+
+    // 逆序头插，使每条链表按 a 中出现顺序排列
+    for (size_t i = a->size; i-- > 0;) {
+        const uint64_t d = a->data[i].digest;
+        size_t k = (size_t)d & mask;
+        while (slots[k].used && slots[k].digest != d) k = (k + 1) & mask;
+        slots[k].used = true;
+        slots[k].digest = d;
+        next[i] = slots[k].head;
+        slots[k].head = i + 1;
+    }
+
+    size_t n = 0;
+    for (size_t j = 0; j < b->size; j++) {
+        const uint64_t d = b->data[j].digest;
+        size_t k = (size_t)d & mask;
+        while (slots[k].used && slots[k].digest != d) k = (k + 1) & mask;
+        if (!slots[k].used || slots[k].head == 0) continue;
+        const size_t i = slots[k].head - 1;
+        slots[k].head = next[i];
+        out[n].a = i;
+        out[n].b = j;
+        n++;
+    }
+
+    free(slots);
+    free(next);
+    *npairs = n;
+    return true;
+}
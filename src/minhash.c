@@ -0,0 +1,254 @@
+/**
+* @file minhash.c
+ * @brief MinHash 签名与分带 LSH 索引的实现。
+ *
+ * 索引文件布局（本机字节序）：
+ *   magic "CDLH" | u32 格式版本 | u32 MH_NUM_HASHES | u32 MH_BANDS | u64 文档数 |
+ *   每个文档：u32 名称长度 + 名称字节 | 全部签名（文档数 × MH_NUM_HASHES × u64）
+ */
+
+#include "../include/minhash.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LSH_MAGIC  "CDLH"
+#define LSH_FORMAT 1u
+
+/**
+ * @brief SplitMix64：由下标生成第 i 个哈希函数的种子（固定序列，签名可跨进程比较）。
+ */
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief 对每个 shingle 计算 MH_NUM_HASHES 个独立哈希并逐分量取最小。
+ *
+ * 指纹本身已是均匀的 64 位哈希，第 i 个哈希函数只需“异或种子 + 乘法 + 移位混合”。
+ */
+void minhash_sig(const FpVec* set, MinHashSig* out) {
+    uint64_t seeds[MH_NUM_HASHES];
+    for (int i = 0; i < MH_NUM_HASHES; i++) {
+        seeds[i] = splitmix64((uint64_t)i);
+        out->v[i] = UINT64_MAX;
+    }
+    for (size_t k = 0; set && k < set->size; k++) {
+        const uint64_t x = set->data[k];
+        for (int i = 0; i < MH_NUM_HASHES; i++) {
+            uint64_t h = (x ^ seeds[i]) * 0x9e3779b97f4a7c15ull;
+            h ^= h >> 32;
+            if (h < out->v[i]) out->v[i] = h;
+        }
+    }
+}
+
+double minhash_similarity(const MinHashSig* a, const MinHashSig* b) {
+    int eq = 0;
+    for (int i = 0; i < MH_NUM_HASHES; i++) eq += a->v[i] == b->v[i];
+    return (double)eq / MH_NUM_HASHES;
+}
+
+/**
+ * @brief 第 band 段的组合键（段号参与混合，不同段的键互不干扰）。
+ */
+static uint64_t band_key(const MinHashSig* s, int band) {
+    uint64_t k = splitmix64(0xb5ad4eceda1ce2a9ull + (uint64_t)band);
+    for (int r = 0; r < MH_ROWS; r++) k = splitmix64(k ^ s->v[band * MH_ROWS + r]);
+    return k;
+}
+
+void lsh_init(LshIndex* idx) {
+    symtab_init(&idx->names);
+    idx->sigs = NULL;
+    idx->count = 0;
+    idx->cap = 0;
+    idx->bands = NULL;
+    idx->built = false;
+}
+
+void lsh_free(LshIndex* idx) {
+    if (!idx) return;
+    symtab_free(&idx->names);
+    free(idx->sigs);
+    free(idx->bands);
+    lsh_init(idx);
+}
+
+/**
+ * @brief 添加（或覆盖同名的）文档签名；之后需 lsh_build。
+ */
+bool lsh_add(LshIndex* idx, const char* name, const MinHashSig* sig) {
+    if (!idx || !name || !sig) return false;
+    SymId id;
+    if (!symtab_intern(&idx->names, name, &id)) return false;
+
+    if (id == idx->count) {
+        if (idx->count == idx->cap) {
+            size_t nc = idx->cap ? idx->cap * 2 : 64;
+            MinHashSig* p = (MinHashSig*)realloc(idx->sigs, nc * sizeof(MinHashSig));
+            if (!p) return false;
+            idx->sigs = p;
+            idx->cap = nc;
+        }
+        idx->count++;
+    }
+    idx->sigs[id] = *sig;
+    idx->built = false;
+    return true;
+}
+
+static int cmp_entry(const void* x, const void* y) {
+    const LshEntry* p = (const LshEntry*)x;
+    const LshEntry* q = (const LshEntry*)y;
+    if (p->key != q->key) return p->key < q->key ? -1 : 1;
+    return (p->doc > q->doc) - (p->doc < q->doc);
+}
+
+/**
+ * @brief 重建 MH_BANDS 张段表：每张 count 项，按键排序以便二分查找。
+ */
+bool lsh_build(LshIndex* idx) {
+    if (!idx) return false;
+    const size_t n = idx->count;
+    LshEntry* t = (LshEntry*)malloc((n ? n : 1) * MH_BANDS * sizeof(LshEntry));
+    if (!t) return false;
+
+    for (int b = 0; b < MH_BANDS; b++) {
+        LshEntry* band = t + (size_t)b * n;
+        for (size_t d = 0; d < n; d++) {
+            band[d].key = band_key(&idx->sigs[d], b);
+            band[d].doc = (uint32_t)d;
+        }
+        qsort(band, n, sizeof(LshEntry), cmp_entry);
+    }
+    free(idx->bands);
+    idx->bands = t;
+    idx->built = true;
+    return true;
+}
+
+const char* lsh_doc_name(const LshIndex* idx, size_t doc) {
+    return symtab_name(&idx->names, (SymId)doc);
+}
+
+static int cmp_hit(const void* x, const void* y) {
+    const LshHit* p = (const LshHit*)x;
+    const LshHit* q = (const LshHit*)y;
+    if (p->estimate != q->estimate) return p->estimate > q->estimate ? -1 : 1;
+    return (p->doc > q->doc) - (p->doc < q->doc);
+}
+
+/**
+ * @brief 逐段二分查找“撞段”的文档，去重后按完整签名估计相似度排序。
+ *
+ * 代价只与段数和撞段文档数有关，与索引规模成对数关系。
+ */
+size_t lsh_query(const LshIndex* idx, const MinHashSig* sig, size_t top_k, LshHit* out) {
+    if (!idx || !idx->built || !sig || !out || top_k == 0 || idx->count == 0) return 0;
+    const size_t n = idx->count;
+
+    unsigned char* seen = (unsigned char*)calloc((n + 7) / 8, 1);
+    if (!seen) return 0;
+    LshHit* hits = NULL;
+    size_t nh = 0, cap = 0;
+    bool ok = true;
+
+    for (int b = 0; b < MH_BANDS && ok; b++) {
+        const LshEntry* band = idx->bands + (size_t)b * n;
+        const uint64_t key = band_key(sig, b);
+
+        // 第一个 key >= 目标的位置
+        size_t lo = 0, hi = n;
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (band[mid].key < key) lo = mid + 1;
+            else hi = mid;
+        }
+        for (size_t i = lo; i < n && band[i].key == key; i++) {
+            const uint32_t d = band[i].doc;
+            if (seen[d >> 3] & (1u << (d & 7))) continue;
+            seen[d >> 3] |= (unsigned char)(1u << (d & 7));
+            if (nh == cap) {
+                size_t nc = cap ? cap * 2 : 64;
+                LshHit* p = (LshHit*)realloc(hits, nc * sizeof(LshHit));
+                if (!p) { ok = false; break; }
+                hits = p;
+                cap = nc;
+            }
+            hits[nh].doc = d;
+            hits[nh].estimate = minhash_similarity(sig, &idx->sigs[d]);
+            nh++;
+        }
+    }
+
+    size_t k = 0;
+    if (ok) {
+        qsort(hits, nh, sizeof(LshHit), cmp_hit);
+        k = nh < top_k ? nh : top_k;
+        if (k) memcpy(out, hits, k * sizeof(LshHit));
+    }
+    free(hits);
+    free(seen);
+    return k;
+}
+
+bool lsh_save(const LshIndex* idx, const char* path) {
+    if (!idx || !path) return false;
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+
+    const uint32_t format = LSH_FORMAT, nh = MH_NUM_HASHES, nb = MH_BANDS;
+    const uint64_t count = idx->count;
+    bool ok = fwrite(LSH_MAGIC, 1, 4, fp) == 4
+           && fwrite(&format, 4, 1, fp) == 1
+           && fwrite(&nh, 4, 1, fp) == 1
+           && fwrite(&nb, 4, 1, fp) == 1
+           && fwrite(&count, 8, 1, fp) == 1;
+    for (size_t d = 0; ok && d < idx->count; d++) {
+        const char* name = lsh_doc_name(idx, d);
+        const uint32_t len = (uint32_t)strlen(name);
+        ok = fwrite(&len, 4, 1, fp) == 1 && fwrite(name, 1, len, fp) == len;
+    }
+    if (ok && idx->count) ok = fwrite(idx->sigs, sizeof(MinHashSig), idx->count, fp) == idx->count;
+    if (fclose(fp) != 0) ok = false;
+    if (!ok) remove(path);
+    return ok;
+}
+
+bool lsh_load(LshIndex* idx, const char* path) {
+    if (!idx || !path) return false;
+    lsh_free(idx);
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return false;
+
+    char magic[4];
+    uint32_t format = 0, nh = 0, nb = 0;
+    uint64_t count = 0;
+    bool ok = fread(magic, 1, 4, fp) == 4 && memcmp(magic, LSH_MAGIC, 4) == 0
+           && fread(&format, 4, 1, fp) == 1 && format == LSH_FORMAT
+           && fread(&nh, 4, 1, fp) == 1 && nh == MH_NUM_HASHES
+           && fread(&nb, 4, 1, fp) == 1 && nb == MH_BANDS
+           && fread(&count, 8, 1, fp) == 1 && count < UINT32_MAX;
+
+    char buf[4096];
+    for (uint64_t d = 0; ok && d < count; d++) {
+        uint32_t len = 0;
+        SymId id;
+        ok = fread(&len, 4, 1, fp) == 1 && len < sizeof(buf) && fread(buf, 1, len, fp) == len
+          && symtab_intern_n(&idx->names, buf, len, &id) && id == d;   // 名称必须互不相同
+    }
+    if (ok && count) {
+        idx->sigs = (MinHashSig*)malloc((size_t)count * sizeof(MinHashSig));
+        ok = idx->sigs && fread(idx->sigs, sizeof(MinHashSig), (size_t)count, fp) == count;
+        idx->count = idx->cap = ok ? (size_t)count : 0;
+    }
+    fclose(fp);
+
+    if (ok) ok = lsh_build(idx);
+    if (!ok) lsh_free(idx);
+    return ok;
+}
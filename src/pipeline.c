@@ -0,0 +1,556 @@
+/**
+* @file pipeline.c
+ * @brief 前端流水线：tokenizer -> ast_parse_stream -> 符号序列化（流式）。
+ */
+
+#include "../include/pipeline.h"
+#include "../include/tokenizer.h"
+#include "../include/ast_parser.h"
+#include "../include/ast_serial.h"
+#include "../include/stats.h"
+#include "../include/threadpool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** @brief 前端的标识符归一化方式（进程级设置，启动时确定）。 */
+static IdentMode ident_mode = TK_IDENT_SEQUENTIAL;
+
+void pipeline_set_ident_mode(IdentMode mode) {
+    ident_mode = mode;
+}
+
+IdentMode pipeline_ident_mode(void) {
+    return ident_mode;
+}
+
+/**
+ * @brief 缓存键：源码内容哈希，非默认归一化方式再混入模式，使两种模式的缓存互不命中。
+ */
+static void content_key(const char* source, size_t len, SeqKey* key) {
+    seqcache_key(source, len, key);
+    if (ident_mode != TK_IDENT_SEQUENTIAL) key->h[1] ^= 0x9e3779b97f4a7c15ull * (uint64_t)ident_mode;
+}
+
+/**
+ * @brief 将源代码转换为 Token 数组（容量不足则倍增）。
+ *
+ * 扩容失败时释放已分配的全部 Token，不会泄露。
+ */
+Token** tokenize_code(const char* source, size_t* token_count) {
+    Tokenizer tk;
+    tokenizer_init(&tk, source);
+
+    size_t capacity = 1024;
+    size_t count = 0;
+    Token** tokens = (Token**)malloc(capacity * sizeof(Token*));
+
+    if (!tokens) return NULL;
+
+    while (!tokenizer_is_eof(&tk)) {
+        Token* tok = tokenizer_next_token(&tk);
+
+        // 处理 tokenizer 返回 NULL 或 EOF 的情况
+        if (!tok || tok->type == TOKEN_EOF) {
+            if (tok) token_free(tok);
+            break;
+        }
+
+        // 扩容检查
+        if (count >= capacity) {
+            size_t new_capacity = capacity * 2;
+            Token** new_tokens = (Token**)realloc(tokens, new_capacity * sizeof(Token*));
+
+            if (!new_tokens) {
+                tokens_free(tokens, count);
+                return NULL;
+            }
+            tokens = new_tokens;
+            capacity = new_capacity;
+        }
+
+        tokens[count++] = tok;
+    }
+
+    *token_count = count;
+    return tokens;
+}
+
+/**
+ * @brief 释放 Token 数组及其元素。
+ *
+ * @param tokens 数组；可为 NULL。
+ * @param count  元素个数。
+ */
+void tokens_free(Token** tokens, size_t count) {
+    if (!tokens) return;
+    for (size_t i = 0; i < count; i++) token_free(tokens[i]);
+    free(tokens);
+}
+
+/**
+ * @brief 以二进制方式整体读入文件。
+ */
+char* pipeline_read_file(const char* path, size_t* out_len) {
+    FILE* fp = fopen(path, "rb");
+    if (!fp) return NULL;
+
+    if (fseek(fp, 0, SEEK_END) != 0) { fclose(fp); return NULL; }
+    long size = ftell(fp);
+    if (size < 0) { fclose(fp); return NULL; }
+    fseek(fp, 0, SEEK_SET);
+
+    char* content = (char*)malloc((size_t)size + 1);
+    if (!content) { fclose(fp); return NULL; }
+
+    size_t read_size = fread(content, 1, (size_t)size, fp);
+    content[read_size] = '\0';
+    fclose(fp);
+
+    if (out_len) *out_len = read_size;
+    return content;
+}
+
+/**
+ * @brief 流式前端的拉取上下文：tokenizer 与已拉取的有效 token 数。
+ */
+typedef struct {
+    Tokenizer tk;
+    SymTab*   lexes;
+    size_t    count;
+} StreamSource;
+
+static bool stream_pull(void* ctx, TokenRef* out) {
+    StreamSource* src = (StreamSource*)ctx;
+    if (!tokenizer_next_ref(&src->tk, src->lexes, out)) return false;
+    if (out->type != TOKEN_EOF) src->count++;
+    return true;
+}
+
+static bool stream_emit(void* ctx, ASTNode* node) {
+    return sym_emit_node((SymEmitter*)ctx, node);
+}
+
+/**
+ * @brief 执行完整前端并输出符号序列（流式：tokenize -> parse -> serialize 逐个顶层节点进行）。
+ *
+ * 不物化 token 数组与整棵 AST：token 只保留解析器的前瞻窗口，
+ * 每个顶层函数/语句序列化后其子树所在区域立即重置。
+ */
+bool pipeline_build_symbols(const char* source, size_t len, SymTab* syms, SymVec* out,
+                            size_t* ntokens) {
+    return pipeline_build_located(source, len, syms, out, NULL, ntokens);
+}
+
+/**
+ * @brief 同 pipeline_build_symbols，并可同步输出每个符号的源码行号（lines 为 NULL 时不记录）。
+ */
+bool pipeline_build_located(const char* source, size_t len, SymTab* syms, SymVec* out,
+                            LineVec* lines, size_t* ntokens) {
+    if (ntokens) *ntokens = 0;
+    if (!source || !syms || !out) return false;
+
+    StreamSource src;
+    tokenizer_init_n(&src.tk, source, len);
+    tokenizer_set_ident_mode(&src.tk, ident_mode);
+    src.lexes = syms;   // lex 直接驻留到序列化符号表中，两者共用一份字符串池
+    src.count = 0;
+
+    SymEmitter em;
+    const size_t start = out->size;
+    const size_t line_start = lines ? lines->size : 0;
+    if (!sym_emitter_init(&em, syms, out)) return false;
+    em.lines = lines;
+    if (!sym_emit_open(&em, AST_PROGRAM)) return false;
+
+    Arena arena;
+    arena_init(&arena, 0);
+    bool ok = ast_parse_stream(stream_pull, &src, syms, &arena, stream_emit, &em);
+    arena_free(&arena);
+
+    if (ntokens) *ntokens = src.count;
+    if (ok && src.count == 0) ok = false;    // 空文件：与旧流程一致，视为失败
+    if (ok) ok = sym_emit_close(&em, AST_PROGRAM);
+    STATS_ADD(ST_SOURCE_BYTES, len);
+    STATS_ADD(ST_TOKENS, src.count);
+    if (ok) STATS_ADD(ST_SYMBOLS, out->size - start);
+    if (!ok) {
+        out->size = start;
+        if (lines) lines->size = line_start;
+    }
+    return ok;
+}
+
+/**
+ * @brief 按顶层区域切分源码：在括号深度回到 0 的 '}' 且该行随即结束处切开。
+ *
+ * 注释、字符串与字符常量的跳过规则与 tokenizer 一致，其中的括号不计深度；
+ * 与 tokenizer 相同，在第一个 '\0' 处截断。
+ */
+size_t* pipeline_split_regions(const char* source, size_t len, size_t* nregions) {
+    if (!nregions) return NULL;
+    *nregions = 0;
+    if (!source) return NULL;
+    const char* nul = (const char*)memchr(source, '\0', len);
+    const size_t n = nul ? (size_t)(nul - source) : len;
+
+    size_t cap = 64, count = 0;
+    size_t* ends = (size_t*)malloc(cap * sizeof(size_t));
+    if (!ends) return NULL;
+
+    size_t depth = 0, i = 0;
+    while (i < n) {
+        const char c = source[i];
+        size_t cut = 0;
+        if (c == '/' && i + 1 < n && source[i + 1] == '/') {
+            while (i < n && source[i] != '\n') i++;
+        } else if (c == '/' && i + 1 < n && source[i + 1] == '*') {
+            i += 2;
+            while (i + 1 < n && !(source[i] == '*' && source[i + 1] == '/')) i++;
+            i = i + 1 < n ? i + 2 : n;
+        } else if (c == '"') {
+            for (i++; i < n && source[i] != '"'; i++) {
+                if (source[i] == '\\' && i + 1 < n) i++;
+            }
+            if (i < n) i++;
+        } else if (c == '\'') {
+            i++;
+            if (i < n && source[i] == '\\') i++;
+            if (i < n) i++;
+            if (i < n && source[i] == '\'') i++;
+        } else if (c == '{') {
+            depth++;
+            i++;
+        } else if (c == '}') {
+            if (depth > 0) depth--;
+            i++;
+            if (depth == 0) {
+                size_t j = i;
+                while (j < n && (source[j] == ' ' || source[j] == '\t' || source[j] == '\r')) j++;
+                if (j < n && source[j] == '\n') cut = j + 1;
+            }
+        } else {
+            i++;
+        }
+
+        if (cut) {
+            if (count == cap) {
+                size_t* p = (size_t*)realloc(ends, cap * 2 * sizeof(size_t));
+                if (!p) { free(ends); return NULL; }
+                ends = p;
+                cap *= 2;
+            }
+            ends[count++] = cut;
+            i = cut;
+        }
+    }
+    if (n > 0 && (count == 0 || ends[count - 1] < n)) {
+        if (count == cap) {
+            size_t* p = (size_t*)realloc(ends, (cap + 1) * sizeof(size_t));
+            if (!p) { free(ends); return NULL; }
+            ends = p;
+        }
+        ends[count++] = n;
+    }
+    *nregions = count;
+    return ends;
+}
+
+/**
+ * @brief 区域内局部编号的标识符 var_<k>：返回 true 并写出 k。
+ */
+static bool parse_var(const char* s, uint64_t* k) {
+    if (strncmp(s, "var_", 4) != 0 || s[4] == '\0') return false;
+    uint64_t v = 0;
+    for (s += 4; *s; ++ s) {
+        if (*s < '0' || *s > '9') return false;
+        v = v * 10 + (uint64_t)(*s - '0');
+    }
+    *k = v;
+    return true;
+}
+
+/**
+ * @brief 单独解析一个区域，顶层节点序列化到 frag（使用区域自己的符号表，标识符从 var_0 编号）。
+ *
+ * @param aux 输出：(区域内标识符个数 << 1) | (区域内是否有 token)。
+ */
+static bool build_region(const char* source, size_t len, SymTab* local, SymVec* frag, Arena* arena,
+                         uint64_t* aux, size_t* ntokens) {
+    StreamSource src;
+    tokenizer_init_n(&src.tk, source, len);
+    tokenizer_set_ident_mode(&src.tk, ident_mode);
+    src.lexes = local;
+    src.count = 0;
+
+    SymEmitter em;
+    if (!sym_emitter_init(&em, local, frag)) return false;
+    bool ok = ast_parse_stream(stream_pull, &src, local, arena, stream_emit, &em);
+    arena_reset(arena);
+
+    *ntokens += src.count;
+    *aux = ((uint64_t)src.tk.ident_counter << 1) | (src.count > 0 ? 1u : 0u);
+    STATS_ADD(ST_SOURCE_BYTES, len);
+    STATS_ADD(ST_TOKENS, src.count);
+    return ok;
+}
+
+/**
+ * @brief 把区域片段追加到 out：局部符号按需驻留到 syms，var_<k> 平移为 var_<k + base>。
+ */
+static bool splice_region(const SymTab* local, const SymVec* frag, uint64_t base,
+                          SymTab* syms, SymVec* out) {
+    const size_t n = symtab_size(local);
+    SymId* map = (SymId*)malloc((n ? n : 1) * sizeof(SymId));
+    if (!map) return false;
+    for (size_t i = 0; i < n; i++) map[i] = SYM_NONE;
+
+    bool ok = symv_reserve(out, out->size + frag->size);
+    for (size_t i = 0; ok && i < frag->size; i++) {
+        const SymId id = frag->data[i];
+        if (map[id] == SYM_NONE) {
+            const char* name = symtab_name(local, id);
+            uint64_t k;
+            if (base != 0 && parse_var(name, &k)) {
+                char buf[32];
+                snprintf(buf, sizeof(buf), "var_%llu", (unsigned long long)(k + base));
+                ok = symtab_intern(syms, buf, &map[id]);
+            } else {
+                ok = symtab_intern(syms, name, &map[id]);
+            }
+            if (!ok) break;
+        }
+        out->data[out->size++] = map[id];
+    }
+    free(map);
+    return ok;
+}
+
+/**
+ * @brief 片段分组：相邻区域合并为一个缓存片段，在区域内容哈希满足掩码且不小于
+ *        REGION_CHUNK_MIN 字节处切开（内容定义分块，修改某个函数只影响其所在片段，
+ *        之后的分组边界不随之移动）；单个片段不超过 REGION_CHUNK_MAX 字节。
+ *
+ * 每个函数单独成文件时，打开缓存文件的代价已超过重新解析该函数。
+ */
+#define REGION_CHUNK_MIN  4096
+#define REGION_CHUNK_MAX  65536
+#define REGION_CHUNK_MASK 7u
+
+/**
+ * @brief 增量前端：逐个片段查缓存，只对源码变化过的片段重新做词法与语法分析。
+ *
+ * 标识符编号是全文件递增的，片段以片段内局部编号缓存，拼接时按前面片段的
+ * 标识符总数平移，因此结果与 pipeline_build_symbols 逐符号一致。
+ * 任一片段解析失败时退回整文件前端。
+ * 作用域模式（TK_IDENT_SCOPED）下函数名与文件作用域名的编号依赖前面全部区域，片段不能单独分析，
+ * 直接走整文件前端（整文件缓存仍然有效）。
+ */
+bool pipeline_build_incremental(SeqCache* cache, const char* source, size_t len,
+                                SymTab* syms, SymVec* out, size_t* ntokens) {
+    size_t tokens = 0;
+    if (ntokens) *ntokens = 0;
+    if (!source || !syms || !out) return false;
+    if (ident_mode == TK_IDENT_SCOPED) return pipeline_build_symbols(source, len, syms, out, ntokens);
+
+    size_t nreg = 0;
+    size_t* ends = pipeline_split_regions(source, len, &nreg);
+    if (!ends) return pipeline_build_symbols(source, len, syms, out, ntokens);
+
+    SymEmitter em;
+    const size_t start = out->size;
+    bool ok = sym_emitter_init(&em, syms, out) && sym_emit_open(&em, AST_PROGRAM);
+
+    SymTab local;
+    SymVec frag;
+    Arena arena;
+    symtab_init(&local);
+    symv_init(&frag);
+    arena_init(&arena, 0);
+
+    uint64_t base = 0;
+    bool any_tokens = false, failed = false;
+    for (size_t r = 0, b = 0; ok && r < nreg; b = ends[r++]) {
+        // 向后合并区域，直到满足分块条件
+        SeqKey key;
+        for (; r + 1 < nreg && ends[r] - b < REGION_CHUNK_MAX; r++) {
+            const size_t rb = r > 0 ? ends[r - 1] : 0;
+            seqcache_key(source + rb, ends[r] - rb, &key);
+            if (ends[r] - b >= REGION_CHUNK_MIN && (key.h[0] & REGION_CHUNK_MASK) == 0) break;
+        }
+
+        uint64_t aux = 0;
+        symtab_free(&local);
+        frag.size = 0;
+        content_key(source + b, ends[r] - b, &key);
+
+        if (!seqcache_load_fragment(cache, &key, &local, &frag, &aux)) {
+            symtab_free(&local);
+            frag.size = 0;
+            if (!build_region(source + b, ends[r] - b, &local, &frag, &arena, &aux, &tokens)) {
+                failed = true;
+                break;
+            }
+            seqcache_store_fragment(cache, &key, &local, &frag, aux);
+        }
+        any_tokens = any_tokens || (aux & 1u);
+        ok = splice_region(&local, &frag, base, syms, out);
+        base += aux >> 1;
+    }
+
+    symtab_free(&local);
+    symv_free(&frag);
+    arena_free(&arena);
+    free(ends);
+
+    if (failed) {
+        out->size = start;
+        return pipeline_build_symbols(source, len, syms, out, ntokens);
+    }
+    if (ntokens) *ntokens = tokens;
+    if (ok && !any_tokens) ok = false;      // 空文件：与 pipeline_build_symbols 一致
+    if (ok) ok = sym_emit_close(&em, AST_PROGRAM);
+    if (ok) STATS_ADD(ST_SYMBOLS, out->size - start);
+    if (!ok) out->size = start;
+    return ok;
+}
+
+/**
+ * @brief 并行前端的一个分块：若干相邻顶层区域，使用分块自己的符号表（标识符从 var_0 编号）。
+ */
+typedef struct {
+    size_t   begin, len;
+    SymTab   local;
+    SymVec   frag;
+    uint64_t aux;       // 同 build_region
+    size_t   tokens;
+    bool     ok;
+} SplitChunk;
+
+typedef struct {
+    const char* source;
+    SplitChunk* chunks;
+    Arena*      arenas;     // 每个工作线程一个
+} SplitJob;
+
+static void split_task(void* ctx, size_t index, int worker) {
+    SplitJob* job = (SplitJob*)ctx;
+    SplitChunk* ch = &job->chunks[index];
+    ch->ok = build_region(job->source + ch->begin, ch->len, &ch->local, &ch->frag,
+                          &job->arenas[worker], &ch->aux, &ch->tokens);
+}
+
+/**
+ * @brief 单文件并行前端：在安全的顶层边界切块，各块在线程池中独立做词法、语法分析与序列化，
+ *        再按块顺序拼接到同一个 AST_PROGRAM 之下。
+ *
+ * 切分点与增量前端相同（pipeline_split_regions：括号深度为 0、行末的 '}'，注释与字符串内除外）。
+ * 每块的标识符编号从 var_0 开始，拼接时按前面各块的标识符总数平移，
+ * 因此结果与 pipeline_build_symbols 逐符号一致，与线程数无关。
+ * 源码较小、只有一个区域、jobs 为 1 或处于作用域模式（原因同 pipeline_build_incremental）时
+ * 直接走串行前端；任一块失败时也退回串行前端。
+ *
+ * @param jobs 线程数；<= 0 为 CPU 核数。
+ */
+bool pipeline_build_parallel(const char* source, size_t len, SymTab* syms, SymVec* out,
+                             size_t* ntokens, int jobs) {
+    if (ntokens) *ntokens = 0;
+    if (!source || !syms || !out) return false;
+    const int threads = jobs > 0 ? jobs : tp_cpu_count();
+    if (threads <= 1 || len < PIPELINE_SPLIT_MIN || ident_mode == TK_IDENT_SCOPED) return pipeline_build_symbols(source, len, syms, out, ntokens);
+
+    size_t nreg = 0;
+    size_t* ends = pipeline_split_regions(source, len, &nreg);
+    if (!ends || nreg < 2) {
+        free(ends);
+        return pipeline_build_symbols(source, len, syms, out, ntokens);
+    }
+
+    // 区域合并成约 threads × 4 块（便于工作窃取均衡），每块不小于 PIPELINE_SPLIT_CHUNK 字节
+    size_t target = ends[nreg - 1] / ((size_t)threads * 4);
+    if (target < PIPELINE_SPLIT_CHUNK) target = PIPELINE_SPLIT_CHUNK;
+    SplitChunk* chunks = (SplitChunk*)calloc(nreg, sizeof(SplitChunk));
+    if (!chunks) {
+        free(ends);
+        return pipeline_build_symbols(source, len, syms, out, ntokens);
+    }
+    size_t nchunks = 0;
+    for (size_t r = 0, b = 0; r < nreg; r++) {
+        if (ends[r] - b < target && r + 1 < nreg) continue;
+        chunks[nchunks].begin = b;
+        chunks[nchunks].len = ends[r] - b;
+        symtab_init(&chunks[nchunks].local);
+        symv_init(&chunks[nchunks].frag);
+        nchunks++;
+        b = ends[r];
+    }
+    free(ends);
+
+    ThreadPool* pool = tp_create(threads < (int)nchunks ? threads : (int)nchunks);
+    const int nworkers = pool ? tp_size(pool) : 1;
+    Arena* arenas = (Arena*)malloc((size_t)nworkers * sizeof(Arena));
+    bool ok = arenas != NULL;
+    if (ok) {
+        for (int w = 0; w < nworkers; w++) arena_init(&arenas[w], 0);
+        SplitJob job = { source, chunks, arenas };
+        tp_parallel_for(pool, nchunks, split_task, &job);
+        for (int w = 0; w < nworkers; w++) arena_free(&arenas[w]);
+    }
+    free(arenas);
+    tp_destroy(pool);
+    for (size_t i = 0; ok && i < nchunks; i++) ok = chunks[i].ok;
+
+    // 按块顺序拼接（块内符号按需驻留到 syms，标识符编号平移）
+    const size_t start = out->size;
+    size_t tokens = 0;
+    bool any_tokens = false;
+    SymEmitter em;
+    if (ok) ok = sym_emitter_init(&em, syms, out) && sym_emit_open(&em, AST_PROGRAM);
+    uint64_t base = 0;
+    for (size_t i = 0; i < nchunks; i++) {
+        SplitChunk* ch = &chunks[i];
+        if (ok) {
+            ok = splice_region(&ch->local, &ch->frag, base, syms, out);
+            base += ch->aux >> 1;
+            any_tokens = any_tokens || (ch->aux & 1u);
+            tokens += ch->tokens;
+        }
+        symtab_free(&ch->local);
+        symv_free(&ch->frag);
+    }
+    free(chunks);
+
+    if (ok && any_tokens) ok = sym_emit_close(&em, AST_PROGRAM);
+    else ok = false;
+    if (!ok) {
+        out->size = start;
+        return pipeline_build_symbols(source, len, syms, out, ntokens);
+    }
+    if (ntokens) *ntokens = tokens;
+    STATS_ADD(ST_SYMBOLS, out->size - start);
+    return true;
+}
+
+/**
+ * @brief 先查磁盘缓存，未命中再执行（增量）前端并写回（写回失败不影响本次结果）。
+ */
+bool pipeline_load_symbols(SeqCache* cache, const char* source, size_t len,
+                           SymTab* syms, SymVec* out, size_t* ntokens, bool* from_cache) {
+    if (from_cache) *from_cache = false;
+    if (!cache) return pipeline_build_symbols(source, len, syms, out, ntokens);
+
+    SeqKey key;
+    content_key(source, len, &key);
+    if (seqcache_load(cache, &key, syms, out)) {
+        if (ntokens) *ntokens = 0;
+        if (from_cache) *from_cache = true;
+        return true;
+    }
+
+    const size_t start = out->size;
+    if (!pipeline_build_incremental(cache, source, len, syms, out, ntokens)) return false;
+
+    SymVec fresh = { out->data + start, out->size - start, out->size - start };
+    seqcache_store(cache, &key, syms, &fresh);
+    return true;
+}
@@ -0,0 +1,156 @@
+/**
+* @file report.c
+ * @brief 机器可读结果输出的实现。
+ */
+
+#include "../include/report.h"
+#include <string.h>
+
+bool report_parse_format(const char* name, ReportFormat* out) {
+    if (!name || !out) return false;
+    if (strcmp(name, "json") == 0) *out = REPORT_JSON;
+    else if (strcmp(name, "csv") == 0) *out = REPORT_CSV;
+    else if (strcmp(name, "tsv") == 0) *out = REPORT_TSV;
+    else if (strcmp(name, "text") == 0) *out = REPORT_TEXT;
+    else return false;
+    return true;
+}
+
+/**
+ * @brief 追加 n 个字节；缓冲放不下时先写出。
+ */
+static void put(ReportWriter* w, const char* s, size_t n) {
+    if (w->len + n > REPORT_BUF_SIZE) {
+        report_flush(w);
+        if (n > REPORT_BUF_SIZE) {
+            if (fwrite(s, 1, n, w->out) != n) w->failed = true;
+            return;
+        }
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void put_char(ReportWriter* w, char c) {
+    if (w->len == REPORT_BUF_SIZE) report_flush(w);
+    w->buf[w->len++] = c;
+}
+
+static void put_json_string(ReportWriter* w, const char* s) {
+    static const char HEX[] = "0123456789abcdef";
+    put_char(w, '"');
+    for (const unsigned char* p = (const unsigned char*)s; *p; p++) {
+        const unsigned char c = *p;
+        if (c == '"' || c == '\\') { put_char(w, '\\'); put_char(w, (char)c); }
+        else if (c == '\n') put(w, "\\n", 2);
+        else if (c == '\t') put(w, "\\t", 2);
+        else if (c == '\r') put(w, "\\r", 2);
+        else if (c < 0x20) {
+            const char esc[6] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 15] };
+            put(w, esc, sizeof(esc));
+        }
+        else put_char(w, (char)c);
+    }
+    put_char(w, '"');
+}
+
+static void put_csv_string(ReportWriter* w, const char* s) {
+    if (!strpbrk(s, ",\"\r\n")) { put(w, s, strlen(s)); return; }
+    put_char(w, '"');
+    for (const char* p = s; *p; p++) {
+        if (*p == '"') put_char(w, '"');
+        put_char(w, *p);
+    }
+    put_char(w, '"');
+}
+
+static void put_tsv_string(ReportWriter* w, const char* s) {
+    for (const char* p = s; *p; p++) {
+        put_char(w, (*p == '\t' || *p == '\n' || *p == '\r') ? ' ' : *p);
+    }
+}
+
+/**
+ * @brief 写字段前的分隔符与（json 的）键名。
+ */
+static void begin_field(ReportWriter* w) {
+    const char* name = w->col < w->ncols ? w->cols[w->col] : "";
+    if (w->fmt == REPORT_JSON) {
+        put_char(w, w->col == 0 ? '{' : ',');
+        put_json_string(w, name);
+        put_char(w, ':');
+    } else if (w->col > 0) {
+        put_char(w, w->fmt == REPORT_CSV ? ',' : '\t');
+    }
+    w->col++;
+}
+
+/**
+ * @brief 已格式化好的字段值（数字、null 等无需转义的文本）。
+ */
+static void raw_field(ReportWriter* w, const char* v, size_t n) {
+    begin_field(w);
+    put(w, v, n);
+}
+
+void report_init(ReportWriter* w, FILE* out, ReportFormat fmt, const char* const* cols, size_t ncols) {
+    w->out = out;
+    w->fmt = fmt;
+    w->cols = cols;
+    w->ncols = ncols;
+    w->col = 0;
+    w->rows = 0;
+    w->len = 0;
+    w->failed = false;
+    if (fmt == REPORT_CSV || fmt == REPORT_TSV) {
+        for (size_t i = 0; i < ncols; i++) report_str(w, cols[i]);
+        report_end_row(w);
+        w->rows = 0;
+    }
+}
+
+void report_str(ReportWriter* w, const char* v) {
+    if (!v) { report_null(w); return; }
+    begin_field(w);
+    if (w->fmt == REPORT_JSON) put_json_string(w, v);
+    else if (w->fmt == REPORT_CSV) put_csv_string(w, v);
+    else put_tsv_string(w, v);
+}
+
+void report_uint(ReportWriter* w, uint64_t v) {
+    char tmp[24];
+    size_t n = 0;
+    do { tmp[sizeof(tmp) - 1 - n++] = (char)('0' + v % 10); v /= 10; } while (v);
+    raw_field(w, tmp + sizeof(tmp) - n, n);
+}
+
+void report_real(ReportWriter* w, double v) {
+    char tmp[64];
+    const int n = snprintf(tmp, sizeof(tmp), "%.6f", v);
+    raw_field(w, tmp, n > 0 ? (size_t)n : 0);
+}
+
+void report_null(ReportWriter* w) {
+    if (w->fmt == REPORT_JSON) raw_field(w, "null", 4);
+    else raw_field(w, "", 0);
+}
+
+void report_end_row(ReportWriter* w) {
+    while (w->col < w->ncols) report_null(w);
+    if (w->fmt == REPORT_JSON) {
+        if (w->col == 0) put_char(w, '{');     // 没有任何列
+        put_char(w, '}');
+    }
+    put_char(w, '\n');
+    w->col = 0;
+    w->rows++;
+}
+
+bool report_flush(ReportWriter* w) {
+    if (w->len > 0) {
+        if (fwrite(w->buf, 1, w->len, w->out) != w->len) w->failed = true;
+        w->len = 0;
+    }
+    if (fflush(w->out) != 0) w->failed = true;
+    return !w->failed;
+}
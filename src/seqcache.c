@@ -0,0 +1,190 @@
+/**
+* @file seqcache.c
+ * @brief 结构序列磁盘缓存的实现。
+ *
+ * 缓存文件为 <dir>/<128 位内容哈希>.v<PIPELINE_VERSION>.seq，格式见 seqfile.h；
+ * 加载时映射文件，字典逐项驻留、序列一遍查表转换为调用方符号表的 ID。
+ * 区域片段使用同样的格式，扩展名为 .frag，与整文件缓存互不冲突。
+ */
+
+#include "../include/seqcache.h"
+#include "../include/pipeline.h"
+#include "../include/seqfile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#define seqcache_mkdir(d) _mkdir(d)
+#define seqcache_getpid() _getpid()
+#else
+#include <unistd.h>
+#define seqcache_mkdir(d) mkdir((d), 0777)
+#define seqcache_getpid() getpid()
+#endif
+
+static char* xstrdup(const char* s) {
+    size_t n = strlen(s);
+    char* p = (char*)malloc(n + 1);
+    if (!p) return NULL;
+    memcpy(p, s, n + 1);
+    return p;
+}
+
+/**
+ * @brief 打开（必要时创建）缓存目录。
+ *
+ * @return 目录可用返回 true；路径存在但不是目录或无法创建返回 false。
+ */
+bool seqcache_open(SeqCache* c, const char* dir) {
+    if (!c || !dir || !*dir) return false;
+    c->dir = NULL;
+    c->hits = c->misses = c->stores = 0;
+    c->frag_hits = c->frag_stores = 0;
+
+    struct stat st;
+    if (stat(dir, &st) != 0) {
+        seqcache_mkdir(dir);    // 其它进程可能同时创建，结果以随后的 stat 为准
+        if (stat(dir, &st) != 0) return false;
+    }
+    if ((st.st_mode & S_IFMT) != S_IFDIR) return false;
+
+    c->dir = xstrdup(dir);
+    return c->dir != NULL;
+}
+
+/**
+ * @brief 释放缓存句柄（不删除磁盘上的缓存文件）。
+ */
+void seqcache_close(SeqCache* c) {
+    if (!c) return;
+    free(c->dir);
+    c->dir = NULL;
+}
+
+static uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+/**
+ * @brief 64 位终混合（MurmurHash3 fmix64）。
+ */
+static uint64_t fmix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+/**
+ * @brief 两条独立的乘法-旋转链，每次吃入 8 字节，得到 128 位内容哈希。
+ *
+ * 非加密哈希：用于识别“内容相同的提交”，不用于对抗恶意构造的碰撞；
+ * 加载时还会核对源码长度。
+ */
+void seqcache_key(const char* source, size_t len, SeqKey* out) {
+    uint64_t h0 = 0x9e3779b97f4a7c15ull;
+    uint64_t h1 = 0xc2b2ae3d27d4eb4full;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t w;
+        memcpy(&w, source + i, 8);
+        h0 = rotl64(h0 ^ (w * 0x87c37b91114253d5ull), 31) * 0x4cf5ad432745937full;
+        h1 = rotl64(h1 + (w ^ 0x52dce729ull), 27) * 0x9e3779b97f4a7c15ull + h0;
+    }
+    uint64_t tail = 0;
+    if (i < len) memcpy(&tail, source + i, len - i);
+    h0 ^= tail * 0x87c37b91114253d5ull;
+    h1 ^= tail;
+
+    out->h[0] = fmix64(h0 ^ (uint64_t)len);
+    out->h[1] = fmix64(h1 ^ out->h[0]);
+    out->len = (uint64_t)len;
+}
+
+/**
+ * @brief 拼出键对应的缓存文件路径。
+ */
+static bool cache_path(const SeqCache* c, const SeqKey* key, const char* ext, char* buf, size_t n) {
+    int w = snprintf(buf, n, "%s/%016" PRIx64 "%016" PRIx64 ".v%u.%s",
+                     c->dir, key->h[0], key->h[1], (unsigned)PIPELINE_VERSION, ext);
+    return w > 0 && (size_t)w < n;
+}
+
+/**
+ * @brief 映射并核对缓存文件，通过后把序列追加到 out。
+ */
+static bool load_file(const SeqCache* c, const SeqKey* key, const char* ext,
+                      SymTab* syms, SymVec* out, uint64_t* aux) {
+    char path[4096];
+    if (!cache_path(c, key, ext, path, sizeof(path))) return false;
+
+    SeqView v;
+    if (!seqfile_open(&v, path)) return false;
+
+    bool ok = v.hdr->pipeline == PIPELINE_VERSION
+           && v.hdr->key[0] == key->h[0] && v.hdr->key[1] == key->h[1]
+           && v.hdr->src_len == key->len
+           && seqview_to_symbols(&v, syms, out);
+    if (ok && aux) *aux = v.hdr->aux;
+    seqfile_close(&v);
+    return ok;
+}
+
+/**
+ * @brief 先写临时文件再改名。
+ */
+static bool store_file(const SeqCache* c, const SeqKey* key, const char* ext, uint64_t aux,
+                       const SymTab* syms, const SymVec* seq) {
+    char path[4096], tmp[4200];
+    if (!cache_path(c, key, ext, path, sizeof(path))) return false;
+    // 进程号 + 栈上缓冲区地址：并行前端中两个线程可能同时写入同一内容键（重复提交），
+    // 同时存活的栈帧地址互不相同，临时文件因此不会冲突
+    snprintf(tmp, sizeof(tmp), "%s.%d.%p.tmp", path, (int)seqcache_getpid(), (void*)tmp);
+
+    bool ok = seqfile_write(tmp, key->h, key->len, aux, syms, seq);
+    if (ok) {
+#ifdef _WIN32
+        ok = MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+        ok = rename(tmp, path) == 0;
+#endif
+    }
+    if (!ok) remove(tmp);
+    return ok;
+}
+
+bool seqcache_load(SeqCache* c, const SeqKey* key, SymTab* syms, SymVec* out) {
+    if (!c || !c->dir || !key || !syms || !out) return false;
+    const bool ok = load_file(c, key, "seq", syms, out, NULL);
+    if (ok) c->hits++;
+    else c->misses++;
+    return ok;
+}
+
+bool seqcache_store(SeqCache* c, const SeqKey* key, const SymTab* syms, const SymVec* seq) {
+    if (!c || !c->dir || !key || !syms || !seq) return false;
+    if (!store_file(c, key, "seq", 0, syms, seq)) return false;
+    c->stores++;
+    return true;
+}
+
+bool seqcache_load_fragment(SeqCache* c, const SeqKey* key, SymTab* syms, SymVec* out, uint64_t* aux) {
+    if (!c || !c->dir || !key || !syms || !out || !aux) return false;
+    const bool ok = load_file(c, key, "frag", syms, out, aux);
+    if (ok) c->frag_hits++;
+    return ok;
+}
+
+bool seqcache_store_fragment(SeqCache* c, const SeqKey* key, const SymTab* syms, const SymVec* seq,
+                             uint64_t aux) {
+    if (!c || !c->dir || !key || !syms || !seq) return false;
+    if (!store_file(c, key, "frag", aux, syms, seq)) return false;
+    c->frag_stores++;
+    return true;
+}
@@ -0,0 +1,196 @@
+/**
+* @file seqfile.c
+ * @brief 序列文件的写入、映射与校验。
+ */
+
+#include "../include/seqfile.h"
+#include "../include/pipeline.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(sizeof(SeqFileHeader) == 96, "SeqFileHeader must stay 96 bytes");
+
+static uint64_t align8(uint64_t x) { return (x + 7u) & ~(uint64_t)7u; }
+
+bool seqfile_write(const char* path, const uint64_t key[2], uint64_t src_len, uint64_t aux,
+                   const SymTab* syms, const SymVec* seq) {
+    if (!path || !key || !syms || !seq) return false;
+
+    // 只收录序列中出现过的符号，按首次出现的顺序编号
+    const size_t nsym = symtab_size(syms);
+    uint32_t* local = (uint32_t*)malloc((nsym ? nsym : 1) * sizeof(uint32_t));
+    SymId* order = (SymId*)malloc((nsym ? nsym : 1) * sizeof(SymId));
+    bool ok = local && order;
+
+    uint32_t ndict = 0;
+    if (ok) {
+        for (size_t i = 0; i < nsym; i++) local[i] = UINT32_MAX;
+        for (size_t i = 0; i < seq->size; i++) {
+            const SymId id = seq->data[i];
+            if (id >= nsym) { ok = false; break; }
+            if (local[id] == UINT32_MAX) {
+                local[id] = ndict;
+                order[ndict++] = id;
+            }
+        }
+    }
+
+    // 字典偏移表；名称区总长需放得进 u32
+    uint32_t* name_off = ok ? (uint32_t*)malloc(((size_t)ndict + 1) * sizeof(uint32_t)) : NULL;
+    if (ok && !name_off) ok = false;
+    if (ok) {
+        uint64_t off = 0;
+        for (uint32_t i = 0; i < ndict; i++) {
+            name_off[i] = (uint32_t)off;
+            off += strlen(symtab_name(syms, order[i]));
+            if (off > UINT32_MAX) { ok = false; break; }
+        }
+        name_off[ndict] = (uint32_t)off;
+    }
+
+    SeqFileHeader h;
+    memset(&h, 0, sizeof(h));
+    if (ok) {
+        memcpy(h.magic, SEQFILE_MAGIC, 4);
+        h.format = SEQFILE_FORMAT;
+        h.byte_order = SEQFILE_BYTE_ORDER;
+        h.pipeline = PIPELINE_VERSION;
+        h.key[0] = key[0];
+        h.key[1] = key[1];
+        h.src_len = src_len;
+        h.nseq = seq->size;
+        h.ndict = ndict;
+        h.width = ndict <= 65536u ? 2u : 4u;
+        h.off_table = sizeof(SeqFileHeader);
+        h.off_names = h.off_table + ((uint64_t)ndict + 1) * 4u;
+        h.off_stream = align8(h.off_names + name_off[ndict]);
+        h.file_size = h.off_stream + h.nseq * h.width;
+        h.aux = aux;
+    }
+
+    FILE* fp = ok ? fopen(path, "wb") : NULL;
+    if (ok && !fp) ok = false;
+    if (ok) {
+        ok = fwrite(&h, sizeof(h), 1, fp) == 1
+          && fwrite(name_off, 4, (size_t)ndict + 1, fp) == (size_t)ndict + 1;
+        for (uint32_t i = 0; ok && i < ndict; i++) {
+            const char* name = symtab_name(syms, order[i]);
+            const size_t n = name_off[i + 1] - name_off[i];
+            ok = fwrite(name, 1, n, fp) == n;
+        }
+        static const char zeros[8] = { 0 };
+        const size_t pad = (size_t)(h.off_stream - (h.off_names + name_off[ndict]));
+        if (ok && pad) ok = fwrite(zeros, 1, pad, fp) == pad;
+
+        // 序列按块转换为局部下标后写出
+        enum { CHUNK = 4096 };
+        uint32_t buf32[CHUNK];
+        uint16_t buf16[CHUNK];
+        for (size_t i = 0; ok && i < seq->size; i += CHUNK) {
+            const size_t n = seq->size - i < CHUNK ? seq->size - i : CHUNK;
+            if (h.width == 2) {
+                for (size_t k = 0; k < n; k++) buf16[k] = (uint16_t)local[seq->data[i + k]];
+                ok = fwrite(buf16, 2, n, fp) == n;
+            } else {
+                for (size_t k = 0; k < n; k++) buf32[k] = local[seq->data[i + k]];
+                ok = fwrite(buf32, 4, n, fp) == n;
+            }
+        }
+        if (fclose(fp) != 0) ok = false;
+        if (!ok) remove(path);
+    }
+
+    free(local);
+    free(order);
+    free(name_off);
+    return ok;
+}
+
+bool seqfile_open(SeqView* v, const char* path) {
+    if (!v || !path) return false;
+    memset(v, 0, sizeof(*v));
+    if (!filemap_open(&v->map, path)) return false;
+
+    const uint64_t size = v->map.size;
+    const SeqFileHeader* h = (const SeqFileHeader*)v->map.data;
+
+    // 映射起始地址按页对齐；退回路径的 malloc 缓冲区也满足 8 字节对齐
+    bool ok = size >= sizeof(SeqFileHeader)
+           && memcmp(h->magic, SEQFILE_MAGIC, 4) == 0
+           && h->format == SEQFILE_FORMAT
+           && h->byte_order == SEQFILE_BYTE_ORDER
+           && (h->width == 2 || h->width == 4)
+           && h->file_size == size
+           && h->off_table == sizeof(SeqFileHeader)
+           && h->ndict < UINT32_MAX
+           && h->off_names == h->off_table + ((uint64_t)h->ndict + 1) * 4u
+           && h->off_names <= size
+           && h->off_stream % 8 == 0
+           && h->off_stream <= size
+           && h->nseq <= (size - h->off_stream) / h->width
+           && h->off_stream + h->nseq * h->width == size;
+
+    if (ok) {
+        v->hdr = h;
+        v->name_off = (const uint32_t*)(v->map.data + h->off_table);
+        v->names = v->map.data + h->off_names;
+        v->stream = v->map.data + h->off_stream;
+        // 名称区必须落在名称段内（偏移表本身的单调性在逐项驻留时检查）
+        ok = v->name_off[0] == 0 && h->off_names + v->name_off[h->ndict] <= h->off_stream;
+    }
+    if (!ok) {
+        seqfile_close(v);
+        return false;
+    }
+    return true;
+}
+
+void seqfile_close(SeqView* v) {
+    if (!v) return;
+    filemap_close(&v->map);
+    v->hdr = NULL;
+    v->name_off = NULL;
+    v->names = NULL;
+    v->stream = NULL;
+}
+
+bool seqview_to_symbols(const SeqView* v, SymTab* syms, SymVec* out) {
+    if (!v || !v->hdr || !syms || !out) return false;
+    const uint32_t ndict = v->hdr->ndict;
+    const size_t nseq = (size_t)v->hdr->nseq;
+
+    SymId* map = (SymId*)malloc((ndict ? ndict : 1) * sizeof(SymId));
+    if (!map) return false;
+
+    bool ok = true;
+    for (uint32_t i = 0; ok && i < ndict; i++) {
+        if (v->name_off[i + 1] < v->name_off[i]) { ok = false; break; }
+        size_t n;
+        const char* name = seqview_name(v, i, &n);
+        ok = symtab_intern_n(syms, name, n, &map[i]);
+    }
+
+    const size_t start = out->size;
+    if (ok) ok = symv_reserve(out, start + nseq);
+    if (ok) {
+        SymId* dst = out->data + start;
+        if (v->hdr->width == 2) {
+            const uint16_t* src = (const uint16_t*)v->stream;
+            for (size_t i = 0; i < nseq && ok; i++) {
+                if (src[i] >= ndict) ok = false;
+                else dst[i] = map[src[i]];
+            }
+        } else {
+            const uint32_t* src = (const uint32_t*)v->stream;
+            for (size_t i = 0; i < nseq && ok; i++) {
+                if (src[i] >= ndict) ok = false;
+                else dst[i] = map[src[i]];
+            }
+        }
+    }
+    if (ok) out->size = start + nseq;
+
+    free(map);
+    return ok;
+}
@@ -0,0 +1,230 @@
+/**
+* @file serve.c
+ * @brief 常驻服务模式：请求解析、增量维护语料与指纹、应答输出。
+ */
+
+#include "../include/serve.h"
+#include "../include/pipeline.h"
+#include "../include/filemap.h"
+#include "../include/fingerprint.h"
+#include <stdlib.h>
+#include <string.h>
+
+const char* const SERVE_COLS[] = { "op", "status", "rank", "file", "similarity", "distance", "documents" };
+const size_t      SERVE_NCOLS = sizeof(SERVE_COLS) / sizeof(SERVE_COLS[0]);
+
+/** @brief 单行请求的最大长度（含路径）。 */
+#define SERVE_LINE_MAX 4096
+
+/**
+ * @brief 服务状态：语料之外的常驻数据。
+ */
+typedef struct {
+    BatchCorpus*        c;
+    const ServeOptions* so;
+    ReportWriter*       rep;
+    uint64_t*           sym_hash;   // 符号 ID -> fp_label_hash，随符号表增长补齐
+    size_t              nhash;
+    FpVec*              sets;       // sets[i]：第 i 个语料文件的指纹（仅 prefilter > 0 时维护）
+    size_t              nsets;
+    bool*               skip;       // 每次查询的排除标记，容量随语料增长
+    size_t              skip_cap;
+} Server;
+
+/**
+ * @brief 为符号表中新增的 ID 补算哈希。
+ */
+static bool sync_hash(Server* sv) {
+    const size_t n = symtab_size(&sv->c->syms);
+    if (n <= sv->nhash) return true;
+    uint64_t* p = (uint64_t*)realloc(sv->sym_hash, n * sizeof(uint64_t));
+    if (!p) return false;
+    for (size_t i = sv->nhash; i < n; i++) p[i] = fp_label_hash(symtab_name(&sv->c->syms, (SymId)i));
+    sv->sym_hash = p;
+    sv->nhash = n;
+    return true;
+}
+
+static bool fingerprint(Server* sv, const SymVec* seq, FpVec* out) {
+    return sync_hash(sv) && fp_winnow(seq, sv->sym_hash, FP_DEFAULT_K, FP_DEFAULT_W, out);
+}
+
+/**
+ * @brief 让 sets 覆盖全部语料文件，并计算第 from 个之后新增文件的指纹。
+ */
+static bool sync_sets(Server* sv, size_t from) {
+    if (sv->so->opt.prefilter <= 0.0) return true;
+    if (sv->c->count > sv->nsets) {
+        FpVec* p = (FpVec*)realloc(sv->sets, sv->c->cap * sizeof(FpVec));
+        if (!p) return false;
+        for (size_t i = sv->nsets; i < sv->c->cap; i++) fp_init(&p[i]);
+        sv->sets = p;
+        sv->nsets = sv->c->cap;
+    }
+    for (size_t i = from; i < sv->c->count; i++) {
+        if (sv->c->files[i].ok && !fingerprint(sv, &sv->c->files[i].seq, &sv->sets[i])) return false;
+    }
+    return true;
+}
+
+static size_t find_path(const BatchCorpus* c, const char* path) {
+    for (size_t i = 0; i < c->count; i++) {
+        if (strcmp(c->files[i].path, path) == 0) return i;
+    }
+    return (size_t)-1;
+}
+
+static size_t live_count(const BatchCorpus* c) {
+    size_t n = 0;
+    for (size_t i = 0; i < c->count; i++) if (c->files[i].ok) n++;
+    return n;
+}
+
+/**
+ * @brief 读取并分析一份提交，符号驻留到语料符号表。
+ */
+static bool load_submission(Server* sv, const char* path, SymVec* out) {
+    FileMap map;
+    if (!filemap_open(&map, path)) return false;
+    symv_init(out);
+    const bool ok = sv->so->cache
+        ? pipeline_load_symbols(sv->so->cache, map.data, map.size, &sv->c->syms, out, NULL, NULL)
+        : pipeline_build_parallel(map.data, map.size, &sv->c->syms, out, NULL, sv->so->opt.jobs);
+    filemap_close(&map);
+    if (!ok) symv_free(out);
+    return ok;
+}
+
+/** @brief 应答结束记录：status 为 ok 或 error。 */
+static void reply_end(Server* sv, const char* op, const char* status, const char* path) {
+    report_str(sv->rep, op);
+    report_str(sv->rep, status);
+    report_null(sv->rep);
+    report_str(sv->rep, path);
+    report_null(sv->rep);
+    report_null(sv->rep);
+    report_uint(sv->rep, live_count(sv->c));
+    report_end_row(sv->rep);
+}
+
+/**
+ * @brief 输出 query 的匹配记录；self 为同路径旧版本的下标（不参与比较）。
+ */
+static bool answer_query(Server* sv, const char* op, const SymVec* query, size_t self) {
+    const BatchCorpus* c = sv->c;
+    if (c->count > sv->skip_cap) {
+        bool* p = (bool*)realloc(sv->skip, c->cap * sizeof(bool));
+        if (!p) return false;
+        sv->skip = p;
+        sv->skip_cap = c->cap;
+    }
+    for (size_t i = 0; i < c->count; i++) sv->skip[i] = (i == self);
+
+    // 指纹预筛：重合度不足的文件不进入精确比较
+    if (sv->so->opt.prefilter > 0.0) {
+        FpVec q;
+        fp_init(&q);
+        if (!fingerprint(sv, query, &q)) {
+            fp_free(&q);
+            return false;
+        }
+        for (size_t i = 0; i < c->count; i++) {
+            if (sv->skip[i] || !c->files[i].ok) continue;
+            const size_t shared = fp_shared(&q, &sv->sets[i]);
+            sv->skip[i] = fp_overlap(shared, q.size, sv->sets[i].size) < sv->so->opt.prefilter;
+        }
+        fp_free(&q);
+    }
+
+    size_t n = 0;
+    BatchPair* hits = batch_top_matches(c, &sv->so->opt, query, sv->skip, sv->so->top_k, &n, NULL);
+    if (!hits) return false;
+    for (size_t i = 0; i < n; i++) {
+        report_str(sv->rep, op);
+        report_str(sv->rep, "match");
+        report_uint(sv->rep, i + 1);
+        report_str(sv->rep, c->files[hits[i].a].path);
+        report_real(sv->rep, hits[i].sim);
+        report_uint(sv->rep, hits[i].dist);
+        report_null(sv->rep);
+        report_end_row(sv->rep);
+    }
+    free(hits);
+    return true;
+}
+
+/**
+ * @brief 把分析好的序列放入语料：同路径替换，否则追加。seq 的所有权转移给语料。
+ */
+static bool add_to_corpus(Server* sv, const char* path, SymVec* seq, size_t self) {
+    BatchCorpus* c = sv->c;
+    if (self == (size_t)-1) {
+        if (!batch_add_path(c, path)) return false;
+        self = c->count - 1;
+    } else {
+        symv_free(&c->files[self].seq);
+    }
+    c->files[self].seq = *seq;
+    c->files[self].ok = true;
+    symv_init(seq);
+    if (sv->so->opt.prefilter <= 0.0) return true;
+    if (!sync_sets(sv, c->count)) return false;
+    return fingerprint(sv, &c->files[self].seq, &sv->sets[self]);
+}
+
+/**
+ * @brief 处理一条请求；返回 false 表示内存不足，服务应当结束。
+ */
+static bool handle(Server* sv, const char* op, const char* path) {
+    const bool query = strcmp(op, "query") == 0 || strcmp(op, "check") == 0;
+    const bool add = strcmp(op, "add") == 0 || strcmp(op, "check") == 0;
+    if ((!query && !add) || *path == '\0') {
+        reply_end(sv, op, "error", path);
+        return true;
+    }
+
+    SymVec seq;
+    if (!load_submission(sv, path, &seq)) {
+        reply_end(sv, op, "error", path);
+        return true;
+    }
+    const size_t self = find_path(sv->c, path);
+    bool ok = !query || answer_query(sv, op, &seq, self);
+    if (ok && add) ok = add_to_corpus(sv, path, &seq, self);
+    symv_free(&seq);
+    reply_end(sv, op, ok ? "ok" : "error", path);
+    return ok;
+}
+
+int serve_run(BatchCorpus* c, const ServeOptions* so, FILE* in, ReportWriter* rep) {
+    Server sv;
+    memset(&sv, 0, sizeof(sv));
+    sv.c = c;
+    sv.so = so;
+    sv.rep = rep;
+
+    bool ok = sync_sets(&sv, 0);
+    char line[SERVE_LINE_MAX];
+    while (ok && fgets(line, sizeof(line), in)) {
+        size_t n = strlen(line);
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r' || line[n - 1] == ' ')) line[--n] = '\0';
+        char* op = line;
+        while (*op == ' ' || *op == '\t') op++;
+        if (*op == '\0' || *op == '#') continue;
+        if (strcmp(op, "quit") == 0) break;
+
+        char* path = op;
+        while (*path && *path != ' ' && *path != '\t') path++;
+        if (*path) *path++ = '\0';
+        while (*path == ' ' || *path == '\t') path++;
+
+        ok = handle(&sv, op, path);
+        if (!report_flush(rep)) ok = false;
+    }
+
+    for (size_t i = 0; i < sv.nsets; i++) fp_free(&sv.sets[i]);
+    free(sv.sets);
+    free(sv.sym_hash);
+    free(sv.skip);
+    return ok ? 0 : 1;
+}
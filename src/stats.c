@@ -0,0 +1,128 @@
+/**
+* @file stats.c
+ * @brief 运行统计的存储与输出。
+ */
+
+#include "../include/stats.h"
+
+#ifdef CDT_STATS
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+static const char* const COUNTER_NAMES[ST_COUNTER_COUNT] = {
+    "source_bytes", "tokens", "ast_nodes", "symbols", "distances", "dp_cells", "alloc_bytes"
+};
+
+static const char* const STAGE_NAMES[ST_STAGE_COUNT] = {
+    "read", "frontend", "distance", "align", "diff", "total"
+};
+
+#ifdef CDT_STATS
+
+uint64_t stats_counters_[ST_COUNTER_COUNT];
+static uint64_t stage_ns[ST_STAGE_COUNT];
+
+uint64_t stats_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER c;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&c);
+    return (uint64_t)((double)c.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+void stats_stage_add(StatStage s, uint64_t ns) {
+    if ((int)s < 0 || s >= ST_STAGE_COUNT) return;
+    STATS_ATOMIC_ADD(&stage_ns[s], ns);
+}
+
+#endif
+
+bool stats_enabled(void) {
+#ifdef CDT_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+void stats_reset(void) {
+#ifdef CDT_STATS
+    for (int i = 0; i < ST_COUNTER_COUNT; i++) stats_counters_[i] = 0;
+    for (int i = 0; i < ST_STAGE_COUNT; i++) stage_ns[i] = 0;
+#endif
+}
+
+uint64_t stats_counter(StatCounter c) {
+#ifdef CDT_STATS
+    if ((int)c >= 0 && c < ST_COUNTER_COUNT) return stats_counters_[c];
+#else
+    (void)c;
+#endif
+    return 0;
+}
+
+uint64_t stats_stage_ns(StatStage s) {
+#ifdef CDT_STATS
+    if ((int)s >= 0 && s < ST_STAGE_COUNT) return stage_ns[s];
+#else
+    (void)s;
+#endif
+    return 0;
+}
+
+const char* stats_counter_name(StatCounter c) {
+    return ((int)c >= 0 && c < ST_COUNTER_COUNT) ? COUNTER_NAMES[c] : "?";
+}
+
+const char* stats_stage_name(StatStage s) {
+    return ((int)s >= 0 && s < ST_STAGE_COUNT) ? STAGE_NAMES[s] : "?";
+}
+
+/**
+ * @brief 输出可读表格；附带由计数与耗时推得的吞吐，便于判断瓶颈在前端还是距离计算。
+ */
+void stats_print(FILE* out) {
+    if (!stats_enabled()) {
+        fprintf(out, "统计未编译（CMake 选项 ENABLE_STATS=OFF）\n");
+        return;
+    }
+    fprintf(out, "阶段耗时 (ms):\n");
+    for (int s = 0; s < ST_STAGE_COUNT; s++) {
+        fprintf(out, "  %-10s %12.3f\n", STAGE_NAMES[s], (double)stats_stage_ns((StatStage)s) / 1e6);
+    }
+    fprintf(out, "计数:\n");
+    for (int c = 0; c < ST_COUNTER_COUNT; c++) {
+        fprintf(out, "  %-13s %16llu\n", COUNTER_NAMES[c], (unsigned long long)stats_counter((StatCounter)c));
+    }
+    const double fe = (double)stats_stage_ns(ST_STAGE_FRONTEND) / 1e9;
+    const double ds = (double)stats_stage_ns(ST_STAGE_DISTANCE) / 1e9;
+    if (fe > 0) {
+        fprintf(out, "  前端吞吐: %.2f MB/s, %.0f tokens/s\n",
+                (double)stats_counter(ST_SOURCE_BYTES) / 1048576.0 / fe, (double)stats_counter(ST_TOKENS) / fe);
+    }
+    if (ds > 0) {
+        fprintf(out, "  距离吞吐: %.3g cells/s\n", (double)stats_counter(ST_DP_CELLS) / ds);
+    }
+}
+
+void stats_print_json(FILE* out) {
+    fprintf(out, "{\"enabled\":%s,\"stages_ms\":{", stats_enabled() ? "true" : "false");
+    for (int s = 0; s < ST_STAGE_COUNT; s++) {
+        fprintf(out, "%s\"%s\":%.3f", s ? "," : "", STAGE_NAMES[s], (double)stats_stage_ns((StatStage)s) / 1e6);
+    }
+    fprintf(out, "},\"counters\":{");
+    for (int c = 0; c < ST_COUNTER_COUNT; c++) {
+        fprintf(out, "%s\"%s\":%llu", c ? "," : "", COUNTER_NAMES[c], (unsigned long long)stats_counter((StatCounter)c));
+    }
+    fprintf(out, "}}\n");
+}
@@ -16,3 +16,35 @@ void token_free(Token *tok) {
 
     free(tok);
 }
+
+void token_array_init(TokenArray *arr, const char *source, const SymTab *lexes) {
+    arr->data = NULL;
+    arr->size = 0;
+    arr->cap = 0;
+    arr->source = source;
+    arr->lexes = lexes;
+}
+
+bool token_array_push(TokenArray *arr, const TokenRef *tok) {
+    if (arr->size == arr->cap) {
+        size_t nc = (arr->cap == 0) ? 1024 : arr->cap * 2;
+        TokenRef *p = (TokenRef*)realloc(arr->data, nc * sizeof(TokenRef));
+        if (p == NULL) {
+            return false;
+        }
+        arr->data = p;
+        arr->cap = nc;
+    }
+    arr->data[arr->size++] = *tok;
+    return true;
+}
+
+void token_array_free(TokenArray *arr) {
+    if (arr == NULL) {
+        return;
+    }
+    free(arr->data);
+    arr->data = NULL;
+    arr->size = 0;
+    arr->cap = 0;
+}
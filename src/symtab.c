@@ -0,0 +1,195 @@
+/**
+* @file symtab.c
+ * @brief 字符串驻留表与整数符号序列的实现。
+ *
+ * 哈希表采用开放寻址（线性探测），负载因子不超过 1/2；
+ * 名称字节存放在区域分配器中，每个新符号只做一次拷贝，不单独 malloc。
+ */
+
+#include "../include/symtab.h"
+#include "../include/stats.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief FNV-1a 64 位哈希（对短标签足够快且分布良好）。
+ */
+static uint64_t sym_hash(const char* s, size_t len) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < len; ++ i) {
+        h ^= (unsigned char)s[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+/**
+ * @brief 将哈希表扩容到 new_cap 个槽并重新放置已有符号。
+ */
+static bool rehash(SymTab* t, size_t new_cap) {
+    uint32_t* slots = (uint32_t*)calloc(new_cap, sizeof(uint32_t));
+    if (!slots) return false;
+    const size_t mask = new_cap - 1;
+    for (size_t id = 0; id < t->count; ++ id) {
+        size_t i = (size_t)t->hashes[id] & mask;
+        while (slots[i]) i = (i + 1) & mask;
+        slots[i] = (uint32_t)id + 1;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->slot_cap = new_cap;
+    return true;
+}
+
+/**
+ * @brief 初始化空符号表。
+ */
+void symtab_init(SymTab* t) {
+    t->slots = NULL;
+    t->slot_cap = 0;
+    t->names = NULL;
+    t->hashes = NULL;
+    t->count = 0;
+    t->cap = 0;
+    arena_init(&t->pool, 0);
+}
+
+/**
+ * @brief 释放符号表及其字符串池；此后 symtab_name 返回的指针全部失效。
+ *
+ * @param t 目标符号表；可为 NULL。
+ */
+void symtab_free(SymTab* t) {
+    if (!t) return;
+    arena_free(&t->pool);
+    free(t->slots);
+    free(t->names);
+    free(t->hashes);
+    symtab_init(t);
+}
+
+/**
+ * @brief 驻留长度为 len 的字符串片段（不要求以 '\0' 结尾）。
+ *
+ * @param t   符号表。
+ * @param s   字符串起始指针。
+ * @param len 字节数。
+ * @param out 输出符号 ID。
+ * @return 成功返回 true；内存不足返回 false。
+ */
+bool symtab_intern_n(SymTab* t, const char* s, size_t len, SymId* out) {
+    if (!t || !s || !out) return false;
+
+    if (t->slot_cap == 0 && !rehash(t, 64)) return false;
+
+    const uint64_t h = sym_hash(s, len);
+    size_t mask = t->slot_cap - 1;
+    size_t i = (size_t)h & mask;
+    while (t->slots[i]) {
+        const SymId id = t->slots[i] - 1;
+        if (t->hashes[id] == h && strncmp(t->names[id], s, len) == 0 && t->names[id][len] == '\0') {
+            *out = id;
+            return true;
+        }
+        i = (i + 1) & mask;
+    }
+
+    if (t->count == UINT32_MAX - 1) return false;
+
+    if (t->count == t->cap) {
+        size_t nc = (t->cap == 0) ? 64 : t->cap * 2;
+        const char** names = (const char**)realloc((void*)t->names, nc * sizeof(char*));
+        if (!names) return false;
+        t->names = names;
+        uint64_t* hashes = (uint64_t*)realloc(t->hashes, nc * sizeof(uint64_t));
+        if (!hashes) return false;
+        t->hashes = hashes;
+        t->cap = nc;
+    }
+
+    const char* name = arena_strndup(&t->pool, s, len);
+    if (!name) return false;
+
+    const SymId id = (SymId)t->count++;
+    t->names[id] = name;
+    t->hashes[id] = h;
+    t->slots[i] = id + 1;
+
+    if (t->count * 2 > t->slot_cap) {
+        if (!rehash(t, t->slot_cap * 2)) return false;
+    }
+
+    *out = id;
+    return true;
+}
+
+/**
+ * @brief 驻留以 '\0' 结尾的字符串。
+ */
+bool symtab_intern(SymTab* t, const char* s, SymId* out) {
+    if (!s) return false;
+    return symtab_intern_n(t, s, strlen(s), out);
+}
+
+/**
+ * @brief 反查符号名称（调试/报告输出用）。
+ *
+ * @return 名称指针；ID 越界返回 NULL。
+ */
+const char* symtab_name(const SymTab* t, SymId id) {
+    if (!t || id >= t->count) return NULL;
+    return t->names[id];
+}
+
+/**
+ * @brief 已驻留的符号数量（即最大 ID + 1）。
+ */
+size_t symtab_size(const SymTab* t) {
+    return t ? t->count : 0;
+}
+
+/**
+ * @brief 初始化符号序列。
+ */
+void symv_init(SymVec* v) {
+    v->data = NULL;
+    v->size = 0;
+    v->cap = 0;
+}
+
+/**
+ * @brief 预留至少 cap 个元素的容量（已知长度时可避免多次 realloc）。
+ */
+bool symv_reserve(SymVec* v, size_t cap) {
+    if (!v) return false;
+    if (cap <= v->cap) return true;
+    SymId* p = (SymId*)realloc(v->data, cap * sizeof(SymId));
+    if (!p) return false;
+    STATS_ADD(ST_ALLOC_BYTES, (cap - v->cap) * sizeof(SymId));
+    v->data = p;
+    v->cap = cap;
+    return true;
+}
+
+/**
+ * @brief 追加一个符号 ID（容量不足则倍增）。
+ */
+bool symv_push(SymVec* v, SymId id) {
+    if (!v) return false;
+    if (v->size == v->cap) {
+        if (!symv_reserve(v, (v->cap == 0) ? 64 : v->cap * 2)) return false;
+    }
+    v->data[v->size++] = id;
+    return true;
+}
+
+/**
+ * @brief 释放符号序列。
+ *
+ * @param v 目标序列；可为 NULL。
+ */
+void symv_free(SymVec* v) {
+    if (!v) return;
+    free(v->data);
+    symv_init(v);
+}
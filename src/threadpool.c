@@ -0,0 +1,289 @@
+/**
+* @file threadpool.c
+ * @brief 工作窃取线程池的实现（POSIX pthread / Windows 原生线程）。
+ *
+ * 每个工作线程持有一个任务下标区间 [lo, hi)：
+ * - 自己从区间头部逐个取任务；
+ * - 区间为空时轮询其它线程，从其区间尾部窃取一半（只剩 1 个则取走这 1 个）；
+ * - 任务不会产生新任务，因此一轮轮询全部为空即可退出。
+ */
+
+#include "../include/threadpool.h"
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <windows.h>
+typedef CRITICAL_SECTION   tp_mutex_t;
+typedef CONDITION_VARIABLE tp_cond_t;
+typedef HANDLE             tp_thread_t;
+#define tp_mutex_init(m)    InitializeCriticalSection(m)
+#define tp_mutex_destroy(m) DeleteCriticalSection(m)
+#define tp_lock(m)          EnterCriticalSection(m)
+#define tp_unlock(m)        LeaveCriticalSection(m)
+#define tp_cond_init(c)     InitializeConditionVariable(c)
+#define tp_cond_destroy(c)  ((void)(c))
+#define tp_cond_wait(c, m)  SleepConditionVariableCS((c), (m), INFINITE)
+#define tp_cond_broadcast(c) WakeAllConditionVariable(c)
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_mutex_t tp_mutex_t;
+typedef pthread_cond_t  tp_cond_t;
+typedef pthread_t       tp_thread_t;
+#define tp_mutex_init(m)    pthread_mutex_init((m), NULL)
+#define tp_mutex_destroy(m) pthread_mutex_destroy(m)
+#define tp_lock(m)          pthread_mutex_lock(m)
+#define tp_unlock(m)        pthread_mutex_unlock(m)
+#define tp_cond_init(c)     pthread_cond_init((c), NULL)
+#define tp_cond_destroy(c)  pthread_cond_destroy(c)
+#define tp_cond_wait(c, m)  pthread_cond_wait((c), (m))
+#define tp_cond_broadcast(c) pthread_cond_broadcast(c)
+#endif
+
+/**
+ * @brief 单个工作线程的任务区间（按缓存行对齐，避免伪共享）。
+ */
+typedef struct {
+    tp_mutex_t lock;
+    size_t lo, hi;
+    char pad[64];
+} TpRange;
+
+/**
+ * @brief 工作线程启动参数。
+ */
+typedef struct {
+    ThreadPool* pool;
+    int id;
+} TpWorkerArg;
+
+struct ThreadPool {
+    int n;                      // 工作线程数（含调用线程）
+    tp_thread_t* threads;       // n - 1 个后台线程
+    TpWorkerArg* args;
+    TpRange* ranges;            // n 个区间
+
+    tp_mutex_t lock;            // 保护以下字段
+    tp_cond_t wake;             // 新任务批次 / 停止
+    tp_cond_t done;             // 后台线程全部完成当前批次
+    unsigned long generation;   // 任务批次编号
+    int active;                 // 尚未完成当前批次的后台线程数
+    bool stop;
+
+    TpTaskFn fn;                // 当前批次
+    void* ctx;
+};
+
+/**
+ * @brief 从 owner 自己的区间头部取一个任务。
+ */
+static bool take_own(TpRange* r, size_t* out) {
+    bool ok = false;
+    tp_lock(&r->lock);
+    if (r->lo < r->hi) {
+        *out = r->lo++;
+        ok = true;
+    }
+    tp_unlock(&r->lock);
+    return ok;
+}
+
+/**
+ * @brief 轮询其它线程，窃取其剩余区间的后一半，放入自己的区间。
+ *
+ * @return 窃取到任务返回 true，并通过 out 直接返回其中第一个。
+ */
+static bool steal(ThreadPool* pool, int self, size_t* out) {
+    for (int k = 1; k < pool->n; k++) {
+        TpRange* v = &pool->ranges[(self + k) % pool->n];
+        size_t lo = 0, hi = 0;
+
+        tp_lock(&v->lock);
+        const size_t left = v->hi - v->lo;
+        if (left > 0) {
+            const size_t mid = v->hi - (left + 1) / 2;
+            lo = mid;
+            hi = v->hi;
+            v->hi = mid;
+        }
+        tp_unlock(&v->lock);
+
+        if (lo < hi) {
+            TpRange* mine = &pool->ranges[self];
+            *out = lo;
+            tp_lock(&mine->lock);
+            mine->lo = lo + 1;
+            mine->hi = hi;
+            tp_unlock(&mine->lock);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 执行当前批次直到全部区间为空。
+ */
+static void run_worker(ThreadPool* pool, int id) {
+    size_t i;
+    for (;;) {
+        if (take_own(&pool->ranges[id], &i) || steal(pool, id, &i)) {
+            pool->fn(pool->ctx, i, id);
+        } else {
+            break;
+        }
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI worker_main(LPVOID p) {
+#else
+static void* worker_main(void* p) {
+#endif
+    TpWorkerArg* arg = (TpWorkerArg*)p;
+    ThreadPool* pool = arg->pool;
+    unsigned long seen = 0;
+
+    for (;;) {
+        tp_lock(&pool->lock);
+        while (!pool->stop && pool->generation == seen) tp_cond_wait(&pool->wake, &pool->lock);
+        if (pool->stop) {
+            tp_unlock(&pool->lock);
+            break;
+        }
+        seen = pool->generation;
+        tp_unlock(&pool->lock);
+
+        run_worker(pool, arg->id);
+
+        tp_lock(&pool->lock);
+        if (--pool->active == 0) tp_cond_broadcast(&pool->done);
+        tp_unlock(&pool->lock);
+    }
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * @brief 逻辑 CPU 数。
+ */
+int tp_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors > 0 ? (int)si.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+/**
+ * @brief 创建线程池并启动 nthreads - 1 个后台线程。
+ */
+ThreadPool* tp_create(int nthreads) {
+    if (nthreads <= 0) nthreads = tp_cpu_count();
+
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+    pool->n = nthreads;
+    pool->ranges = (TpRange*)calloc((size_t)nthreads, sizeof(TpRange));
+    pool->threads = (tp_thread_t*)calloc((size_t)nthreads, sizeof(tp_thread_t));
+    pool->args = (TpWorkerArg*)calloc((size_t)nthreads, sizeof(TpWorkerArg));
+    if (!pool->ranges || !pool->threads || !pool->args) {
+        free(pool->ranges); free(pool->threads); free(pool->args); free(pool);
+        return NULL;
+    }
+
+    tp_mutex_init(&pool->lock);
+    tp_cond_init(&pool->wake);
+    tp_cond_init(&pool->done);
+
+    int started = 1;
+    for (int i = 1; i < nthreads; i++) {
+        pool->args[i].pool = pool;
+        pool->args[i].id = i;
+#ifdef _WIN32
+        pool->threads[i] = CreateThread(NULL, 0, worker_main, &pool->args[i], 0, NULL);
+        if (!pool->threads[i]) break;
+#else
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->args[i]) != 0) break;
+#endif
+        started++;
+    }
+    // 部分线程创建失败时，以实际启动的数量继续工作（区间只在任务批次中访问）
+    pool->n = started;
+    for (int i = 0; i < pool->n; i++) tp_mutex_init(&pool->ranges[i].lock);
+    return pool;
+}
+
+/**
+ * @brief 通知全部后台线程退出并回收资源。
+ */
+void tp_destroy(ThreadPool* pool) {
+    if (!pool) return;
+
+    tp_lock(&pool->lock);
+    pool->stop = true;
+    tp_cond_broadcast(&pool->wake);
+    tp_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->n; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+#else
+        pthread_join(pool->threads[i], NULL);
+#endif
+    }
+
+    for (int i = 0; i < pool->n; i++) tp_mutex_destroy(&pool->ranges[i].lock);
+    tp_mutex_destroy(&pool->lock);
+    tp_cond_destroy(&pool->wake);
+    tp_cond_destroy(&pool->done);
+    free(pool->ranges);
+    free(pool->threads);
+    free(pool->args);
+    free(pool);
+}
+
+int tp_size(const ThreadPool* pool) {
+    return pool ? pool->n : 1;
+}
+
+/**
+ * @brief 将 [0, n) 均分给各工作线程后并行执行，阻塞到全部完成。
+ */
+void tp_parallel_for(ThreadPool* pool, size_t n, TpTaskFn fn, void* ctx) {
+    if (n == 0 || !fn) return;
+    if (!pool || pool->n == 1 || n == 1) {
+        for (size_t i = 0; i < n; i++) fn(ctx, i, 0);
+        return;
+    }
+
+    const size_t w = (size_t)pool->n;
+    for (size_t t = 0; t < w; t++) {
+        TpRange* r = &pool->ranges[t];
+        tp_lock(&r->lock);
+        r->lo = n * t / w;
+        r->hi = n * (t + 1) / w;
+        tp_unlock(&r->lock);
+    }
+
+    tp_lock(&pool->lock);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->active = pool->n - 1;
+    pool->generation++;
+    tp_cond_broadcast(&pool->wake);
+    tp_unlock(&pool->lock);
+
+    run_worker(pool, 0);
+
+    tp_lock(&pool->lock);
+    while (pool->active > 0) tp_cond_wait(&pool->done, &pool->lock);
+    tp_unlock(&pool->lock);
+}
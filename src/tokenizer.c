@@ -3,164 +3,502 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <stdint.h>
+
+// SIMD 加速的空白/注释扫描：x86 上用 SSE2，ARM 上用 NEON，其它平台走标量路径
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TK_SIMD_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TK_SIMD_NEON 1
+#endif
+#if defined(_MSC_VER) && (defined(TK_SIMD_SSE2) || defined(TK_SIMD_NEON))
+#include <intrin.h>
+#endif
+
+// 字节分类表（与 C locale 下的 ctype 判定一致），一次查表代替 isspace/isalpha/strchr
+enum {
+    CC_BLANK = 0x01,    // ' ' '\t'：可成段跳过的行内空白
+    CC_SPACE = 0x02,    // isspace：' ' '\t' '\n' '\v' '\f' '\r'
+    CC_ALPHA = 0x04,    // 标识符首字符：字母与 '_'
+    CC_DIGIT = 0x08,    // '0'-'9'
+    CC_OP    = 0x10,    // 运算符首字符 "+-*/%=!<>&|^~"
+    CC_PUNC  = 0x20     // 标点 "(){}[];,."
+};
 
-// 关键字映射表
-typedef struct {
-    const char *word;
-    KeywordKind kind;
-} KeywordMap;
-
-static KeywordMap keyword_table[] = {
-    {"if", KW_IF}, {"else", KW_ELSE}, {"for", KW_FOR}, {"while", KW_WHILE},
-    {"do", KW_DO}, {"switch", KW_SWITCH}, {"case", KW_CASE}, {"default", KW_DEFAULT},
-    {"return", KW_RETURN}, {"break", KW_BREAK}, {"continue", KW_CONTINUE},
-    {"int", KW_INT}, {"char", KW_CHAR}, {"float", KW_FLOAT}, {"double", KW_DOUBLE},
-    {"void", KW_VOID}, {"struct", KW_STRUCT}, {"typedef", KW_TYPEDEF},
-    {NULL, KW_UNKNOWN}
+static const unsigned char char_class[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x02, 0x02, 0x02, 0x02, 0x00, 0x00,   // 00-0F
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // 10-1F
+    0x03, 0x10, 0x00, 0x00, 0x00, 0x10, 0x10, 0x00, 0x20, 0x20, 0x10, 0x10, 0x20, 0x10, 0x20, 0x10,   // 20-2F
+    0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x00, 0x20, 0x10, 0x10, 0x10, 0x00,   // 30-3F
+    0x00, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,   // 40-4F
+    0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x20, 0x00, 0x20, 0x10, 0x04,   // 50-5F
+    0x00, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04,   // 60-6F
+    0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x20, 0x10, 0x20, 0x10, 0x00,   // 70-7F
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // 80-8F
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // 90-9F
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // A0-AF
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // B0-BF
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // C0-CF
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // D0-DF
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // E0-EF
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // F0-FF
 };
 
-// 辅助函数：创建token
-static Token* create_token(TokenType type, const char *raw, const char *lex, int line, int col) {
+#define CC_IS(c, mask) (char_class[(unsigned char)(c)] & (mask))
+
+// 一次扫描的结果：原始文本与归一化文本都只是指针+长度，不做分配
+typedef struct {
+    TokenType type;
+    KeywordKind kw;
+    const char *raw;        // 原始文本（指向源码）
+    size_t raw_len;
+    const char *lex;        // 归一化文本（指向源码、常量或 buf）
+    size_t lex_len;
+    char buf[32];           // 标识符归一化 var_N 的存放处
+    int line, col;
+} Scan;
+
+// 辅助函数：读取 current 之后第 k 个字符；越过 end 时返回 '\0'（源码无需以 '\0' 结尾）
+static inline char ch_at(const Tokenizer *tk, size_t k) {
+    return ((size_t)(tk->end - tk->current) > k) ? tk->current[k] : '\0';
+}
+
+// 辅助函数：复制长度为 n 的字符串片段
+static char* dup_n(const char *s, size_t n) {
+    char *p = (char*)malloc(n + 1);
+    if (!p) return NULL;
+    memcpy(p, s, n);
+    p[n] = '\0';
+    return p;
+}
+
+// 辅助函数：由扫描结果创建token（兼容接口，raw/lex 各复制一份）
+static Token* create_token(const Scan *sc) {
     Token *tok = (Token*)malloc(sizeof(Token));
-    tok->type = type;
-    tok->kw = KW_UNKNOWN;
-    tok->raw = strdup(raw);
-    tok->lex = strdup(lex);
-    tok->line = line;
-    tok->col = col;
+    if (!tok) return NULL;
+    tok->type = sc->type;
+    tok->kw = sc->kw;
+    tok->raw = dup_n(sc->raw, sc->raw_len);
+    tok->lex = dup_n(sc->lex, sc->lex_len);
+    tok->line = sc->line;
+    tok->col = sc->col;
     return tok;
 }
 
-// 辅助函数：检查是否是关键字
-static KeywordKind check_keyword(const char *word) {
-    for (int i = 0; keyword_table[i].word != NULL; i++) {
-        if (strcmp(word, keyword_table[i].word) == 0) {
-            return keyword_table[i].kind;
-        }
+// 辅助函数：填写扫描结果
+static void set_scan(Scan *sc, TokenType type, const char *raw, size_t raw_len,
+                     const char *lex, size_t lex_len, int line, int col) {
+    sc->type = type;
+    sc->kw = KW_UNKNOWN;
+    sc->raw = raw;
+    sc->raw_len = raw_len;
+    sc->lex = lex;
+    sc->lex_len = lex_len;
+    sc->line = line;
+    sc->col = col;
+}
+
+// 关键字匹配：长度与字面量都相同才命中（字面量长度在编译期确定）
+#define KW_MATCH(lit, kind) \
+    if (len == sizeof(lit) - 1 && memcmp(word, lit, sizeof(lit) - 1) == 0) return kind
+
+// 辅助函数：检查 (word, len) 片段是否是关键字
+// 先按长度范围过滤，再按首字母分派，每个分支只比较少数几个候选，
+// 代价与关键字总数无关；直接作用于源码片段，不需要临时拷贝
+static KeywordKind check_keyword(const char *word, size_t len) {
+    if (len < 2 || len > 8) return KW_UNKNOWN;
+
+    switch (word[0]) {
+        case 'a':
+            KW_MATCH("auto", KW_AUTO);
+            break;
+        case 'b':
+            KW_MATCH("break", KW_BREAK);
+            break;
+        case 'c':
+            KW_MATCH("case", KW_CASE);
+            KW_MATCH("char", KW_CHAR);
+            KW_MATCH("const", KW_CONST);
+            KW_MATCH("continue", KW_CONTINUE);
+            break;
+        case 'd':
+            KW_MATCH("do", KW_DO);
+            KW_MATCH("double", KW_DOUBLE);
+            KW_MATCH("default", KW_DEFAULT);
+            break;
+        case 'e':
+            KW_MATCH("else", KW_ELSE);
+            KW_MATCH("enum", KW_ENUM);
+            KW_MATCH("extern", KW_EXTERN);
+            break;
+        case 'f':
+            KW_MATCH("for", KW_FOR);
+            KW_MATCH("float", KW_FLOAT);
+            break;
+        case 'g':
+            KW_MATCH("goto", KW_GOTO);
+            break;
+        case 'i':
+            KW_MATCH("if", KW_IF);
+            KW_MATCH("int", KW_INT);
+            KW_MATCH("inline", KW_INLINE);
+            break;
+        case 'l':
+            KW_MATCH("long", KW_LONG);
+            break;
+        case 'r':
+            KW_MATCH("return", KW_RETURN);
+            KW_MATCH("register", KW_REGISTER);
+            KW_MATCH("restrict", KW_RESTRICT);
+            break;
+        case 's':
+            KW_MATCH("short", KW_SHORT);
+            KW_MATCH("signed", KW_SIGNED);
+            KW_MATCH("sizeof", KW_SIZEOF);
+            KW_MATCH("static", KW_STATIC);
+            KW_MATCH("struct", KW_STRUCT);
+            KW_MATCH("switch", KW_SWITCH);
+            break;
+        case 't':
+            KW_MATCH("typedef", KW_TYPEDEF);
+            break;
+        case 'u':
+            KW_MATCH("union", KW_UNION);
+            KW_MATCH("unsigned", KW_UNSIGNED);
+            break;
+        case 'v':
+            KW_MATCH("void", KW_VOID);
+            KW_MATCH("volatile", KW_VOLATILE);
+            break;
+        case 'w':
+            KW_MATCH("while", KW_WHILE);
+            break;
+        default:
+            break;
     }
     return KW_UNKNOWN;
 }
 
+#undef KW_MATCH
+
+#if defined(TK_SIMD_SSE2) || defined(TK_SIMD_NEON)
+// 辅助函数：最低位 1 的下标（x != 0）
+static inline unsigned tk_ctz64(uint64_t x) {
+#if defined(_MSC_VER)
+    unsigned long i;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&i, x);
+#else
+    if ((uint32_t)x) _BitScanForward(&i, (uint32_t)x);
+    else { _BitScanForward(&i, (uint32_t)(x >> 32)); i += 32; }
+#endif
+    return (unsigned)i;
+#else
+    return (unsigned)__builtin_ctzll(x);
+#endif
+}
+#endif
+
+#if defined(TK_SIMD_NEON)
+// 辅助函数：把 16 字节比较结果压缩为 64 位掩码，每字节对应 4 位
+static inline uint64_t neon_mask(uint8x16_t eq) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+}
+#endif
+
+// 辅助函数：p[0..n) 开头连续的 ' ' / '\t' 个数（每次比较 16 字节）
+static size_t span_blank(const char *p, size_t n) {
+    size_t i = 0;
+#if defined(TK_SIMD_SSE2)
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i tb = _mm_set1_epi8('\t');
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        const unsigned m = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tb)));
+        if (m != 0xFFFFu) return i + tk_ctz64(~m & 0xFFFFu);
+    }
+#elif defined(TK_SIMD_NEON)
+    const uint8x16_t sp = vdupq_n_u8(' ');
+    const uint8x16_t tb = vdupq_n_u8('\t');
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8((const uint8_t*)p + i);
+        const uint64_t m = neon_mask(vorrq_u8(vceqq_u8(v, sp), vceqq_u8(v, tb)));
+        if (m != ~(uint64_t)0) return i + tk_ctz64(~m) / 4;
+    }
+#endif
+    while (i < n && CC_IS(p[i], CC_BLANK)) i++;
+    return i;
+}
+
+// 辅助函数：p[0..n) 中第一个等于 a 或 b 的下标；都不存在返回 n（每次比较 16 字节）
+static size_t span_until2(const char *p, size_t n, char a, char b) {
+    size_t i = 0;
+#if defined(TK_SIMD_SSE2)
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        const unsigned m = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb)));
+        if (m) return i + tk_ctz64(m);
+    }
+#elif defined(TK_SIMD_NEON)
+    const uint8x16_t va = vdupq_n_u8((uint8_t)a);
+    const uint8x16_t vb = vdupq_n_u8((uint8_t)b);
+    for (; i + 16 <= n; i += 16) {
+        const uint8x16_t v = vld1q_u8((const uint8_t*)p + i);
+        const uint64_t m = neon_mask(vorrq_u8(vceqq_u8(v, va), vceqq_u8(v, vb)));
+        if (m) return i + tk_ctz64(m) / 4;
+    }
+#endif
+    while (i < n && p[i] != a && p[i] != b) i++;
+    return i;
+}
+
 // 跳过空白字符和注释
+// 行内空白与注释正文成段跳过：只在 '\n'（以及块注释中的 '*'）处停下，
+// 因此行号逐行累加、列号按跳过的字节数累加，与逐字节扫描的结果一致
 static void skip_whitespace_and_comments(Tokenizer *tk) {
-    while (*tk->current) {
-        // 跳过空白字符
-        if (isspace(*tk->current)) {
-            if (*tk->current == '\n') {
-                tk->line++;
-                tk->col = 1;
-            } else {
-                tk->col++;
-            }
+    for (;;) {
+        const size_t n = (size_t)(tk->end - tk->current);
+        if (n == 0) return;
+        const char c = tk->current[0];
+
+        // 跳过成段的空格/制表符
+        if (CC_IS(c, CC_BLANK)) {
+            const size_t k = span_blank(tk->current, n);
+            tk->current += k;
+            tk->col += (int)k;
+        }
+        // 换行
+        else if (c == '\n') {
+            tk->line++;
+            tk->col = 1;
             tk->current++;
         }
-        // 跳过单行注释
-        else if (tk->current[0] == '/' && tk->current[1] == '/') {
-            while (*tk->current && *tk->current != '\n') {
-                tk->current++;
-            }
+        // 其它空白字符（'\r' '\v' '\f'）
+        else if (CC_IS(c, CC_SPACE)) {
+            tk->col++;
+            tk->current++;
+        }
+        // 跳过单行注释：直接定位到行尾（列号在随后的换行处重置）
+        else if (c == '/' && n >= 2 && tk->current[1] == '/') {
+            tk->current += 2 + span_until2(tk->current + 2, n - 2, '\n', '\n');
         }
         // 跳过多行注释
-        else if (tk->current[0] == '/' && tk->current[1] == '*') {
+        else if (c == '/' && n >= 2 && tk->current[1] == '*') {
             tk->current += 2;
             tk->col += 2;
-            while (*tk->current) {
-                if (tk->current[0] == '*' && tk->current[1] == '/') {
+            for (;;) {
+                const size_t rem = (size_t)(tk->end - tk->current);
+                const size_t k = span_until2(tk->current, rem, '*', '\n');
+                tk->current += k;
+                tk->col += (int)k;
+                if (k == rem) break;    // 注释未闭合，直到文件末尾
+
+                if (tk->current[0] == '\n') {
+                    tk->line++;
+                    tk->col = 1;
+                    tk->current++;
+                } else if (rem - k >= 2 && tk->current[1] == '/') {
                     tk->current += 2;
                     tk->col += 2;
                     break;
-                }
-                if (*tk->current == '\n') {
-                    tk->line++;
-                    tk->col = 1;
                 } else {
+                    tk->current++;
                     tk->col++;
                 }
-                tk->current++;
             }
         }
         else {
-            break;
+            return;
         }
     }
 }
 
+// ---- 作用域模式的标识符编号 ----
+
+enum { SCOPE_LOCAL = 0, SCOPE_FUNC = 1, SCOPE_FILE = 2 };
+
+static const char SCOPE_PREFIX[3][4] = { "id_", "fn_", "gv_" };
+
+// 名称哈希（FNV-1a）
+static uint32_t scope_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+// 清空一个名称表：只推进代号，旧槽自然失效
+static void scope_clear(TkScopeTable *t) {
+    t->gen++;
+    t->count = 0;
+}
+
+// 在表中查找名称：找到返回其槽，否则返回应插入的空槽
+static TkScopeSlot* scope_probe(const Tokenizer *tk, TkScopeTable *t, const char *s, size_t len, uint32_t h) {
+    for (uint32_t i = h & (TK_SCOPE_SLOTS - 1);; i = (i + 1) & (TK_SCOPE_SLOTS - 1)) {
+        TkScopeSlot *slot = &t->slots[i];
+        if (slot->gen != t->gen) return slot;
+        if (slot->len == len && memcmp(tk->source + slot->off, s, len) == 0) return slot;
+    }
+}
+
+// 取名称在表 ns 中的编号；add 为真时未出现的名称分配新编号
+// 返回 -1 表示不在表中（add 为假），-2 表示表已满（使用溢出标签）
+static int scope_lookup(Tokenizer *tk, int ns, const char *s, size_t len, uint32_t h, bool add) {
+    TkScopeTable *t = &tk->scopes[ns];
+    TkScopeSlot *slot = scope_probe(tk, t, s, len, h);
+    if (slot->gen == t->gen) return (int)slot->id;
+    if (!add) return -1;
+    if (t->count >= TK_SCOPE_MAX_IDS) return -2;
+    slot->gen = t->gen;
+    slot->off = (uint32_t)(s - tk->source);
+    slot->len = (uint32_t)len;
+    slot->id = t->count++;
+    return (int)slot->id;
+}
+
+// 下一个非空白字符（不跨越注释，足以识别 "name (" 形式的调用与定义）
+static char next_nonspace(const Tokenizer *tk) {
+    for (const char *p = tk->current; p < tk->end; p++) {
+        if (!CC_IS(*p, CC_SPACE)) return *p;
+    }
+    return '\0';
+}
+
+// 作用域模式下标识符的归一化名：
+// - 顶层的形参表内：形参，记入局部表；
+// - 其后紧跟 '(' 的：函数名（定义或调用），记入函数表；
+// - 顶层其余的：文件作用域名称（全局变量、类型名等）；
+// - 函数体内：先查局部表，再查文件作用域表，都没有则作为新的局部名称。
+// 编号按作用域内首次出现的顺序分配，同一名称在作用域内编号不变，改名不影响结果
+static size_t scoped_label(Tokenizer *tk, char *buf, size_t cap, const char *s, size_t len) {
+    const uint32_t h = scope_hash(s, len);
+    int ns, id;
+    if (tk->brace_depth == 0 && tk->paren_depth > 0) {
+        ns = SCOPE_LOCAL;
+        id = scope_lookup(tk, ns, s, len, h, true);
+    } else if (next_nonspace(tk) == '(') {
+        ns = SCOPE_FUNC;
+        id = scope_lookup(tk, ns, s, len, h, true);
+    } else if (tk->brace_depth == 0) {
+        ns = SCOPE_FILE;
+        id = scope_lookup(tk, ns, s, len, h, true);
+    } else {
+        ns = SCOPE_LOCAL;
+        id = scope_lookup(tk, ns, s, len, h, false);
+        if (id == -1) {
+            const int g = scope_lookup(tk, SCOPE_FILE, s, len, h, false);
+            if (g >= 0) { ns = SCOPE_FILE; id = g; }
+            else id = scope_lookup(tk, ns, s, len, h, true);
+        }
+    }
+    const int n = id >= 0 ? snprintf(buf, cap, "%s%d", SCOPE_PREFIX[ns], id)
+                          : snprintf(buf, cap, "%s*", SCOPE_PREFIX[ns]);
+    return (size_t)n;
+}
+
+// 作用域模式下跟踪括号：顶层声明或函数体结束时清空局部表；
+// 函数名表与文件作用域表在整个文件内保留
+static void scope_punct(Tokenizer *tk, char c) {
+    switch (c) {
+        case '(':
+            tk->paren_depth++;
+            break;
+        case ')':
+            if (tk->paren_depth > 0) tk->paren_depth--;
+            break;
+        case ';':
+            if (tk->brace_depth == 0 && tk->paren_depth == 0) scope_clear(&tk->scopes[SCOPE_LOCAL]);
+            break;
+        case '{':
+            tk->brace_depth++;
+            break;
+        case '}':
+            if (tk->brace_depth > 0) tk->brace_depth--;
+            if (tk->brace_depth > 0) break;
+            scope_clear(&tk->scopes[SCOPE_LOCAL]);
+            tk->paren_depth = 0;
+            break;
+        default:
+            break;
+    }
+}
+
 // 读取标识符或关键字
-static Token* read_identifier(Tokenizer *tk) {
+static void read_identifier(Tokenizer *tk, Scan *sc) {
     int start_line = tk->line;
     int start_col = tk->col;
     const char *start = tk->current;
 
-    while (isalnum(*tk->current) || *tk->current == '_') {
+    while (CC_IS(ch_at(tk, 0), CC_ALPHA | CC_DIGIT)) {
         tk->current++;
         tk->col++;
     }
 
-    int len = tk->current - start;
-    char *word = (char*)malloc(len + 1);
-    strncpy(word, start, len);
-    word[len] = '\0';
+    size_t len = (size_t)(tk->current - start);
 
     // 检查是否是关键字
-    KeywordKind kw = check_keyword(word);
+    KeywordKind kw = check_keyword(start, len);
 
-    Token *tok;
     if (kw != KW_UNKNOWN) {
         // 关键字：归一化后也是关键字本身
-        tok = create_token(TK_KEYWORD, word, word, start_line, start_col);
-        tok->kw = kw;
+        set_scan(sc, TK_KEYWORD, start, len, start, len, start_line, start_col);
+        sc->kw = kw;
+    } else if (tk->ident_mode == TK_IDENT_SCOPED) {
+        // 标识符：按作用域归一化为 id_K / fn_K / gv_K
+        size_t n = scoped_label(tk, sc->buf, sizeof(sc->buf), start, len);
+        set_scan(sc, TK_IDENT, start, len, sc->buf, n, start_line, start_col);
     } else {
         // 标识符：归一化为 var_N
-        char normalized[32];
-        sprintf(normalized, "var_%d", tk->ident_counter++);
-        tok = create_token(TK_IDENT, word, normalized, start_line, start_col);
+        int n = snprintf(sc->buf, sizeof(sc->buf), "var_%d", tk->ident_counter++);
+        set_scan(sc, TK_IDENT, start, len, sc->buf, (size_t)n, start_line, start_col);
     }
-
-    free(word);
-    return tok;
 }
 
 // 读取数字
-static Token* read_number(Tokenizer *tk) {
+static void read_number(Tokenizer *tk, Scan *sc) {
     int start_line = tk->line;
     int start_col = tk->col;
     const char *start = tk->current;
 
     // 处理十六进制
-    if (tk->current[0] == '0' && (tk->current[1] == 'x' || tk->current[1] == 'X')) {
+    if (ch_at(tk, 0) == '0' && (ch_at(tk, 1) == 'x' || ch_at(tk, 1) == 'X')) {
         tk->current += 2;
         tk->col += 2;
-        while (isxdigit(*tk->current)) {
+        while (isxdigit((unsigned char)ch_at(tk, 0))) {
             tk->current++;
             tk->col++;
         }
     }
     // 处理十进制和浮点数
     else {
-        while (isdigit(*tk->current)) {
+        while (CC_IS(ch_at(tk, 0), CC_DIGIT)) {
             tk->current++;
             tk->col++;
         }
 
         // 浮点数
-        if (*tk->current == '.') {
+        if (ch_at(tk, 0) == '.') {
             tk->current++;
             tk->col++;
-            while (isdigit(*tk->current)) {
+            while (CC_IS(ch_at(tk, 0), CC_DIGIT)) {
                 tk->current++;
                 tk->col++;
             }
         }
 
         // 科学计数法
-        if (*tk->current == 'e' || *tk->current == 'E') {
+        if (ch_at(tk, 0) == 'e' || ch_at(tk, 0) == 'E') {
             tk->current++;
             tk->col++;
-            if (*tk->current == '+' || *tk->current == '-') {
+            if (ch_at(tk, 0) == '+' || ch_at(tk, 0) == '-') {
                 tk->current++;
                 tk->col++;
             }
-            while (isdigit(*tk->current)) {
+            while (CC_IS(ch_at(tk, 0), CC_DIGIT)) {
                 tk->current++;
                 tk->col++;
             }
@@ -168,26 +506,19 @@ static Token* read_number(Tokenizer *tk) {
     }
 
     // 后缀 (L, U, F等)
-    while (*tk->current == 'L' || *tk->current == 'l' ||
-           *tk->current == 'U' || *tk->current == 'u' ||
-           *tk->current == 'F' || *tk->current == 'f') {
+    while (ch_at(tk, 0) == 'L' || ch_at(tk, 0) == 'l' ||
+           ch_at(tk, 0) == 'U' || ch_at(tk, 0) == 'u' ||
+           ch_at(tk, 0) == 'F' || ch_at(tk, 0) == 'f') {
         tk->current++;
         tk->col++;
     }
 
-    int len = tk->current - start;
-    char *num = (char*)malloc(len + 1);
-    strncpy(num, start, len);
-    num[len] = '\0';
-
     // 数字归一化为 "NUM"
-    Token *tok = create_token(TK_NUMBER, num, "NUM", start_line, start_col);
-    free(num);
-    return tok;
+    set_scan(sc, TK_NUMBER, start, (size_t)(tk->current - start), "NUM", 3, start_line, start_col);
 }
 
 // 读取字符串
-static Token* read_string(Tokenizer *tk) {
+static void read_string(Tokenizer *tk, Scan *sc) {
     int start_line = tk->line;
     int start_col = tk->col;
     const char *start = tk->current;
@@ -195,16 +526,16 @@ static Token* read_string(Tokenizer *tk) {
     tk->current++; // 跳过开始的引号
     tk->col++;
 
-    while (*tk->current && *tk->current != '"') {
-        if (*tk->current == '\\') {
+    while (ch_at(tk, 0) && ch_at(tk, 0) != '"') {
+        if (ch_at(tk, 0) == '\\') {
             tk->current++;
             tk->col++;
-            if (*tk->current) {
+            if (ch_at(tk, 0)) {
                 tk->current++;
                 tk->col++;
             }
         } else {
-            if (*tk->current == '\n') {
+            if (ch_at(tk, 0) == '\n') {
                 tk->line++;
                 tk->col = 1;
             } else {
@@ -214,24 +545,17 @@ static Token* read_string(Tokenizer *tk) {
         }
     }
 
-    if (*tk->current == '"') {
+    if (ch_at(tk, 0) == '"') {
         tk->current++;
         tk->col++;
     }
 
-    int len = tk->current - start;
-    char *str = (char*)malloc(len + 1);
-    strncpy(str, start, len);
-    str[len] = '\0';
-
     // 字符串归一化为 "STR"
-    Token *tok = create_token(TK_STRING, str, "STR", start_line, start_col);
-    free(str);
-    return tok;
+    set_scan(sc, TK_STRING, start, (size_t)(tk->current - start), "STR", 3, start_line, start_col);
 }
 
 // 读取字符常量
-static Token* read_char(Tokenizer *tk) {
+static void read_char(Tokenizer *tk, Scan *sc) {
     int start_line = tk->line;
     int start_col = tk->col;
     const char *start = tk->current;
@@ -239,155 +563,218 @@ static Token* read_char(Tokenizer *tk) {
     tk->current++; // 跳过开始的单引号
     tk->col++;
 
-    if (*tk->current == '\\') {
+    if (ch_at(tk, 0) == '\\') {
         tk->current++;
         tk->col++;
     }
-    if (*tk->current) {
+    if (ch_at(tk, 0)) {
         tk->current++;
         tk->col++;
     }
 
-    if (*tk->current == '\'') {
+    if (ch_at(tk, 0) == '\'') {
         tk->current++;
         tk->col++;
     }
 
-    int len = tk->current - start;
-    char *ch = (char*)malloc(len + 1);
-    strncpy(ch, start, len);
-    ch[len] = '\0';
-
     // 字符归一化为 "CHAR"
-    Token *tok = create_token(TK_CHAR, ch, "CHAR", start_line, start_col);
-    free(ch);
-    return tok;
+    set_scan(sc, TK_CHAR, start, (size_t)(tk->current - start), "CHAR", 4, start_line, start_col);
 }
 
 // 读取运算符
-static Token* read_operator(Tokenizer *tk) {
+static void read_operator(Tokenizer *tk, Scan *sc) {
     int start_line = tk->line;
     int start_col = tk->col;
     const char *start = tk->current;
 
-    char c = *tk->current;
+    char c = ch_at(tk, 0);
     tk->current++;
     tk->col++;
 
     // 检查双字符运算符
-    if (c == '=' && *tk->current == '=') {
+    if (c == '=' && ch_at(tk, 0) == '=') {
         tk->current++; tk->col++;
-    } else if (c == '!' && *tk->current == '=') {
+    } else if (c == '!' && ch_at(tk, 0) == '=') {
         tk->current++; tk->col++;
-    } else if (c == '<' && *tk->current == '=') {
+    } else if (c == '<' && ch_at(tk, 0) == '=') {
         tk->current++; tk->col++;
-    } else if (c == '>' && *tk->current == '=') {
+    } else if (c == '>' && ch_at(tk, 0) == '=') {
         tk->current++; tk->col++;
-    } else if (c == '&' && *tk->current == '&') {
+    } else if (c == '&' && ch_at(tk, 0) == '&') {
         tk->current++; tk->col++;
-    } else if (c == '|' && *tk->current == '|') {
+    } else if (c == '|' && ch_at(tk, 0) == '|') {
         tk->current++; tk->col++;
-    } else if (c == '+' && *tk->current == '+') {
+    } else if (c == '+' && ch_at(tk, 0) == '+') {
         tk->current++; tk->col++;
-    } else if (c == '-' && *tk->current == '-') {
+    } else if (c == '-' && ch_at(tk, 0) == '-') {
         tk->current++; tk->col++;
-    } else if (c == '+' && *tk->current == '=') {
+    } else if (c == '+' && ch_at(tk, 0) == '=') {
         tk->current++; tk->col++;
-    } else if (c == '-' && *tk->current == '=') {
+    } else if (c == '-' && ch_at(tk, 0) == '=') {
         tk->current++; tk->col++;
-    } else if (c == '*' && *tk->current == '=') {
+    } else if (c == '*' && ch_at(tk, 0) == '=') {
         tk->current++; tk->col++;
-    } else if (c == '/' && *tk->current == '=') {
+    } else if (c == '/' && ch_at(tk, 0) == '=') {
         tk->current++; tk->col++;
-    } else if (c == '%' && *tk->current == '=') {
+    } else if (c == '%' && ch_at(tk, 0) == '=') {
         tk->current++; tk->col++;
-    } else if (c == '<' && *tk->current == '<') {
+    } else if (c == '<' && ch_at(tk, 0) == '<') {
         tk->current++; tk->col++;
-    } else if (c == '>' && *tk->current == '>') {
+    } else if (c == '>' && ch_at(tk, 0) == '>') {
         tk->current++; tk->col++;
-    } else if (c == '-' && *tk->current == '>') {
+    } else if (c == '-' && ch_at(tk, 0) == '>') {
         tk->current++; tk->col++;
     }
 
-    int len = tk->current - start;
-    char *op = (char*)malloc(len + 1);
-    strncpy(op, start, len);
-    op[len] = '\0';
-
     // 运算符归一化为自身
-    Token *tok = create_token(TK_OPERATOR, op, op, start_line, start_col);
-    free(op);
-    return tok;
+    size_t len = (size_t)(tk->current - start);
+    set_scan(sc, TK_OPERATOR, start, len, start, len, start_line, start_col);
 }
 
 // 读取标点符号
-static Token* read_punctuation(Tokenizer *tk) {
-    int start_line = tk->line;
-    int start_col = tk->col;
-    char punct[2] = {*tk->current, '\0'};
+static void read_punctuation(Tokenizer *tk, Scan *sc) {
+    const char *start = tk->current;
+
+    // 标点符号归一化为自身
+    set_scan(sc, TK_PUNCTUATION, start, 1, start, 1, tk->line, tk->col);
 
     tk->current++;
     tk->col++;
 
-    // 标点符号归一化为自身
-    return create_token(TK_PUNCTUATION, punct, punct, start_line, start_col);
+    if (tk->ident_mode == TK_IDENT_SCOPED) scope_punct(tk, *start);
 }
 
 // 初始化tokenizer
 void tokenizer_init(Tokenizer *tk, const char *source) {
+    tokenizer_init_n(tk, source, source ? strlen(source) : 0);
+}
+
+// 以 (指针, 长度) 初始化tokenizer：源码可以是只读映射，不要求以 '\0' 结尾
+void tokenizer_init_n(Tokenizer *tk, const char *source, size_t len) {
+    // 源码中间的 '\0' 视为结束（与按 C 字符串扫描的语义一致），扫描循环因此无需再检查 '\0'
+    const char *nul = (source && len) ? (const char*)memchr(source, '\0', len) : NULL;
     tk->source = source;
     tk->current = source;
+    tk->end = nul ? nul : source + len;
     tk->line = 1;
     tk->col = 1;
     tk->ident_counter = 0;
+    tk->ident_mode = TK_IDENT_SEQUENTIAL;
 }
 
-// 获取下一个token
-Token* tokenizer_next_token(Tokenizer *tk) {
-    skip_whitespace_and_comments(tk);
-
-    if (*tk->current == '\0') {
-        return create_token(TOKEN_EOF, "", "", tk->line, tk->col);
+// 设置标识符归一化方式；作用域模式下清空名称表与括号深度
+void tokenizer_set_ident_mode(Tokenizer *tk, IdentMode mode) {
+    tk->ident_mode = mode;
+    if (mode == TK_IDENT_SCOPED) {
+        tk->brace_depth = 0;
+        tk->paren_depth = 0;
+        memset(tk->scopes, 0, sizeof(tk->scopes));
+        for (int i = 0; i < 3; i++) tk->scopes[i].gen = 1;
     }
+}
 
-    // 标识符或关键字
-    if (isalpha(*tk->current) || *tk->current == '_') {
-        return read_identifier(tk);
-    }
+// 扫描下一个token（不分配内存）；未知字符直接跳过
+static void scan_next(Tokenizer *tk, Scan *sc) {
+    for (;;) {
+        skip_whitespace_and_comments(tk);
+        const unsigned char c = (unsigned char)ch_at(tk, 0);
 
-    // 数字
-    if (isdigit(*tk->current)) {
-        return read_number(tk);
-    }
+        if (c == '\0') {
+            set_scan(sc, TOKEN_EOF, tk->current, 0, "", 0, tk->line, tk->col);
+            return;
+        }
 
-    // 字符串
-    if (*tk->current == '"') {
-        return read_string(tk);
-    }
+        // 标识符或关键字
+        if (CC_IS(c, CC_ALPHA)) {
+            read_identifier(tk, sc);
+            return;
+        }
 
-    // 字符常量
-    if (*tk->current == '\'') {
-        return read_char(tk);
-    }
+        // 数字
+        if (CC_IS(c, CC_DIGIT)) {
+            read_number(tk, sc);
+            return;
+        }
 
-    // 运算符
-    if (strchr("+-*/%=!<>&|^~", *tk->current)) {
-        return read_operator(tk);
-    }
+        // 字符串
+        if (c == '"') {
+            read_string(tk, sc);
+            return;
+        }
 
-    // 标点符号
-    if (strchr("(){}[];,.", *tk->current)) {
-        return read_punctuation(tk);
+        // 字符常量
+        if (c == '\'') {
+            read_char(tk, sc);
+            return;
+        }
+
+        // 运算符
+        if (CC_IS(c, CC_OP)) {
+            read_operator(tk, sc);
+            return;
+        }
+
+        // 标点符号
+        if (CC_IS(c, CC_PUNC)) {
+            read_punctuation(tk, sc);
+            return;
+        }
+
+        // 未知字符，跳过
+        tk->current++;
+        tk->col++;
     }
+}
 
-    // 未知字符，跳过
-    tk->current++;
-    tk->col++;
-    return tokenizer_next_token(tk);
+// 获取下一个token
+Token* tokenizer_next_token(Tokenizer *tk) {
+    Scan sc;
+    scan_next(tk, &sc);
+    return create_token(&sc);
+}
+
+// 获取下一个紧凑token：lex 驻留到 lexes，原始文本以偏移/长度引用源码
+bool tokenizer_next_ref(Tokenizer *tk, SymTab *lexes, TokenRef *out) {
+    Scan sc;
+    scan_next(tk, &sc);
+
+    out->type = sc.type;
+    out->kw = sc.kw;
+    out->offset = (uint32_t)(sc.raw - tk->source);
+    out->length = (uint32_t)sc.raw_len;
+    out->line = sc.line;
+    out->col = sc.col;
+    return symtab_intern_n(lexes, sc.lex, sc.lex_len, &out->lex);
+}
+
+// 将整段源码切分为连续的紧凑token数组（不含 EOF）
+bool tokenize_to_array(const char *source, SymTab *lexes, TokenArray *out) {
+    return tokenize_to_array_n(source, source ? strlen(source) : 0, lexes, out);
+}
+
+// 同 tokenize_to_array，源码以 (指针, 长度) 给出
+bool tokenize_to_array_n(const char *source, size_t len, SymTab *lexes, TokenArray *out) {
+    Tokenizer tk;
+    tokenizer_init_n(&tk, source, len);
+    token_array_init(out, source, lexes);
+
+    TokenRef tok;
+    for (;;) {
+        if (!tokenizer_next_ref(&tk, lexes, &tok)) {
+            token_array_free(out);
+            return false;
+        }
+        if (tok.type == TOKEN_EOF) break;
+        if (!token_array_push(out, &tok)) {
+            token_array_free(out);
+            return false;
+        }
+    }
+    return true;
 }
 
 // 检查是否到达文件末尾
 bool tokenizer_is_eof(Tokenizer *tk) {
     skip_whitespace_and_comments(tk);
-    return *tk->current == '\0';
+    return ch_at(tk, 0) == '\0';
 }
@@ -0,0 +1,384 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../include/edit_distance.c.h"
+#include "../include/symtab.h"
+#include "../include/edit_cost.h"
+#include "../include/edit_align.h"
+
+// 简单可复现的伪随机数（LCG），避免依赖 rand() 的实现差异
+static unsigned long long rng_state = 20240601ull;
+static unsigned next_rand(void) {
+    rng_state = rng_state * 6364136223846793005ull + 1442695040888963407ull;
+    return (unsigned)(rng_state >> 33);
+}
+
+// 生成长度为 len、字母表大小为 alpha 的随机符号序列
+static void random_seq(SymVec* v, size_t len, unsigned alpha) {
+    symv_init(v);
+    for (size_t i = 0; i < len; ++i) symv_push(v, next_rand() % alpha);
+}
+
+// 在 src 基础上做 edits 次随机编辑，模拟“抄袭后小改”
+static void mutate_seq(SymVec* dst, const SymVec* src, size_t edits, unsigned alpha) {
+    symv_init(dst);
+    for (size_t i = 0; i < src->size; ++i) symv_push(dst, src->data[i]);
+    for (size_t e = 0; e < edits && dst->size > 0; ++e) {
+        size_t pos = next_rand() % dst->size;
+        dst->data[pos] = next_rand() % alpha;
+    }
+}
+
+// 加权距离用的符号表：全部 ASTKind 的进出标签与各类叶子标签
+static void weighted_symtab(SymTab* syms) {
+    static const char* const leaves[] = {
+        "var_0", "var_1", "var_2", "id_0", "fn_0", "gv_0", "NUM", "STR", "CHR", "IF", "FOR", "KW",
+        "+", "-", "(", ";"
+    };
+    symtab_init(syms);
+    char buf[64];
+    SymId id;
+    for (int k = 0; k < AST_KIND_COUNT; ++k) {
+        snprintf(buf, sizeof(buf), "<%s>", ast_kind_name((ASTKind)k));
+        symtab_intern(syms, buf, &id);
+        snprintf(buf, sizeof(buf), "</%s>", ast_kind_name((ASTKind)k));
+        symtab_intern(syms, buf, &id);
+    }
+    for (size_t i = 0; i < sizeof(leaves) / sizeof(leaves[0]); ++i) symtab_intern(syms, leaves[i], &id);
+}
+
+// 写出代价文件并读入到 m（在 m 原有内容的基础上）
+static bool load_rules(EditCostModel* m, const char* text) {
+    const char* path = "edit_cost_test.costs";
+    FILE* fp = fopen(path, "w");
+    if (!fp) return false;
+    fputs(text, fp);
+    fclose(fp);
+    const bool ok = edit_cost_load(m, path);
+    remove(path);
+    return ok;
+}
+
+// 向量内核、强制标量的反对角线内核与逐行参考实现三者一致；返回失败数
+static int check_weighted(const char* name, EditCosts* t, const SymVec* a, const SymVec* b) {
+    const bool simd = t->simd;
+    const size_t want = edit_distance_weighted_dp(t, a, b);
+    const size_t got = edit_distance_weighted(t, a, b);
+    t->simd = false;
+    const size_t scalar = edit_distance_weighted(t, a, b);
+    t->simd = simd;
+    if (got != want || scalar != want) {
+        printf("[FAIL] weighted %s n=%zu m=%zu: dp=%zu diag=%zu scalar=%zu\n",
+               name, a->size, b->size, want, got, scalar);
+        return 1;
+    }
+    return 0;
+}
+
+// 编辑脚本的合法性：各段首尾相接覆盖两条序列，EQUAL 段相同、SUBST 段逐个不同，总代价等于编辑距离
+static int check_script(const SymVec* a, const SymVec* b) {
+    EditScript sc;
+    edit_script_init(&sc);
+    if (!edit_align(a, b, &sc)) {
+        printf("[FAIL] edit_align n=%zu m=%zu: out of memory\n", a->size, b->size);
+        edit_script_free(&sc);
+        return 1;
+    }
+
+    const char* err = NULL;
+    size_t ia = 0, ib = 0, cost = 0;
+    for (size_t r = 0; r < sc.size && !err; ++r) {
+        const EditRun* run = &sc.data[r];
+        if (run->a_begin != ia || run->b_begin != ib) err = "runs not contiguous";
+        else if (run->a_len == 0 && run->b_len == 0) err = "empty run";
+        else if (r > 0 && sc.data[r - 1].op == run->op) err = "adjacent runs not merged";
+        else if (run->a_begin + run->a_len > a->size || run->b_begin + run->b_len > b->size) err = "run out of range";
+        else if (run->op == EDIT_EQUAL || run->op == EDIT_SUBST) {
+            if (run->a_len != run->b_len) err = "EQUAL/SUBST lengths differ";
+            for (size_t k = 0; k < run->a_len && !err; ++k) {
+                const bool same = a->data[run->a_begin + k] == b->data[run->b_begin + k];
+                if (run->op == EDIT_EQUAL && !same) err = "EQUAL run differs";
+                if (run->op == EDIT_SUBST && same) err = "SUBST run has equal symbols";
+            }
+            if (run->op == EDIT_SUBST) cost += run->a_len;
+        } else if (run->op == EDIT_INSERT) {
+            if (run->a_len != 0) err = "INSERT consumes A";
+            cost += run->b_len;
+        } else {
+            if (run->b_len != 0) err = "DELETE consumes B";
+            cost += run->a_len;
+        }
+        ia += run->a_len;
+        ib += run->b_len;
+    }
+    const size_t want = levenshtein_symvec(a, b);
+    if (!err && (ia != a->size || ib != b->size)) err = "runs do not cover both sequences";
+    if (!err && cost != sc.dist) err = "script cost differs from dist";
+    if (!err && sc.dist != want) err = "dist differs from levenshtein_symvec";
+    if (err) printf("[FAIL] edit_align n=%zu m=%zu: %s (dist=%zu cost=%zu want=%zu)\n",
+                    a->size, b->size, err, sc.dist, cost, want);
+    edit_script_free(&sc);
+    return err ? 1 : 0;
+}
+
+// 整列 DP：col[i] 与对 pat 的前 i 个（reverse 时为后 i 个）符号单独计算的距离一致
+static int check_column(const SymVec* text, const SymVec* pat) {
+    size_t* col = (size_t*)malloc((pat->size + 1) * sizeof(size_t));
+    int bad = 0;
+    for (int rev = 0; rev < 2 && col; ++rev) {
+        if (!levenshtein_column_myers(text->data, text->size, pat->data, pat->size, rev != 0, col)) {
+            printf("[FAIL] column n=%zu m=%zu: out of memory\n", text->size, pat->size);
+            bad = 1;
+            break;
+        }
+        for (size_t i = 0; i <= pat->size; ++i) {
+            const SymVec part = { pat->data + (rev ? pat->size - i : 0), i, i };
+            const size_t want = levenshtein_symvec(text, &part);
+            if (col[i] != want) {
+                printf("[FAIL] column n=%zu m=%zu reverse=%d i=%zu: got=%zu want=%zu\n",
+                       text->size, pat->size, rev, i, col[i], want);
+                bad = 1;
+                break;
+            }
+        }
+    }
+    free(col);
+    return bad;
+}
+
+int main(void) {
+    int failures = 0;
+    const size_t lens[] = { 0, 1, 2, 63, 64, 65, 127, 128, 129, 300, 1000 };
+    const unsigned alphas[] = { 2, 4, 40, 100000 };
+    const size_t nl = sizeof(lens) / sizeof(lens[0]);
+    const size_t na = sizeof(alphas) / sizeof(alphas[0]);
+
+    // 1) 随机序列：位并行引擎必须与经典 DP 完全一致
+    for (size_t ai = 0; ai < na; ++ai) {
+        for (size_t i = 0; i < nl; ++i) {
+            for (size_t j = 0; j < nl; ++j) {
+                SymVec a, b;
+                random_seq(&a, lens[i], alphas[ai]);
+                random_seq(&b, lens[j], alphas[ai]);
+
+                size_t d0 = levenshtein_symvec(&a, &b);
+                size_t d1 = levenshtein_symvec_myers(&a, &b);
+                if (d0 != d1) {
+                    printf("[FAIL] random n=%zu m=%zu alpha=%u: dp=%zu bitpar=%zu\n",
+                           a.size, b.size, alphas[ai], d0, d1);
+                    failures++;
+                }
+                symv_free(&a);
+                symv_free(&b);
+            }
+        }
+    }
+
+    // 2) 相近序列（距离较小的典型查重场景）
+    for (size_t i = 0; i < nl; ++i) {
+        SymVec a, b;
+        random_seq(&a, lens[i], 30);
+        mutate_seq(&b, &a, lens[i] / 10 + 1, 30);
+
+        size_t d0 = levenshtein_symvec(&a, &b);
+        size_t d1 = levenshtein_symvec_myers(&a, &b);
+        if (d0 != d1) {
+            printf("[FAIL] mutated n=%zu: dp=%zu bitpar=%zu\n", a.size, d0, d1);
+            failures++;
+        }
+        symv_free(&a);
+        symv_free(&b);
+    }
+
+    // 3) 带上界版本：距离 <= k 时返回精确值，否则返回 k + 1
+    for (size_t i = 0; i < nl; ++i) {
+        for (size_t j = 0; j < nl; ++j) {
+            SymVec a, b;
+            random_seq(&a, lens[i], 6);
+            if (j % 2) mutate_seq(&b, &a, lens[j] / 8 + 1, 6);
+            else random_seq(&b, lens[j], 6);
+
+            size_t exact = levenshtein_symvec(&a, &b);
+            const size_t ks[] = { 0, 1, 3, exact / 2, exact, exact + 1, exact + 7 };
+            for (size_t t = 0; t < sizeof(ks) / sizeof(ks[0]); ++t) {
+                size_t k = ks[t];
+                size_t got = levenshtein_symvec_bounded(&a, &b, k);
+                size_t want = exact <= k ? exact : k + 1;
+                if (got != want) {
+                    printf("[FAIL] bounded n=%zu m=%zu k=%zu: got=%zu want=%zu\n",
+                           a.size, b.size, k, got, want);
+                    failures++;
+                }
+            }
+            symv_free(&a);
+            symv_free(&b);
+        }
+    }
+    if (max_dist_for_similarity(0.6, 100, 80) != 40 || max_dist_for_similarity(0.9, 10, 3) != 1) {
+        printf("[FAIL] max_dist_for_similarity\n");
+        failures++;
+    }
+
+    // 4) 已知结果
+    {
+        SymVec a, b;
+        symv_init(&a);
+        symv_init(&b);
+        const SymId ka[] = { 1, 2, 3, 4, 5, 6 };       // "kitten" 式的小例子
+        const SymId kb[] = { 7, 2, 3, 4, 8, 6, 9 };
+        for (size_t i = 0; i < 6; ++i) symv_push(&a, ka[i]);
+        for (size_t i = 0; i < 7; ++i) symv_push(&b, kb[i]);
+        if (edit_distance_symvec(&a, &b, ED_ENGINE_DP) != 3 ||
+            edit_distance_symvec(&a, &b, ED_ENGINE_BITPAR) != 3) {
+            printf("[FAIL] known distance\n");
+            failures++;
+        }
+        symv_free(&a);
+        symv_free(&b);
+    }
+
+    // 5) 分块波前：规模超过串行阈值（WF_MIN_WORK 个字运算）才进入分块路径，
+    //    序列长度覆盖横带（1024 行）、位并行字（64 行）与列块（4096 列）恰好整除与不整除的情形
+    {
+        struct { size_t n, m; unsigned alpha; int mutated; } wf[] = {
+            { 249873, 1025, 4, 0 },         // 第二条横带只有 1 个字，最后一个字只有 1 行
+            { 135167, 2111, 40, 0 },        // 最后一个字 63 行，最后一个列块 4095 列
+            { 20000, 20000, 30, 1 },        // 相近序列，横带、字与列块都不整除
+            { 16384, 16384, 4, 0 },         // 全部恰好整除
+        };
+        const int jobs[] = { 1, 2, 4 };
+        for (size_t i = 0; i < sizeof(wf) / sizeof(wf[0]); ++i) {
+            SymVec a, b;
+            random_seq(&a, wf[i].n, wf[i].alpha);
+            if (wf[i].mutated) mutate_seq(&b, &a, wf[i].n / 20, wf[i].alpha);
+            else random_seq(&b, wf[i].m, wf[i].alpha);
+
+            const size_t want = levenshtein_symvec_myers(&a, &b);
+            for (size_t j = 0; j < sizeof(jobs) / sizeof(jobs[0]); ++j) {
+                const size_t ab = levenshtein_symvec_wavefront(&a, &b, jobs[j]);
+                const size_t ba = levenshtein_symvec_wavefront(&b, &a, jobs[j]);
+                if (ab != want || ba != want) {
+                    printf("[FAIL] wavefront n=%zu m=%zu jobs=%d: bitpar=%zu wavefront=%zu/%zu\n",
+                           a.size, b.size, jobs[j], want, ab, ba);
+                    failures++;
+                }
+            }
+            symv_free(&a);
+            symv_free(&b);
+        }
+    }
+
+    // 6) 编辑脚本：较大的输入越过 ALIGN_BASE_CELLS，经 Hirschberg 分治多层递归
+    {
+        const size_t an[] = { 0, 1, 5, 64, 65, 130, 300, 1000, 3000 };
+        const size_t nn = sizeof(an) / sizeof(an[0]);
+        for (size_t i = 0; i < nn; ++i) {
+            for (size_t j = 0; j < nn; ++j) {
+                if (an[i] * an[j] > 1000000) continue;
+                SymVec a, b;
+                random_seq(&a, an[i], j % 2 ? 4 : 40);
+                if (i == j) mutate_seq(&b, &a, an[i] / 10 + 1, 4);
+                else random_seq(&b, an[j], j % 2 ? 4 : 40);
+                failures += check_script(&a, &b);
+                symv_free(&a);
+                symv_free(&b);
+            }
+        }
+        // 每层分治的中间列来自 levenshtein_column_myers（正序与倒序）
+        const size_t cn[] = { 0, 1, 63, 64, 65, 200 };
+        const size_t nc = sizeof(cn) / sizeof(cn[0]);
+        for (size_t i = 0; i < nc; ++i) {
+            for (size_t j = 0; j < nc; ++j) {
+                SymVec t, p;
+                random_seq(&t, cn[i], 5);
+                random_seq(&p, cn[j], 5);
+                failures += check_column(&t, &p);
+                symv_free(&t);
+                symv_free(&p);
+            }
+        }
+    }
+
+    // 7) 加权编辑距离：反对角线内核（含标量回退）与逐行 DP 一致，长度覆盖非 8 的倍数
+    {
+        SymTab syms;
+        weighted_symtab(&syms);
+        const unsigned nsym = (unsigned)symtab_size(&syms);
+
+        EditCostModel kind, file, unit;
+        edit_cost_kind_preset(&kind);
+        edit_cost_uniform(&file, 2, 2);
+        edit_cost_uniform(&unit, 2, 2);
+        if (!load_rules(&file, "# 测试用代价\n"
+                               "default 3 2\n"
+                               "sub FOR WHILE 1   # 循环互换\n"
+                               "sub /* /* 0\n"
+                               "indel /* 0\n"
+                               "indel @OP 1\n"
+                               "sub @ID @NUM 5\n"
+                               "sub * @KW 63\n") ||
+            !load_rules(&unit, "default 1 1\n")) {
+            printf("[FAIL] edit_cost_load: valid rules rejected\n");
+            failures++;
+        }
+
+        EditCosts tk, tf, tu;
+        if (!edit_costs_bind(&tk, &kind, &syms) || !edit_costs_bind(&tf, &file, &syms) ||
+            !edit_costs_bind(&tu, &unit, &syms)) {
+            printf("[FAIL] edit_costs_bind\n");
+            return 1;
+        }
+
+        const size_t wlens[] = { 0, 1, 2, 7, 8, 9, 15, 16, 17, 33, 100, 257, 1001 };
+        const size_t nw = sizeof(wlens) / sizeof(wlens[0]);
+        for (size_t i = 0; i < nw; ++i) {
+            for (size_t j = 0; j < nw; ++j) {
+                SymVec a, b;
+                random_seq(&a, wlens[i], nsym);
+                if (j % 3 == 0) mutate_seq(&b, &a, wlens[i] / 6 + 1, nsym);
+                else random_seq(&b, wlens[j], nsym);
+
+                failures += check_weighted("kind", &tk, &a, &b);
+                failures += check_weighted("file", &tf, &a, &b);
+                failures += check_weighted("unit", &tu, &a, &b);
+
+                // 全部代价为 1 时即普通编辑距离，相似度也与 similarity_from_dist 相同
+                const size_t lev = levenshtein_symvec(&a, &b);
+                const size_t wd = edit_distance_weighted(&tu, &a, &b);
+                if (wd != lev ||
+                    similarity_weighted(&tu, wd, &a, &b) != similarity_from_dist(lev, a.size, b.size)) {
+                    printf("[FAIL] weighted default 1 1 n=%zu m=%zu: weighted=%zu levenshtein=%zu\n",
+                           a.size, b.size, wd, lev);
+                    failures++;
+                }
+                symv_free(&a);
+                symv_free(&b);
+            }
+        }
+        edit_costs_free(&tk);
+        edit_costs_free(&tf);
+        edit_costs_free(&tu);
+        symtab_free(&syms);
+
+        // 格式错误的规则必须被拒绝
+        const char* const bad[] = {
+            "sub FOR WHILE\n", "indel @FOO 1\n", "default 1\n", "sub FOR WHILE 64\n",
+            "indel FOR -1\n", "sub NOKIND FOR 1\n", "cost FOR 1\n", "default 1 1 1\n", "indel FOR 1x\n"
+        };
+        for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); ++i) {
+            EditCostModel m;
+            edit_cost_uniform(&m, 2, 2);
+            if (load_rules(&m, bad[i])) {
+                printf("[FAIL] edit_cost_load accepted: %s", bad[i]);
+                failures++;
+            }
+        }
+    }
+
+    if (failures) {
+        printf("%d case(s) failed\n", failures);
+        return 1;
+    }
+    printf("edit distance engines: all cases passed\n");
+    return 0;
+}
@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/pipeline.h"
+#include "../include/seqcache.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+// 增量前端与并行前端必须与整文件前端 pipeline_build_symbols 逐符号一致：
+// 片段缓存（.frag）与切块拼接的正确性都依赖这一点
+
+// 缓存目录由 CMake 指定在构建目录下；测试开始前与结束后都清空
+#ifndef PIPELINE_TEST_CACHE
+#define PIPELINE_TEST_CACHE "pipeline_test.cache"
+#endif
+
+// 删除目录中的全部文件（缓存目录没有子目录）与目录本身；返回删除的文件数
+static size_t wipe_dir(const char* dir) {
+    char path[1024];
+    size_t n = 0;
+#ifdef _WIN32
+    WIN32_FIND_DATAA fd;
+    snprintf(path, sizeof(path), "%s\\*", dir);
+    HANDLE h = FindFirstFileA(path, &fd);
+    if (h != INVALID_HANDLE_VALUE) {
+        do {
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) continue;
+            snprintf(path, sizeof(path), "%s\\%s", dir, fd.cFileName);
+            if (DeleteFileA(path)) n++;
+        } while (FindNextFileA(h, &fd));
+        FindClose(h);
+    }
+    RemoveDirectoryA(dir);
+#else
+    DIR* d = opendir(dir);
+    if (d) {
+        for (struct dirent* e = readdir(d); e; e = readdir(d)) {
+            if (strcmp(e->d_name, ".") == 0 || strcmp(e->d_name, "..") == 0) continue;
+            snprintf(path, sizeof(path), "%s/%s", dir, e->d_name);
+            if (remove(path) == 0) n++;
+        }
+        closedir(d);
+    }
+    rmdir(dir);
+#endif
+    return n;
+}
+
+// 可增长的源码缓冲
+typedef struct {
+    char*  data;
+    size_t len, cap;
+} Text;
+
+static void text_add(Text* t, const char* s) {
+    const size_t n = strlen(s);
+    if (t->len + n + 1 > t->cap) {
+        size_t cap = t->cap ? t->cap : 4096;
+        while (t->len + n + 1 > cap) cap *= 2;
+        char* p = (char*)realloc(t->data, cap);
+        if (!p) { fprintf(stderr, "out of memory\n"); exit(2); }
+        t->data = p;
+        t->cap = cap;
+    }
+    memcpy(t->data + t->len, s, n + 1);
+    t->len += n;
+}
+
+// 把 LF 换成 CRLF
+static void text_crlf(Text* dst, const char* src) {
+    char one[2] = { 0, 0 };
+    for (const char* p = src; *p; p++) {
+        if (*p == '\n') text_add(dst, "\r");
+        one[0] = *p;
+        text_add(dst, one);
+    }
+}
+
+// 生成 nfunc 个函数：字符串、字符常量与注释中带 '}'，花括号后不换行的结构体，
+// 以及全局变量（作用域模式下跨函数编号）；edit 指定的函数体被改写
+static void gen_source(Text* t, int nfunc, int edit) {
+    char buf[512];
+    for (int i = 0; i < nfunc; i++) {
+        snprintf(buf, sizeof(buf),
+                 "int g%d;\n"
+                 "struct S%d { int a; } s%d;\n"
+                 "int f%d(int x) {\n"
+                 "    const char* s = \"}\\n{\";   // }\n"
+                 "    /* }\n"
+                 "}\n"
+                 "    */\n"
+                 "    char c = '}';\n"
+                 "    if (x > %d) { return x - g%d; }\n"
+                 "    while (x < %d) { x = x + c; }\n"
+                 "    return x + g%d%s;\n"
+                 "}\n",
+                 i, i, i, i, i, i, i * 3, i / 2, i == edit ? " * 2 + f0(x)" : "");
+        text_add(t, buf);
+    }
+}
+
+// 以同一张符号表比较：相同名称的符号 ID 相同
+static int compare(const char* name, bool ok_ref, const SymVec* ref, bool ok, const SymVec* got) {
+    if (ok != ok_ref || (ok && (got->size != ref->size ||
+                                memcmp(got->data, ref->data, ref->size * sizeof(SymId)) != 0))) {
+        size_t k = 0;
+        while (ok && ok_ref && k < ref->size && k < got->size && got->data[k] == ref->data[k]) k++;
+        printf("[FAIL] %s: ok=%d/%d size=%zu/%zu first difference at %zu\n",
+               name, ok_ref, ok, ref->size, got->size, k);
+        return 1;
+    }
+    return 0;
+}
+
+// 一份源码：增量前端（无缓存、写缓存、读缓存）与并行前端都与整文件前端一致
+static int check_source(const char* name, const char* src, size_t len, SeqCache* cache, bool parallel) {
+    int failures = 0;
+    char label[160];
+    SymTab syms;
+    SymVec ref, got;
+    symtab_init(&syms);
+    symv_init(&ref);
+    symv_init(&got);
+
+    const bool ok_ref = pipeline_build_symbols(src, len, &syms, &ref, NULL);
+
+    const char* const runs[] = { "incremental", "incremental+cache", "incremental+cache(reuse)" };
+    for (int r = 0; r < 3; r++) {
+        got.size = 0;
+        size_t lexed = 0;
+        const bool ok = pipeline_build_incremental(r ? cache : NULL, src, len, &syms, &got, &lexed);
+        snprintf(label, sizeof(label), "%s [%s, %s]", name, runs[r],
+                 pipeline_ident_mode() == TK_IDENT_SCOPED ? "scoped" : "sequential");
+        failures += compare(label, ok_ref, &ref, ok, &got);
+        // 第二次带缓存的运行：全部片段都应命中，不再做词法分析（作用域模式不做片段复用）
+        if (r == 2 && ok_ref && lexed != 0 && pipeline_ident_mode() != TK_IDENT_SCOPED) {
+            printf("[FAIL] %s: %zu token(s) re-lexed, fragments were not reused\n", label, lexed);
+            failures++;
+        }
+    }
+
+    const int jobs[] = { 1, 3 };
+    for (size_t j = 0; parallel && j < sizeof(jobs) / sizeof(jobs[0]); j++) {
+        got.size = 0;
+        const bool ok = pipeline_build_parallel(src, len, &syms, &got, NULL, jobs[j]);
+        snprintf(label, sizeof(label), "%s [parallel jobs=%d, %s]", name, jobs[j],
+                 pipeline_ident_mode() == TK_IDENT_SCOPED ? "scoped" : "sequential");
+        failures += compare(label, ok_ref, &ref, ok, &got);
+    }
+
+    symv_free(&ref);
+    symv_free(&got);
+    symtab_free(&syms);
+    if (!failures) printf("[PASS] %s (%s)\n", name,
+                          pipeline_ident_mode() == TK_IDENT_SCOPED ? "scoped" : "sequential");
+    return failures;
+}
+
+int main(void) {
+    wipe_dir(PIPELINE_TEST_CACHE);      // 上次运行残留的片段会让“写入 / 复用”检查失去意义
+    SeqCache cache;
+    if (!seqcache_open(&cache, PIPELINE_TEST_CACHE)) {
+        printf("[FAIL] cannot open cache directory %s\n", PIPELINE_TEST_CACHE);
+        return 1;
+    }
+
+    // 边界用例：单独一份，以及重复到跨多个缓存片段（边界构造落在片段交界处）
+    const struct { const char* name; const char* src; } small[] = {
+        { "basic",
+          "int a;\nint f(int x) {\n    return x + a;\n}\nint g(void) {\n    return f(1);\n}\n" },
+        { "stray top-level '}'",
+          "int a;\n}\nint f(void) { return a; }\n}\nint g(void) { return 2; }\n" },
+        { "'}' in strings and comments",
+          "char* s = \"}\\n\";\n/* }\n}\n */\n// }\nint f(void) {\n    return '}';\n}\n" },
+        { "CRLF",
+          "int a;\r\nint f(int x) {\r\n    return x;\r\n}\r\nint g(int y) {\r\n    return y + a;\r\n}  \r\n" },
+        { "no trailing newline",
+          "int a;\nint f(int x) {\n    return x;\n}\nint g(int y) {\n    return a - y;\n}" },
+        { "comment only", "// nothing here\n/* } */\n" },
+        { "empty", "" },
+    };
+
+    // 较大的输入：跨多个缓存片段，并有一个函数被修改（其余片段直接复用）
+    Text v1 = { 0 }, v2 = { 0 }, crlf = { 0 }, big = { 0 }, big_crlf = { 0 };
+    gen_source(&v1, 300, -1);
+    gen_source(&v2, 300, 150);
+    text_crlf(&crlf, v2.data);
+    size_t nbig = 0;
+    while (big.len < PIPELINE_SPLIT_MIN + PIPELINE_SPLIT_CHUNK) gen_source(&big, 1000, (int)nbig++);
+    text_add(&big, "int tail(void) { return 0; }");     // 无结尾换行
+    text_crlf(&big_crlf, big.data);
+
+    int failures = 0;
+    const IdentMode modes[] = { TK_IDENT_SEQUENTIAL, TK_IDENT_SCOPED };
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        pipeline_set_ident_mode(modes[m]);
+        for (size_t i = 0; i < sizeof(small) / sizeof(small[0]); i++) {
+            failures += check_source(small[i].name, small[i].src, strlen(small[i].src), &cache, true);
+            // 各份之间插入不同的声明，使区域哈希不同、片段边界分散；最后一份保持原样结尾
+            Text rep = { 0 };
+            text_add(&rep, "");
+            for (int k = 0; *small[i].src && rep.len < 65536; k++) {
+                char pad[32];
+                snprintf(pad, sizeof(pad), "\nint pad%d;\n", k);
+                text_add(&rep, small[i].src);
+                text_add(&rep, pad);
+            }
+            text_add(&rep, small[i].src);
+            char name[96];
+            snprintf(name, sizeof(name), "%s, repeated", small[i].name);
+            failures += check_source(name, rep.data, rep.len, &cache, true);
+            free(rep.data);
+        }
+        failures += check_source("many functions", v1.data, v1.len, &cache, false);
+        failures += check_source("many functions, one edited", v2.data, v2.len, &cache, false);
+        failures += check_source("many functions, CRLF", crlf.data, crlf.len, &cache, false);
+        failures += check_source(">= PIPELINE_SPLIT_MIN", big.data, big.len, &cache, true);
+        failures += check_source(">= PIPELINE_SPLIT_MIN, CRLF", big_crlf.data, big_crlf.len, &cache, true);
+    }
+    pipeline_set_ident_mode(TK_IDENT_SEQUENTIAL);
+
+    free(v1.data);
+    free(v2.data);
+    free(crlf.data);
+    free(big.data);
+    free(big_crlf.data);
+    seqcache_close(&cache);
+    if (wipe_dir(PIPELINE_TEST_CACHE) == 0) {
+        printf("[FAIL] no fragment was written to %s\n", PIPELINE_TEST_CACHE);
+        failures++;
+    }
+
+    if (failures) {
+        printf("%d case(s) failed\n", failures);
+        return 1;
+    }
+    printf("pipeline front ends: all cases passed\n");
+    return 0;
+}
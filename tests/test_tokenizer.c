@@ -1,6 +1,35 @@
 #include <stdio.h>
+#include <string.h>
 #include "tokenizer.h"
 
+// 作用域模式：依次取出全部标识符的归一化名，与 want（空格分隔）比较
+static int check_scoped(const char *name, const char *source, const char *want) {
+    Tokenizer tk;
+    tokenizer_init(&tk, source);
+    tokenizer_set_ident_mode(&tk, TK_IDENT_SCOPED);
+
+    char got[512] = "";
+    size_t n = 0;
+    while (!tokenizer_is_eof(&tk)) {
+        Token *token = tokenizer_next_token(&tk);
+        if (!token || token->type == TOKEN_EOF) {
+            if (token) token_free(token);
+            break;
+        }
+        if (token->type == TK_IDENT && n + strlen(token->lex) + 2 < sizeof(got)) {
+            n += (size_t)snprintf(got + n, sizeof(got) - n, "%s%s", n ? " " : "", token->lex);
+        }
+        token_free(token);
+    }
+
+    if (strcmp(got, want) != 0) {
+        printf("[FAIL] %s\n  got:  %s\n  want: %s\n", name, got, want);
+        return 1;
+    }
+    printf("[PASS] %s\n", name);
+    return 0;
+}
+
 // 打印token类型名称
 const char* token_type_name(TokenType type) {
     switch (type) {
@@ -101,5 +130,23 @@ int main() {
         token_free(token);
     }
 
-    return 0;
+    printf("\n");
+
+    // 测试用例4: 作用域模式下全局变量与函数名的编号跨函数保持不变
+    int failures = 0;
+    const char *want4 = "gv_0 gv_1 fn_0 id_0 gv_0 gv_0 id_0 fn_1 id_0 gv_1 gv_0 id_0";
+    failures += check_scoped("scoped: globals across functions",
+                             "int count; int total; void f(int x){ count = count + x; }\n"
+                             "void g(int y){ total = count - y; }", want4);
+    // 与 '}' 之后是否换行无关
+    failures += check_scoped("scoped: '}' not at line end",
+                             "int count; int total; void f(int x){ count = count + x; } "
+                             "void g(int y){ total = count - y; }\n", want4);
+    // 局部名在每个函数内重新编号，且不会被当作全局变量
+    failures += check_scoped("scoped: locals reset per function",
+                             "int g0;\nint f(int a){ int t = a; return t + g0; }\n"
+                             "int h(int b){ int u = b; return u; }\n",
+                             "gv_0 fn_0 id_0 id_1 id_0 id_1 gv_0 fn_1 id_0 id_1 id_0 id_1");
+
+    return failures ? 1 : 0;
 }